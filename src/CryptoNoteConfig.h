@@ -107,6 +107,8 @@ const uint8_t  BLOCK_MINOR_VERSION_1                         = 1;
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        = 10000; // by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            = 128; // by default, blocks count in blocks downloading
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         = 1000;
+const uint32_t BLOCKCHAIN_PRUNING_DEFAULT_DEPTH              = 10000; // blocks kept with signatures in pruning mode
+const uint32_t BLOCKCHAIN_PRUNING_MIN_DEPTH                  = 1000;
 
 const int      P2P_DEFAULT_PORT                              = 7080;
 const int      RPC_DEFAULT_PORT                              = 7081;
@@ -115,6 +117,7 @@ const size_t   P2P_LOCAL_WHITE_PEERLIST_LIMIT                = 1000;
 const size_t   P2P_LOCAL_GRAY_PEERLIST_LIMIT                 = 5000;
 
 const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE          = 64 * 1024 * 1024; // 64 MB
+const size_t   P2P_CONNECTION_MAX_RELAY_BUFFER_SIZE          = 4 * 1024 * 1024; // 4 MB of queued transaction relays, more are dropped
 const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT                 = 8;
 const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT     = 70;
 const uint32_t P2P_DEFAULT_HANDSHAKE_INTERVAL                = 60; // seconds
@@ -0,0 +1,232 @@
+#include "ContextSwitch.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define SYSTEM_ASSEMBLY_CONTEXT_SWITCH
+#else
+#include <ucontext.h>
+#include "ErrorMessage.h"
+#endif
+
+#ifdef SYSTEM_ASSEMBLY_CONTEXT_SWITCH
+
+extern "C" {
+// stores the stack pointer of the current context to *from after pushing callee-saved registers, pops them from to
+void systemSwitchContext(void** from, void* to);
+// first return address of a new context, calls the procedure with the argument left in callee-saved registers
+void systemStartContext();
+}
+
+#if defined(__x86_64__)
+
+// frame: mxcsr and x87 control word, r12, r13, r14, r15, rbx, rbp, return address
+asm(R"(
+  .text
+  .globl systemSwitchContext
+  .type systemSwitchContext, @function
+  .p2align 4
+systemSwitchContext:
+  pushq %rbp
+  pushq %rbx
+  pushq %r15
+  pushq %r14
+  pushq %r13
+  pushq %r12
+  subq $16, %rsp
+  stmxcsr 8(%rsp)
+  fnstcw 12(%rsp)
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  ldmxcsr 8(%rsp)
+  fldcw 12(%rsp)
+  addq $16, %rsp
+  popq %r12
+  popq %r13
+  popq %r14
+  popq %r15
+  popq %rbx
+  popq %rbp
+  ret
+  .size systemSwitchContext, .-systemSwitchContext
+
+  .globl systemStartContext
+  .type systemStartContext, @function
+  .p2align 4
+systemStartContext:
+  movq %r13, %rdi
+  callq *%r12
+  ud2
+  .size systemStartContext, .-systemStartContext
+)");
+
+namespace {
+
+const size_t FRAME_WORDS = 9;
+const size_t MXCSR_SLOT = 1;
+const size_t R12_SLOT = 2;
+const size_t R13_SLOT = 3;
+const size_t RETURN_ADDRESS_SLOT = 8;
+
+void initializeFrame(uint64_t* frame, void (*procedure)(void*), void* argument) {
+  // default mxcsr and x87 control word
+  frame[MXCSR_SLOT] = 0x1F80 | (uint64_t(0x037F) << 32);
+  frame[R12_SLOT] = reinterpret_cast<uint64_t>(procedure);
+  frame[R13_SLOT] = reinterpret_cast<uint64_t>(argument);
+  frame[RETURN_ADDRESS_SLOT] = reinterpret_cast<uint64_t>(&systemStartContext);
+}
+
+}
+
+#else
+
+// frame: x19 - x30, d8 - d15, 16 bytes of padding
+asm(R"(
+  .text
+  .globl systemSwitchContext
+  .type systemSwitchContext, %function
+  .p2align 4
+systemSwitchContext:
+  sub sp, sp, #176
+  stp x19, x20, [sp, #0]
+  stp x21, x22, [sp, #16]
+  stp x23, x24, [sp, #32]
+  stp x25, x26, [sp, #48]
+  stp x27, x28, [sp, #64]
+  stp x29, x30, [sp, #80]
+  stp d8, d9, [sp, #96]
+  stp d10, d11, [sp, #112]
+  stp d12, d13, [sp, #128]
+  stp d14, d15, [sp, #144]
+  mov x2, sp
+  str x2, [x0]
+  mov sp, x1
+  ldp x19, x20, [sp, #0]
+  ldp x21, x22, [sp, #16]
+  ldp x23, x24, [sp, #32]
+  ldp x25, x26, [sp, #48]
+  ldp x27, x28, [sp, #64]
+  ldp x29, x30, [sp, #80]
+  ldp d8, d9, [sp, #96]
+  ldp d10, d11, [sp, #112]
+  ldp d12, d13, [sp, #128]
+  ldp d14, d15, [sp, #144]
+  add sp, sp, #176
+  ret
+  .size systemSwitchContext, .-systemSwitchContext
+
+  .globl systemStartContext
+  .type systemStartContext, %function
+  .p2align 4
+systemStartContext:
+  mov x0, x20
+  blr x19
+  brk #0
+  .size systemStartContext, .-systemStartContext
+)");
+
+namespace {
+
+const size_t FRAME_WORDS = 22;
+const size_t X19_SLOT = 0;
+const size_t X20_SLOT = 1;
+const size_t X30_SLOT = 11;
+
+void initializeFrame(uint64_t* frame, void (*procedure)(void*), void* argument) {
+  frame[X19_SLOT] = reinterpret_cast<uint64_t>(procedure);
+  frame[X20_SLOT] = reinterpret_cast<uint64_t>(argument);
+  frame[X30_SLOT] = reinterpret_cast<uint64_t>(&systemStartContext);
+}
+
+}
+
+#endif
+
+namespace System {
+
+void* createContext(void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  // a new context starts in systemStartContext with the stack aligned as after a call
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + stackSize) & ~uintptr_t(15);
+  uint64_t* frame = reinterpret_cast<uint64_t*>(top - 16) - FRAME_WORDS;
+  for (size_t i = 0; i < FRAME_WORDS; ++i) {
+    frame[i] = 0;
+  }
+
+  initializeFrame(frame, procedure, argument);
+  return frame;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void destroyContext(void*) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void switchContext(void*& from, void* to) {
+  systemSwitchContext(&from, to);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void* contextStackPointer(void* context) {
+  // the handle is the stack pointer saved below the callee-saved registers
+  return context;
+}
+
+}
+
+#else
+
+namespace System {
+
+namespace {
+
+struct ContextStart {
+  void (*procedure)(void*);
+  void* argument;
+};
+
+void startContext(uint32_t low, uint32_t high) {
+  ContextStart* start = reinterpret_cast<ContextStart*>((static_cast<uintptr_t>(high) << 16 << 16) | low);
+  start->procedure(start->argument);
+}
+
+}
+
+void* createContext(void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  ucontext_t* context = new ucontext_t;
+  if (getcontext(context) == -1) {
+    delete context;
+    throw std::runtime_error("createContext, getcontext failed, " + lastErrorMessage());
+  }
+
+  // the start data lives at the top of the new stack
+  ContextStart* start = reinterpret_cast<ContextStart*>(static_cast<uint8_t*>(stack) + stackSize) - 1;
+  start->procedure = procedure;
+  start->argument = argument;
+  context->uc_stack.ss_sp = stack;
+  context->uc_stack.ss_size = reinterpret_cast<uint8_t*>(start) - static_cast<uint8_t*>(stack);
+  context->uc_link = nullptr;
+  uintptr_t address = reinterpret_cast<uintptr_t>(start);
+  makecontext(context, reinterpret_cast<void(*)()>(startContext), 2, static_cast<uint32_t>(address), static_cast<uint32_t>(address >> 16 >> 16));
+  return context;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void destroyContext(void* context) {
+  delete static_cast<ucontext_t*>(context);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void switchContext(void*& from, void* to) {
+  if (from == nullptr) {
+    from = new ucontext_t;
+  }
+
+  if (swapcontext(static_cast<ucontext_t*>(from), static_cast<ucontext_t*>(to)) == -1) {
+    throw std::runtime_error("switchContext, swapcontext failed, " + lastErrorMessage());
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void* contextStackPointer(void*) {
+  // the register layout of mcontext_t is architecture specific
+  return nullptr;
+}
+
+}
+
+#endif
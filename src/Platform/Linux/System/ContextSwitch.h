@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace System {
+
+// Coroutine contexts are referred to by opaque handles. On x86-64 and aarch64 a handle is the saved stack pointer
+// and a switch only saves callee-saved registers, other architectures fall back to ucontext.
+
+// prepares a context running procedure(argument) on the given stack, procedure must never return
+void* createContext(void* stack, size_t stackSize, void (*procedure)(void*), void* argument);
+void destroyContext(void* context);
+// saves the current context to from and resumes to, a null from is allocated as needed
+void switchContext(void*& from, void* to);
+// lowest address in use by a suspended context, nullptr if the ucontext fallback doesn't tell
+void* contextStackPointer(void* context);
+
+}
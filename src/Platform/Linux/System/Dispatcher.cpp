@@ -1,14 +1,20 @@
 #include "Dispatcher.h"
 #include <cassert>
+#include <cstdlib>
+#include <stdexcept>
 
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/socket.h>
 #include <sys/timerfd.h>
 #include <fcntl.h>
 #include <string.h>
-#include <ucontext.h>
 #include <unistd.h>
+#include "common/Metrics.h"
+#include "ContextSwitch.h"
 #include "ErrorMessage.h"
+#include "IoUring.h"
+#include "StackAllocator.h"
 
 namespace System {
 
@@ -17,76 +23,165 @@ namespace {
 struct ContextMakingData {
   Dispatcher* dispatcher;
   void* ucontext;
+  NativeContext** createdContext;
 };
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-class MutextGuard {
-public:
-  MutextGuard(pthread_mutex_t& _mutex) : mutex(_mutex) {
-    auto ret = pthread_mutex_lock(&mutex);
-    if (ret != 0) {
-      throw std::runtime_error("pthread_mutex_lock failed, " + errorMessage(ret));
-    }
+// process wide totals over all dispatchers
+struct StackMetrics {
+  StackMetrics() :
+    inUse(Common::MetricsRegistry::instance().gauge("dispatcher_stacks_in_use", "Coroutine stacks owned by running or bound contexts")),
+    peakInUse(Common::MetricsRegistry::instance().gauge("dispatcher_stacks_peak_in_use", "Highest number of coroutine stacks in use at once")),
+    pooled(Common::MetricsRegistry::instance().gauge("dispatcher_stacks_pooled", "Idle coroutine stacks kept for reuse")),
+    mappedBytes(Common::MetricsRegistry::instance().gauge("dispatcher_stack_mapped_bytes", "Address space mapped for coroutine stacks, committed on first touch")),
+    trimmed(Common::MetricsRegistry::instance().counter("dispatcher_stacks_trimmed_total", "Idle coroutine stacks unmapped by pool trimming")) {
   }
 
-  ~MutextGuard() {
-    pthread_mutex_unlock(&mutex);
+  Common::MetricsGauge& inUse;
+  Common::MetricsGauge& peakInUse;
+  Common::MetricsGauge& pooled;
+  Common::MetricsGauge& mappedBytes;
+  Common::MetricsCounter& trimmed;
+};
+
+StackMetrics& stackMetrics() {
+  static StackMetrics metrics;
+  return metrics;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+struct EventMetrics {
+  EventMetrics() :
+    eventsPerWakeup(Common::MetricsRegistry::instance().histogram("dispatcher_events_per_wakeup", "Events returned by one epoll_wait", std::string(), countBounds())),
+    runQueueLength(Common::MetricsRegistry::instance().histogram("dispatcher_run_queue_length", "Contexts ready to run after handling a batch of events", std::string(), countBounds())),
+    waitMicroseconds(Common::MetricsRegistry::instance().counter("dispatcher_wait_microseconds_total", "Time dispatchers spent blocked in epoll_wait")),
+    busyMicroseconds(Common::MetricsRegistry::instance().counter("dispatcher_busy_microseconds_total", "Time dispatchers spent running contexts and handling events")) {
   }
 
-private:
-  pthread_mutex_t& mutex;
+  static std::vector<double> countBounds() {
+    return { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+  }
+
+  Common::MetricsHistogram& eventsPerWakeup;
+  Common::MetricsHistogram& runQueueLength;
+  Common::MetricsCounter& waitMicroseconds;
+  Common::MetricsCounter& busyMicroseconds;
 };
-//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "invalid pthread mutex size");
 
-//const size_t STACK_SIZE = 64 * 1024;
+EventMetrics& eventMetrics() {
+  static EventMetrics metrics;
+  return metrics;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// default stack size, pages are committed on first touch so only the depth actually used costs memory
 const size_t STACK_SIZE = 512 * 1024;
+// pooled contexts of each stack size kept by a trim
+const size_t MIN_POOLED_CONTEXTS = 16;
+const std::chrono::seconds STACK_TRIM_INTERVAL(30);
+// part of a pooled stack below its NativeContext which a trim keeps when the parked stack pointer is unknown (ucontext)
+const size_t STACK_TRIM_RESERVE = 16 * 1024;
+const size_t EVENT_BATCH_SIZE = 256;
+const unsigned IO_URING_ENTRIES = 256;
+// epoll wait while the kernel is short of resources and some io_uring entries are still not submitted
+const int IO_URING_RETRY_MILLISECONDS = 1;
+
+// timer wheel ticks are CLOCK_MONOTONIC milliseconds, the clock timerfd uses
+uint64_t monotonicNanoseconds() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+}
+
+uint64_t currentTick() {
+  return monotonicNanoseconds() / 1000000;
+}
 
 };
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-Dispatcher::Dispatcher() {
+Dispatcher::Dispatcher() : timerWheel(currentTick()) {
   std::string message;
   epoll = ::epoll_create1(0);
   if (epoll == -1) {
     message = "epoll_create1 failed, " + lastErrorMessage();
   } else {
-    mainContext.ucontext = new ucontext_t;
-    if (getcontext(reinterpret_cast<ucontext_t*>(mainContext.ucontext)) == -1) {
-      message = "getcontext failed, " + lastErrorMessage();
+    // filled by the first switch from the main context
+    mainContext.ucontext = nullptr;
+    remoteSpawnEvent = eventfd(0, O_NONBLOCK);
+    if(remoteSpawnEvent == -1) {
+      message = "eventfd failed, " + lastErrorMessage();
     } else {
-      remoteSpawnEvent = eventfd(0, O_NONBLOCK);
-      if(remoteSpawnEvent == -1) {
-        message = "eventfd failed, " + lastErrorMessage();
-      } else {
-        remoteSpawnEventContext.writeContext = nullptr;
-        remoteSpawnEventContext.readContext = nullptr;
+      remoteSpawnEventContext.writeContext = nullptr;
+      remoteSpawnEventContext.readContext = nullptr;
 
-        epoll_event remoteSpawnEventEpollEvent;
-        remoteSpawnEventEpollEvent.events = EPOLLIN;
-        remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
+      epoll_event remoteSpawnEventEpollEvent;
+      remoteSpawnEventEpollEvent.events = EPOLLIN;
+      remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
 
-        if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
-          message = "epoll_ctl failed, " + lastErrorMessage();
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
+        message = "epoll_ctl failed, " + lastErrorMessage();
+      } else {
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (timerFd == -1) {
+          message = "timerfd_create failed, " + lastErrorMessage();
         } else {
-          *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
-
-          mainContext.interrupted = false;
-          mainContext.group = &contextGroup;
-          mainContext.groupPrev = nullptr;
-          mainContext.groupNext = nullptr;
-          contextGroup.firstContext = nullptr;
-          contextGroup.lastContext = nullptr;
-          contextGroup.firstWaiter = nullptr;
-          contextGroup.lastWaiter = nullptr;
-          currentContext = &mainContext;
-          firstResumingContext = nullptr;
-          firstReusableContext = nullptr;
-          runningContextCount = 0;
-          return;
-        }
+          timerEventContext.writeContext = nullptr;
+          timerEventContext.readContext = nullptr;
+
+          epoll_event timerEpollEvent;
+          timerEpollEvent.events = EPOLLIN;
+          timerEpollEvent.data.ptr = &timerEventContext;
+
+          if (epoll_ctl(epoll, EPOLL_CTL_ADD, timerFd, &timerEpollEvent) == -1) {
+            message = "epoll_ctl failed, " + lastErrorMessage();
+          } else {
+            remoteSpawnStub.next.store(nullptr, std::memory_order_relaxed);
+            remoteSpawnHead = &remoteSpawnStub;
+            remoteSpawnTail.store(&remoteSpawnStub, std::memory_order_relaxed);
+            remoteSpawnSignaled.store(false, std::memory_order_relaxed);
+
+            mainContext.interrupted = false;
+            mainContext.group = &contextGroup;
+            mainContext.groupPrev = nullptr;
+            mainContext.groupNext = nullptr;
+            contextGroup.firstContext = nullptr;
+            contextGroup.lastContext = nullptr;
+            contextGroup.firstWaiter = nullptr;
+            contextGroup.lastWaiter = nullptr;
+            currentContext = &mainContext;
+            firstResumingContext = nullptr;
+            runningContextCount = 0;
+            stackStats = StackStats{0, 0, 0, 0, 0};
+            lastStackTrimTime = std::chrono::steady_clock::now();
+            timerArmedTime = 0;
+            events.resize(EVENT_BATCH_SIZE);
+            eventStats = EventStats{0, 0, 0, 0, 0, 0};
+            lastWakeTime = monotonicNanoseconds();
+
+            // io_uring is optional, without kernel support the dispatcher keeps using readiness events only
+            ioUringOperationCount = 0;
+            ioUringEventContext.writeContext = nullptr;
+            ioUringEventContext.readContext = nullptr;
+            const char* ioUringSetting = getenv("SYSTEM_IO_URING");
+            if (ioUringSetting != nullptr && strcmp(ioUringSetting, "1") == 0) {
+              ioUring = IoUring::create(IO_URING_ENTRIES);
+              if (ioUring) {
+                epoll_event ioUringEpollEvent;
+                ioUringEpollEvent.events = EPOLLIN;
+                ioUringEpollEvent.data.ptr = &ioUringEventContext;
+                if (epoll_ctl(epoll, EPOLL_CTL_ADD, ioUring->getFd(), &ioUringEpollEvent) == -1) {
+                  ioUring.reset();
+                }
+              }
+            }
 
-        auto result = close(remoteSpawnEvent);
-        assert(result == 0);
+            return;
+          }
+
+          auto result = close(timerFd);
+          assert(result == 0);
+        }
       }
+
+      auto result = close(remoteSpawnEvent);
+      assert(result == 0);
     }
 
     auto result = close(epoll);
@@ -102,48 +197,50 @@ Dispatcher::~Dispatcher() {
   }
 
   yield();
+  // interrupted io_uring operations resume their contexts only when their completions arrive
+  while (ioUringOperationCount != 0) {
+    ioUring->submit(1);
+    processCompletions();
+    yield();
+  }
+
   assert(contextGroup.firstContext == nullptr);
   assert(contextGroup.firstWaiter == nullptr);
   assert(firstResumingContext == nullptr);
   assert(runningContextCount == 0);
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
+  for (ReusableContextList& list : reusableContexts) {
+    while (list.firstContext != nullptr) {
+      NativeContext* context = list.firstContext;
+      list.firstContext = context->next;
+      destroyReusableContext(context);
+    }
   }
 
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    assert(result == 0);
-    timers.pop();
+  destroyContext(mainContext.ucontext);
+  assert(timerWheel.empty());
+  // procedures spawned remotely after the last dispatch are never run
+  while (RemoteProcedure* remoteProcedure = popRemoteProcedure()) {
+    delete remoteProcedure;
   }
 
-  auto result = close(epoll);
+  auto result = close(timerFd);
   assert(result == 0);
-  result = close(remoteSpawnEvent);
+  result = close(epoll);
   assert(result == 0);
-  result = pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t*>(this->mutex));
+  result = close(remoteSpawnEvent);
   assert(result == 0);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void Dispatcher::clear() {
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    if (result == -1) {
-      throw std::runtime_error("Dispatcher::clear, close failed, "  + lastErrorMessage());
+  for (ReusableContextList& list : reusableContexts) {
+    while (list.firstContext != nullptr) {
+      NativeContext* context = list.firstContext;
+      list.firstContext = context->next;
+      destroyReusableContext(context);
     }
 
-    timers.pop();
+    list.count = 0;
+    list.minCount = 0;
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -153,54 +250,48 @@ void Dispatcher::dispatch() {
     if (firstResumingContext != nullptr) {
       context = firstResumingContext;
       firstResumingContext = context->next;
+      --eventStats.runQueueLength;
       break;
     }
 
-    epoll_event event;
-    int count = epoll_wait(epoll, &event, 1, -1);
-    if (count == 1) {
-      ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
-      if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-        uint64_t buf;
-        auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-        if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-        }
-
-        MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-        while (!remoteSpawningProcedures.empty()) {
-          spawn(std::move(remoteSpawningProcedures.front()));
-          remoteSpawningProcedures.pop();
-        }
+    // going idle, a good moment to give back stacks not needed lately
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastStackTrimTime >= STACK_TRIM_INTERVAL) {
+      lastStackTrimTime = now;
+      trimReusableContexts();
+    }
 
-        continue;
-      }
+    int timeout = -1;
+    if (ioUring && !ioUring->submit()) {
+      timeout = IO_URING_RETRY_MILLISECONDS;
+    }
 
-      if ((event.events & EPOLLOUT) != 0) {
-        context = contextPair->writeContext->context;
-        contextPair->writeContext->events = event.events;
-      } else if ((event.events & EPOLLIN) != 0) {
-        context = contextPair->readContext->context;
-        contextPair->readContext->events = event.events;
-      } else {
-        continue;
+    uint64_t waitStart = monotonicNanoseconds();
+    int count = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), timeout);
+    uint64_t waitEnd = monotonicNanoseconds();
+
+    // counted in whole microseconds of the running totals, so short intervals are not rounded away
+    EventMetrics& metrics = eventMetrics();
+    metrics.busyMicroseconds.increment((eventStats.busyNanoseconds + waitStart - lastWakeTime) / 1000 - eventStats.busyNanoseconds / 1000);
+    metrics.waitMicroseconds.increment((eventStats.waitNanoseconds + waitEnd - waitStart) / 1000 - eventStats.waitNanoseconds / 1000);
+    eventStats.busyNanoseconds += waitStart - lastWakeTime;
+    eventStats.waitNanoseconds += waitEnd - waitStart;
+    lastWakeTime = waitEnd;
+    if (count == -1) {
+      if (errno != EINTR) {
+        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
       }
 
-      assert(context != nullptr);
-      break;
+      continue;
     }
 
-    if (errno != EINTR) {
-      throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
-    }
+    processEvents(count);
   }
 
   if (context != currentContext) {
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
+    NativeContext* oldContext = currentContext;
     currentContext = context;
-    if (swapcontext(oldContext, static_cast<ucontext_t *>(context->ucontext)) == -1) {
-      throw std::runtime_error("Dispatcher::dispatch, swapcontext failed, " + lastErrorMessage());
-    }
+    switchContext(oldContext->ucontext, context->ucontext);
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -244,17 +335,22 @@ void Dispatcher::pushContext(NativeContext* context) {
   }
 
   lastResumingContext = context;
+  if (++eventStats.runQueueLength > eventStats.peakRunQueueLength) {
+    eventStats.peakRunQueueLength = eventStats.runQueueLength;
+  }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void Dispatcher::remoteSpawn(std::function<void()>&& procedure) {
-  {
-    MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-    remoteSpawningProcedures.push(std::move(procedure));
-  }
-  uint64_t one = 1;
-  auto transferred = write(remoteSpawnEvent, &one, sizeof one);
-  if(transferred == - 1) {
-    throw std::runtime_error("Dispatcher::remoteSpawn, write failed, " + lastErrorMessage());
+  RemoteProcedure* remoteProcedure = new RemoteProcedure;
+  remoteProcedure->procedure = std::move(procedure);
+  pushRemoteProcedure(remoteProcedure);
+  // the dispatcher clears the flag before draining the queue, so either it sees this procedure or the write wakes it again
+  if (!remoteSpawnSignaled.exchange(true)) {
+    uint64_t one = 1;
+    auto transferred = write(remoteSpawnEvent, &one, sizeof one);
+    if(transferred == - 1) {
+      throw std::runtime_error("Dispatcher::remoteSpawn, write failed, " + lastErrorMessage());
+    }
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -279,56 +375,24 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void Dispatcher::yield() {
-  for(;;){
-    epoll_event events[16];
-    int count = epoll_wait(epoll, events, 16, 0);
-    if (count == 0) {
-      break;
-    }
-
-    if(count > 0) {
-      for(int i = 0; i < count; ++i) {
-        ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
-        if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-          uint64_t buf;
-          auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-          if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-          }
-
-          MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-          while (!remoteSpawningProcedures.empty()) {
-            spawn(std::move(remoteSpawningProcedures.front()));
-            remoteSpawningProcedures.pop();
-          }
-
-          continue;
-        }
+  if (ioUring) {
+    ioUring->submit();
+  }
 
-        if ((events[i].events & EPOLLOUT) != 0) {
-          if(contextPair->writeContext != nullptr) {
-            if(contextPair->writeContext->context != nullptr) {
-              contextPair->writeContext->context->interruptProcedure = nullptr;
-            }
-          }
-          pushContext(contextPair->writeContext->context);
-          contextPair->writeContext->events = events[i].events;
-        } else if ((events[i].events & EPOLLIN) != 0) {
-          if(contextPair->readContext != nullptr) {
-            if(contextPair->readContext->context != nullptr) {
-              contextPair->readContext->context->interruptProcedure = nullptr;
-            }
-          }
-          pushContext(contextPair->readContext->context);
-          contextPair->readContext->events = events[i].events;
-        } else {
-          continue;
-        }
-      }
-    } else {
+  for(;;){
+    int count = epoll_wait(epoll, events.data(), static_cast<int>(events.size()), 0);
+    if (count == -1) {
       if (errno != EINTR) {
-        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, " + lastErrorMessage());
+        throw std::runtime_error("Dispatcher::yield, epoll_wait failed, " + lastErrorMessage());
       }
+
+      continue;
+    }
+
+    processEvents(count);
+    // a partial batch means nothing else is ready
+    if (count < static_cast<int>(events.size())) {
+      break;
     }
   }
 
@@ -338,79 +402,365 @@ void Dispatcher::yield() {
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Dispatcher::StackStats Dispatcher::getStackStats() const {
+  return stackStats;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Dispatcher::EventStats Dispatcher::getEventStats() const {
+  return eventStats;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::setEventBatchSize(size_t size) {
+  assert(size > 0);
+  events.resize(size);
+  events.shrink_to_fit();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 int Dispatcher::getEpoll() const {
   return epoll;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-NativeContext& Dispatcher::getReusableContext() {
-  if(firstReusableContext == nullptr) {
-    ucontext_t* newlyCreatedContext = new ucontext_t;
-    if (getcontext(newlyCreatedContext) == -1) { //makecontext precondition
-      throw std::runtime_error("Dispatcher::getReusableContext, getcontext failed, " + lastErrorMessage());
+NativeContext& Dispatcher::getReusableContext(size_t stackSize) {
+  ReusableContextList& list = reusableContextList(stackSize == 0 ? STACK_SIZE : roundStackSize(stackSize));
+  NativeContext* context;
+  if (list.firstContext == nullptr) {
+    context = createReusableContext(list.stackSize);
+  } else {
+    context = list.firstContext;
+    list.firstContext = context->next;
+    --list.count;
+    if (list.count < list.minCount) {
+      list.minCount = list.count;
     }
 
-    auto stackPointer = new uint8_t[STACK_SIZE];
-    newlyCreatedContext->uc_stack.ss_sp = stackPointer;
-    newlyCreatedContext->uc_stack.ss_size = STACK_SIZE;
-
-    ContextMakingData makingContextData {this, newlyCreatedContext};
-    makecontext(newlyCreatedContext, (void(*)())contextProcedureStatic, 1, reinterpret_cast<int*>(&makingContextData));
+    --stackStats.pooled;
+    stackMetrics().pooled.add(-1);
+  }
 
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
-      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
-    }
+  ++stackStats.inUse;
+  if (stackStats.inUse > stackStats.peakInUse) {
+    stackStats.peakInUse = stackStats.inUse;
+  }
 
-    assert(firstReusableContext != nullptr);
-    assert(firstReusableContext->ucontext == newlyCreatedContext);
-    firstReusableContext->stackPtr = stackPointer;
-  };
+  StackMetrics& metrics = stackMetrics();
+  metrics.inUse.add(1);
+  int64_t inUse = metrics.inUse.get();
+  if (inUse > metrics.peakInUse.get()) {
+    metrics.peakInUse.set(inUse);
+  }
 
-  NativeContext* context = firstReusableContext;
-  firstReusableContext = firstReusableContext-> next;
   return *context;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void Dispatcher::pushReusableContext(NativeContext& context) {
-  context.next = firstReusableContext;
-  firstReusableContext = &context;
+  ReusableContextList& list = reusableContextList(context.stackSize);
+  context.next = list.firstContext;
+  list.firstContext = &context;
+  ++list.count;
   --runningContextCount;
+  --stackStats.inUse;
+  ++stackStats.pooled;
+  stackMetrics().inUse.add(-1);
+  stackMetrics().pooled.add(1);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-int Dispatcher::getTimer() {
-  int timer;
-  if (timers.empty()) {
-    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    epoll_event timerEvent;
-    timerEvent.events = 0;
-    timerEvent.data.ptr = nullptr;
+void Dispatcher::addTimer(TimerContext& timer, std::chrono::nanoseconds duration) {
+  assert(duration.count() > 0);
+  uint64_t now = monotonicNanoseconds();
+  if (timerWheel.empty()) {
+    timerWheel.advance(now / 1000000);
+  }
 
-    if (epoll_ctl(getEpoll(), EPOLL_CTL_ADD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Dispatcher::getTimer, epoll_ctl failed, "  + lastErrorMessage());
+  // rounded up, a timer never expires early
+  timer.time = (now + static_cast<uint64_t>(duration.count()) + 999999) / 1000000;
+  timerWheel.add(timer);
+  armTimer();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::interruptTimer(TimerContext& timer) {
+  // a spurious wakeup of an armed timerfd is cheaper than rearming it
+  timerWheel.remove(timer);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Dispatcher::hasIoUring() const {
+  return ioUring != nullptr;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::submitReceive(int fd, void* data, size_t size, OperationContext& operation) {
+  assert(ioUring);
+  // queued entries reach the kernel in a batch when the dispatcher runs out of ready contexts
+  while (!ioUring->queueReceive(fd, data, size, reinterpret_cast<uint64_t>(&operation))) {
+    ioUring->submit();
+    processCompletions();
+  }
+
+  ++ioUringOperationCount;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::submitSend(int fd, const void* data, size_t size, OperationContext& operation) {
+  assert(ioUring);
+  while (!ioUring->queueSend(fd, data, size, MSG_NOSIGNAL, reinterpret_cast<uint64_t>(&operation))) {
+    ioUring->submit();
+    processCompletions();
+  }
+
+  ++ioUringOperationCount;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::cancelIo(OperationContext& operation) {
+  assert(ioUring);
+  while (!ioUring->queueCancel(reinterpret_cast<uint64_t>(&operation), 0)) {
+    ioUring->submit();
+    processCompletions();
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Dispatcher::ReusableContextList& Dispatcher::reusableContextList(size_t stackSize) {
+  for (ReusableContextList& list : reusableContexts) {
+    if (list.stackSize == stackSize) {
+      return list;
     }
-  } else {
-    timer = timers.top();
-    timers.pop();
   }
 
-  return timer;
+  reusableContexts.push_back(ReusableContextList{stackSize, nullptr, 0, 0});
+  return reusableContexts.back();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+NativeContext* Dispatcher::createReusableContext(size_t stackSize) {
+  void* stack = allocateStack(stackSize);
+  NativeContext* context = nullptr;
+  ContextMakingData makingContextData {this, nullptr, &context};
+  try {
+    makingContextData.ucontext = createContext(stack, stackSize, contextProcedureStatic, &makingContextData);
+  } catch (std::exception&) {
+    freeStack(stack, stackSize);
+    throw;
+  }
+
+  // the new context reports itself and switches back
+  switchContext(currentContext->ucontext, makingContextData.ucontext);
+
+  assert(context != nullptr);
+  context->stackPtr = stack;
+  context->stackSize = stackSize;
+  stackStats.mappedBytes += stackSize;
+  stackMetrics().mappedBytes.add(static_cast<int64_t>(stackSize));
+  return context;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::destroyReusableContext(NativeContext* context) {
+  // the context lives on its own stack
+  void* stack = context->stackPtr;
+  size_t stackSize = context->stackSize;
+  destroyContext(context->ucontext);
+  freeStack(stack, stackSize);
+
+  --stackStats.pooled;
+  stackStats.mappedBytes -= stackSize;
+  stackMetrics().pooled.add(-1);
+  stackMetrics().mappedBytes.add(-static_cast<int64_t>(stackSize));
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::trimReusableContexts() {
+  for (ReusableContextList& list : reusableContexts) {
+    size_t surplus = list.minCount > MIN_POOLED_CONTEXTS ? list.minCount - MIN_POOLED_CONTEXTS : 0;
+
+    // the most recently pooled contexts are kept, only the pages below the stack pointer they are parked at are released
+    NativeContext** link = &list.firstContext;
+    for (size_t i = surplus; i < list.count; ++i) {
+      NativeContext* context = *link;
+      if (context == currentContext) {
+        // running, its saved stack pointer is stale
+        link = &context->next;
+        continue;
+      }
+
+      uint8_t* stack = static_cast<uint8_t*>(context->stackPtr);
+      uint8_t* parkedFrames = static_cast<uint8_t*>(contextStackPointer(context->ucontext));
+      if (parkedFrames == nullptr) {
+        uint8_t* contextFrame = reinterpret_cast<uint8_t*>(context);
+        parkedFrames = contextFrame - stack > static_cast<ptrdiff_t>(STACK_TRIM_RESERVE) ? contextFrame - STACK_TRIM_RESERVE : stack;
+      }
+
+      // releaseStackPages() keeps the partial page holding the stack pointer
+      releaseStackPages(stack, parkedFrames);
+      link = &context->next;
+    }
+
+    while (*link != nullptr) {
+      NativeContext* context = *link;
+      if (context == currentContext) {
+        // still running on its stack, it has just pooled itself
+        link = &context->next;
+        continue;
+      }
+
+      *link = context->next;
+      destroyReusableContext(context);
+      --list.count;
+      ++stackStats.trimmed;
+      stackMetrics().trimmed.increment();
+    }
+
+    list.minCount = list.count;
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::processEvents(int count) {
+  for (int i = 0; i < count; ++i) {
+    ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+    if (contextPair == &timerEventContext) {
+      processTimers();
+      continue;
+    }
+
+    if (contextPair == &ioUringEventContext) {
+      processCompletions();
+      continue;
+    }
+
+    if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
+      processRemoteSpawns();
+      continue;
+    }
+
+    OperationContext* operationContext;
+    if ((events[i].events & EPOLLOUT) != 0) {
+      operationContext = contextPair->writeContext;
+    } else if ((events[i].events & EPOLLIN) != 0) {
+      operationContext = contextPair->readContext;
+    } else {
+      continue;
+    }
+
+    assert(operationContext != nullptr && operationContext->context != nullptr);
+    // the operation has completed, an interrupt while the context waits in the run queue must not resume it again
+    operationContext->context->interruptProcedure = nullptr;
+    operationContext->events = events[i].events;
+    pushContext(operationContext->context);
+  }
+
+  if (count > 0) {
+    ++eventStats.wakeups;
+    eventStats.events += static_cast<uint64_t>(count);
+    EventMetrics& metrics = eventMetrics();
+    metrics.eventsPerWakeup.observe(count);
+    metrics.runQueueLength.observe(static_cast<double>(eventStats.runQueueLength));
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::processTimers() {
+  uint64_t value;
+  if (read(timerFd, &value, sizeof value) == -1 && errno != EAGAIN) {
+    throw std::runtime_error("Dispatcher::processTimers, read failed, " + lastErrorMessage());
+  }
+
+  timerArmedTime = 0;
+  TimerWheelEntry* entry = timerWheel.advance(currentTick());
+  while (entry != nullptr) {
+    TimerContext* timer = static_cast<TimerContext*>(entry);
+    entry = entry->next;
+    timer->context->interruptProcedure = nullptr;
+    pushContext(timer->context);
+  }
+
+  armTimer();
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-void Dispatcher::pushTimer(int timer) {
-  timers.push(timer);
+void Dispatcher::processCompletions() {
+  uint64_t userData;
+  int32_t result;
+  while (ioUring->popCompletion(userData, result)) {
+    // cancel requests carry no operation
+    if (userData == 0) {
+      continue;
+    }
+
+    OperationContext* operation = reinterpret_cast<OperationContext*>(userData);
+    --ioUringOperationCount;
+    operation->result = result;
+    operation->context->interruptProcedure = nullptr;
+    pushContext(operation->context);
+  }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-void Dispatcher::contextProcedure(void* ucontext) {
-  assert(firstReusableContext == nullptr);
+void Dispatcher::processRemoteSpawns() {
+  uint64_t buf;
+  auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
+  if(transferred == -1) {
+    throw std::runtime_error("Dispatcher::processRemoteSpawns, read(remoteSpawnEvent) failed, " + lastErrorMessage());
+  }
+
+  remoteSpawnSignaled.exchange(false);
+  while (RemoteProcedure* remoteProcedure = popRemoteProcedure()) {
+    std::unique_ptr<RemoteProcedure> remoteProcedureGuard(remoteProcedure);
+    spawn(std::move(remoteProcedure->procedure));
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::pushRemoteProcedure(RemoteProcedure* remoteProcedure) {
+  remoteProcedure->next.store(nullptr, std::memory_order_relaxed);
+  RemoteProcedure* previous = remoteSpawnTail.exchange(remoteProcedure, std::memory_order_acq_rel);
+  previous->next.store(remoteProcedure, std::memory_order_release);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Dispatcher::RemoteProcedure* Dispatcher::popRemoteProcedure() {
+  RemoteProcedure* head = remoteSpawnHead;
+  RemoteProcedure* next = head->next.load(std::memory_order_acquire);
+  if (head == &remoteSpawnStub) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+
+    remoteSpawnHead = head = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next != nullptr) {
+    remoteSpawnHead = next;
+    return head;
+  }
+
+  if (head != remoteSpawnTail.load(std::memory_order_acquire)) {
+    // a producer has exchanged the tail but not linked its procedure yet, its write to remoteSpawnEvent comes after the link
+    return nullptr;
+  }
+
+  // the last procedure is taken only with the stub behind it, so the head never catches up with the tail
+  pushRemoteProcedure(&remoteSpawnStub);
+  next = head->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    remoteSpawnHead = next;
+    return head;
+  }
+
+  return nullptr;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::armTimer() {
+  uint64_t time;
+  if (!timerWheel.nextTime(time) || (timerArmedTime != 0 && timerArmedTime <= time)) {
+    return;
+  }
+
+  itimerspec expires;
+  expires.it_interval.tv_sec = expires.it_interval.tv_nsec = 0;
+  expires.it_value.tv_sec = static_cast<time_t>(time / 1000);
+  expires.it_value.tv_nsec = static_cast<long>(time % 1000 * 1000000);
+  if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &expires, NULL) == -1) {
+    throw std::runtime_error("Dispatcher::armTimer, timerfd_settime failed, " + lastErrorMessage());
+  }
+
+  timerArmedTime = time;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Dispatcher::contextProcedure(void* ucontext, NativeContext** createdContext) {
   NativeContext context;
   context.ucontext = ucontext;
   context.interrupted = false;
   context.next = nullptr;
-  firstReusableContext = &context;
-  ucontext_t* oldContext = static_cast<ucontext_t*>(context.ucontext);
-  if (swapcontext(oldContext, static_cast<ucontext_t*>(currentContext->ucontext)) == -1) {
-    throw std::runtime_error("Dispatcher::contextProcedure, swapcontext failed, " + lastErrorMessage());
-  }
+  *createdContext = &context;
+  switchContext(context.ucontext, currentContext->ucontext);
 
   for (;;) {
     ++runningContextCount;
@@ -419,6 +769,9 @@ void Dispatcher::contextProcedure(void* ucontext) {
     } catch(std::exception&) {
     }
 
+    // captures are released now rather than when the context is reused
+    context.procedure = nullptr;
+
     if (context.group != nullptr) {
       if (context.groupPrev != nullptr) {
         assert(context.groupPrev->groupNext == &context);
@@ -438,16 +791,12 @@ void Dispatcher::contextProcedure(void* ucontext) {
           context.groupNext->groupPrev = nullptr;
         } else {
           assert(context.group->lastContext == &context);
-          if (context.group->firstWaiter != nullptr) {
-            if (firstResumingContext != nullptr) {
-              assert(lastResumingContext->next == nullptr);
-              lastResumingContext->next = context.group->firstWaiter;
-            } else {
-              firstResumingContext = context.group->firstWaiter;
-            }
-
-            lastResumingContext = context.group->lastWaiter;
-            context.group->firstWaiter = nullptr;
+          NativeContext* waiter = context.group->firstWaiter;
+          context.group->firstWaiter = nullptr;
+          while (waiter != nullptr) {
+            NativeContext* nextWaiter = waiter->next;
+            pushContext(waiter);
+            waiter = nextWaiter;
           }
         }
       }
@@ -461,7 +810,7 @@ void Dispatcher::contextProcedure(void* ucontext) {
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void Dispatcher::contextProcedureStatic(void *context) {
   ContextMakingData* makingContextData = reinterpret_cast<ContextMakingData*>(context);
-  makingContextData->dispatcher->contextProcedure(makingContextData->ucontext);
+  makingContextData->dispatcher->contextProcedure(makingContextData->ucontext, makingContextData->createdContext);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 }
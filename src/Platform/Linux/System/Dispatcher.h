@@ -1,20 +1,27 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <queue>
-#include <stack>
+#include <memory>
+#include <vector>
+#include <sys/epoll.h>
+#include "TimerWheel.h"
 #ifndef __GLIBC__
 #include <bits/reg.h>
 #endif
 
 namespace System {
 
+class IoUring;
 struct NativeContextGroup;
 
 struct NativeContext {
   void* ucontext;
   void* stackPtr;
+  size_t stackSize;
   bool interrupted;
   NativeContext* next;
   NativeContextGroup* group;
@@ -35,6 +42,13 @@ struct OperationContext {
   NativeContext *context;
   bool interrupted;
   uint32_t events;
+  // result of an io_uring operation
+  int32_t result;
+};
+
+struct TimerContext : TimerWheelEntry {
+  NativeContext* context;
+  bool interrupted;
 };
 
 struct ContextPair {
@@ -44,6 +58,24 @@ struct ContextPair {
 
 class Dispatcher {
 public:
+  struct StackStats {
+    size_t inUse;
+    size_t peakInUse;
+    size_t pooled;
+    size_t mappedBytes;
+    uint64_t trimmed;
+  };
+
+  struct EventStats {
+    // epoll_wait calls which returned events, and the events they returned
+    uint64_t wakeups;
+    uint64_t events;
+    size_t runQueueLength;
+    size_t peakRunQueueLength;
+    uint64_t waitNanoseconds;
+    uint64_t busyNanoseconds;
+  };
+
   Dispatcher();
   Dispatcher(const Dispatcher&) = delete;
   ~Dispatcher();
@@ -55,44 +87,89 @@ public:
   void interrupt(NativeContext* context);
   bool interrupted();
   void pushContext(NativeContext* context);
+  // may be called from any thread, lock free
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  StackStats getStackStats() const;
+  EventStats getEventStats() const;
+  // the most events taken from epoll by one call
+  void setEventBatchSize(size_t size);
 
   // system-dependent
   int getEpoll() const;
-  NativeContext& getReusableContext();
+  // stackSize 0 selects the default stack size
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
-  int getTimer();
-  void pushTimer(int timer);
-
-#ifdef __x86_64__
-# if __WORDSIZE == 64
-  static const int SIZEOF_PTHREAD_MUTEX_T = 40;
-# else
-  static const int SIZEOF_PTHREAD_MUTEX_T = 32;
-# endif
-#else
-  static const int SIZEOF_PTHREAD_MUTEX_T = 24;
-#endif
+  // arming and interrupting a timer only touches the timer wheel, the timerfd is rearmed when the earliest expiry moves closer
+  void addTimer(TimerContext& timer, std::chrono::nanoseconds duration);
+  void interruptTimer(TimerContext& timer);
+  // io_uring is used when SYSTEM_IO_URING=1 is set in the environment and the kernel supports it
+  bool hasIoUring() const;
+  // queue an operation on fd, operation.context is resumed with operation.result when it completes
+  void submitReceive(int fd, void* data, size_t size, OperationContext& operation);
+  void submitSend(int fd, const void* data, size_t size, OperationContext& operation);
+  // the canceled operation still completes, with -ECANCELED unless it has finished already
+  void cancelIo(OperationContext& operation);
 
 private:
+  struct RemoteProcedure {
+    std::atomic<RemoteProcedure*> next;
+    std::function<void()> procedure;
+  };
+
+  struct ReusableContextList {
+    size_t stackSize;
+    NativeContext* firstContext;
+    size_t count;
+    // fewest pooled contexts since the last trim, that many were not needed during the whole interval
+    size_t minCount;
+  };
+
   void spawn(std::function<void()>&& procedure);
   int epoll;
-  alignas(void*) uint8_t mutex[SIZEOF_PTHREAD_MUTEX_T];
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
-  std::queue<std::function<void()>> remoteSpawningProcedures;
-  std::stack<int> timers;
+  // intrusive multi producer single consumer queue: producers exchange the tail, the dispatcher pops from the head,
+  // the stub node keeps the queue non-empty so neither side touches the other's end
+  std::atomic<RemoteProcedure*> remoteSpawnTail;
+  RemoteProcedure* remoteSpawnHead;
+  RemoteProcedure remoteSpawnStub;
+  // set while a write to remoteSpawnEvent is pending, producers write only when they set it
+  std::atomic<bool> remoteSpawnSignaled;
+  int timerFd;
+  std::vector<epoll_event> events;
+  EventStats eventStats;
+  uint64_t lastWakeTime;
+  ContextPair timerEventContext;
+  TimerWheel timerWheel;
+  // tick the timerfd is armed for, 0 if disarmed
+  uint64_t timerArmedTime;
+  std::unique_ptr<IoUring> ioUring;
+  ContextPair ioUringEventContext;
+  size_t ioUringOperationCount;
 
   NativeContext mainContext;
   NativeContextGroup contextGroup;
   NativeContext* currentContext;
   NativeContext* firstResumingContext;
   NativeContext* lastResumingContext;
-  NativeContext* firstReusableContext;
+  std::vector<ReusableContextList> reusableContexts;
   size_t runningContextCount;
+  StackStats stackStats;
+  std::chrono::steady_clock::time_point lastStackTrimTime;
 
-  void contextProcedure(void* ucontext);
+  ReusableContextList& reusableContextList(size_t stackSize);
+  NativeContext* createReusableContext(size_t stackSize);
+  void destroyReusableContext(NativeContext* context);
+  void trimReusableContexts();
+  void processEvents(int count);
+  void processTimers();
+  void processCompletions();
+  void processRemoteSpawns();
+  void pushRemoteProcedure(RemoteProcedure* remoteProcedure);
+  RemoteProcedure* popRemoteProcedure();
+  void armTimer();
+  void contextProcedure(void* ucontext, NativeContext** createdContext);
   static void contextProcedureStatic(void* context);
 };
 
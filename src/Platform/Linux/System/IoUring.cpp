@@ -0,0 +1,281 @@
+#include "IoUring.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SYSTEM_IO_URING_HEADER
+#endif
+#endif
+
+#ifdef SYSTEM_IO_URING_HEADER
+#include <linux/io_uring.h>
+#endif
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "ErrorMessage.h"
+
+namespace System {
+
+#if defined(SYSTEM_IO_URING_HEADER) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+
+namespace {
+
+template<typename T> T* ringField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+// kernels from 5.1 to 5.5 set up rings but reject receive and send entries, they also lack the probe itself
+bool supportsOperations(int fd) {
+  const unsigned PROBE_OPERATIONS = 256;
+  std::vector<uint8_t> buffer(sizeof(io_uring_probe) + PROBE_OPERATIONS * sizeof(io_uring_probe_op), 0);
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, PROBE_OPERATIONS) == -1) {
+    return false;
+  }
+
+  for (unsigned operation : {IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL}) {
+    if (operation > probe->last_op || (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+std::unique_ptr<IoUring> IoUring::create(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  std::unique_ptr<IoUring> ring(new IoUring());
+  ring->fd = fd;
+  if (!supportsOperations(fd)) {
+    return nullptr;
+  }
+
+  ring->submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (singleMap) {
+    ring->submissionRingSize = ring->completionRingSize = std::max(ring->submissionRingSize, ring->completionRingSize);
+  }
+
+  void* submissionRing = mmap(nullptr, ring->submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (submissionRing == MAP_FAILED) {
+    return nullptr;
+  }
+
+  ring->submissionRing = submissionRing;
+  void* completionRing = submissionRing;
+  if (!singleMap) {
+    completionRing = mmap(nullptr, ring->completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (completionRing == MAP_FAILED) {
+      return nullptr;
+    }
+  }
+
+  ring->completionRing = completionRing;
+  ring->submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* submissionEntries = mmap(nullptr, ring->submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (submissionEntries == MAP_FAILED) {
+    return nullptr;
+  }
+
+  ring->submissionEntries = static_cast<io_uring_sqe*>(submissionEntries);
+  ring->submissionHead = ringField<unsigned>(submissionRing, params.sq_off.head);
+  ring->submissionTail = ringField<unsigned>(submissionRing, params.sq_off.tail);
+  ring->submissionMask = *ringField<unsigned>(submissionRing, params.sq_off.ring_mask);
+  ring->submissionEntryCount = params.sq_entries;
+  ring->submissionArray = ringField<unsigned>(submissionRing, params.sq_off.array);
+  ring->queuedTail = *ring->submissionTail;
+  ring->completionHead = ringField<unsigned>(completionRing, params.cq_off.head);
+  ring->completionTail = ringField<unsigned>(completionRing, params.cq_off.tail);
+  ring->completionMask = *ringField<unsigned>(completionRing, params.cq_off.ring_mask);
+  ring->completionEntries = ringField<io_uring_cqe>(completionRing, params.cq_off.cqes);
+  return ring;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+IoUring::IoUring() : fd(-1), submissionRing(nullptr), completionRing(nullptr), submissionEntries(nullptr) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+IoUring::~IoUring() {
+  if (submissionEntries != nullptr) {
+    munmap(submissionEntries, submissionEntriesSize);
+  }
+
+  if (completionRing != nullptr && completionRing != submissionRing) {
+    munmap(completionRing, completionRingSize);
+  }
+
+  if (submissionRing != nullptr) {
+    munmap(submissionRing, submissionRingSize);
+  }
+
+  if (fd != -1) {
+    auto result = close(fd);
+    assert(result == 0);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+int IoUring::getFd() const {
+  return fd;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+io_uring_sqe* IoUring::getSubmission() {
+  unsigned head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+  if (queuedTail - head >= submissionEntryCount) {
+    return nullptr;
+  }
+
+  unsigned index = queuedTail & submissionMask;
+  submissionArray[index] = index;
+  ++queuedTail;
+  io_uring_sqe* entry = &submissionEntries[index];
+  memset(entry, 0, sizeof(io_uring_sqe));
+  return entry;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueReceive(int fd, void* data, size_t size, uint64_t userData) {
+  io_uring_sqe* entry = getSubmission();
+  if (entry == nullptr) {
+    return false;
+  }
+
+  entry->opcode = IORING_OP_RECV;
+  entry->fd = fd;
+  entry->addr = reinterpret_cast<uint64_t>(data);
+  entry->len = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+  entry->user_data = userData;
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueSend(int fd, const void* data, size_t size, int flags, uint64_t userData) {
+  io_uring_sqe* entry = getSubmission();
+  if (entry == nullptr) {
+    return false;
+  }
+
+  entry->opcode = IORING_OP_SEND;
+  entry->fd = fd;
+  entry->addr = reinterpret_cast<uint64_t>(data);
+  entry->len = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+  entry->msg_flags = static_cast<uint32_t>(flags);
+  entry->user_data = userData;
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueCancel(uint64_t targetUserData, uint64_t userData) {
+  io_uring_sqe* entry = getSubmission();
+  if (entry == nullptr) {
+    return false;
+  }
+
+  entry->opcode = IORING_OP_ASYNC_CANCEL;
+  entry->fd = -1;
+  entry->addr = targetUserData;
+  entry->user_data = userData;
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::submit(unsigned waitCount) {
+  __atomic_store_n(submissionTail, queuedTail, __ATOMIC_RELEASE);
+  unsigned flags = waitCount != 0 ? IORING_ENTER_GETEVENTS : 0;
+  for (;;) {
+    // everything the kernel has not consumed yet, including entries left over by an earlier short or failed call
+    unsigned count = queuedTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+    if (count == 0 && waitCount == 0) {
+      return true;
+    }
+
+    long result = syscall(__NR_io_uring_enter, fd, count, waitCount, flags, nullptr, 0);
+    if (result == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      // entries stay in the ring when the kernel is short of resources, the caller has to submit again
+      if (errno == EAGAIN || errno == EBUSY) {
+        return false;
+      }
+
+      throw std::runtime_error("IoUring::submit, io_uring_enter failed, " + lastErrorMessage());
+    }
+
+    if (static_cast<unsigned>(result) >= count) {
+      return true;
+    }
+
+    // a short submission does not wait, the rest is handed over again as long as the kernel takes some
+    if (result == 0) {
+      return false;
+    }
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::popCompletion(uint64_t& userData, int32_t& result) {
+  unsigned head = *completionHead;
+  if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  const io_uring_cqe& entry = static_cast<const io_uring_cqe*>(completionEntries)[head & completionMask];
+  userData = entry.user_data;
+  result = entry.res;
+  __atomic_store_n(completionHead, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+#else
+
+std::unique_ptr<IoUring> IoUring::create(unsigned) {
+  return nullptr;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+IoUring::IoUring() : fd(-1) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+IoUring::~IoUring() {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+int IoUring::getFd() const {
+  return fd;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueReceive(int, void*, size_t, uint64_t) {
+  return false;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueSend(int, const void*, size_t, int, uint64_t) {
+  return false;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::queueCancel(uint64_t, uint64_t) {
+  return false;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+io_uring_sqe* IoUring::getSubmission() {
+  return nullptr;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::submit(unsigned) {
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool IoUring::popCompletion(uint64_t&, int32_t&) {
+  return false;
+}
+
+#endif
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+}
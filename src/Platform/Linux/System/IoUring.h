@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct io_uring_sqe;
+
+namespace System {
+
+// Minimal io_uring submission and completion rings over the raw system calls. Submissions are queued in user
+// space and handed to the kernel by submit, completions are read from the shared completion ring.
+class IoUring {
+public:
+  // returns nullptr if the kernel or the build lacks io_uring support
+  static std::unique_ptr<IoUring> create(unsigned entries);
+
+  IoUring(const IoUring&) = delete;
+  ~IoUring();
+  IoUring& operator=(const IoUring&) = delete;
+
+  int getFd() const;
+  // queue functions return false if the submission queue is full until submit is called
+  bool queueReceive(int fd, void* data, size_t size, uint64_t userData);
+  bool queueSend(int fd, const void* data, size_t size, int flags, uint64_t userData);
+  bool queueCancel(uint64_t targetUserData, uint64_t userData);
+  // hands queued entries to the kernel, waiting for at least waitCount completions; returns false if some entries
+  // are still not consumed by the kernel, they are handed over again by the next call
+  bool submit(unsigned waitCount = 0);
+  bool popCompletion(uint64_t& userData, int32_t& result);
+
+private:
+  IoUring();
+  // returns a zeroed submission queue entry, nullptr if the queue is full
+  io_uring_sqe* getSubmission();
+
+  int fd;
+  void* submissionRing;
+  size_t submissionRingSize;
+  void* completionRing;
+  size_t completionRingSize;
+  io_uring_sqe* submissionEntries;
+  size_t submissionEntriesSize;
+
+  unsigned* submissionHead;
+  unsigned* submissionTail;
+  unsigned submissionMask;
+  unsigned submissionEntryCount;
+  unsigned* submissionArray;
+  // entries handed out by getSubmission, published to the kernel by submit
+  unsigned queuedTail;
+
+  unsigned* completionHead;
+  unsigned* completionTail;
+  unsigned completionMask;
+  void* completionEntries;
+};
+
+}
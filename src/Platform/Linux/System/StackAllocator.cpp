@@ -0,0 +1,70 @@
+#include "StackAllocator.h"
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include "ErrorMessage.h"
+
+namespace System {
+
+namespace {
+
+const size_t MIN_STACK_SIZE = 16 * 1024;
+const size_t GUARD_SIZE = 16 * 1024;
+
+size_t pageSize() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+size_t roundToPages(size_t size) {
+  return (size + pageSize() - 1) / pageSize() * pageSize();
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t roundStackSize(size_t stackSize) {
+  return roundToPages(stackSize < MIN_STACK_SIZE ? MIN_STACK_SIZE : stackSize);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void* allocateStack(size_t stackSize) {
+  assert(stackSize == roundStackSize(stackSize));
+  size_t guardSize = roundToPages(GUARD_SIZE);
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#ifdef MAP_STACK
+  flags |= MAP_STACK;
+#endif
+
+  void* mapping = mmap(nullptr, guardSize + stackSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("allocateStack, mmap failed, " + lastErrorMessage());
+  }
+
+  // stacks grow down, the guard is at the low end
+  if (mprotect(mapping, guardSize, PROT_NONE) == -1) {
+    std::string message = lastErrorMessage();
+    munmap(mapping, guardSize + stackSize);
+    throw std::runtime_error("allocateStack, mprotect failed, " + message);
+  }
+
+  return static_cast<uint8_t*>(mapping) + guardSize;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void freeStack(void* stack, size_t stackSize) {
+  size_t guardSize = roundToPages(GUARD_SIZE);
+  auto result = munmap(static_cast<uint8_t*>(stack) - guardSize, guardSize + stackSize);
+  assert(result == 0);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void releaseStackPages(void* begin, void* end) {
+  uintptr_t first = (reinterpret_cast<uintptr_t>(begin) + pageSize() - 1) / pageSize() * pageSize();
+  uintptr_t last = reinterpret_cast<uintptr_t>(end) / pageSize() * pageSize();
+  if (first < last) {
+    // failure only leaves the pages committed
+    madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+  }
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace System {
+
+// Coroutine stacks are anonymous mappings with an inaccessible guard area below them, so an overflow faults
+// instead of overwriting a neighbour. Pages are committed by the kernel on first touch.
+
+// rounds stackSize up to whole pages, never below the minimal stack size
+size_t roundStackSize(size_t stackSize);
+// returns the lowest usable address of a stack of stackSize bytes
+void* allocateStack(size_t stackSize);
+void freeStack(void* stack, size_t stackSize);
+// returns the pages of [begin, end) to the kernel, they read as zero on the next touch
+void releaseStackPages(void* begin, void* end);
+
+}
@@ -1,8 +1,12 @@
 #include "TcpConnection.h"
 
 #include <arpa/inet.h>
+#include <algorithm>
 #include <cassert>
+#include <errno.h>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <System/ErrorMessage.h>
@@ -11,6 +15,62 @@
 
 namespace System {
 
+namespace {
+
+// the buffers past this count are left for the next call, as after any short transfer
+const size_t MAX_BUFFERS = 16;
+
+template<typename Buffer> size_t totalSize(const Buffer* buffers, size_t count) {
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    size += buffers[i].size;
+  }
+
+  return size;
+}
+
+template<typename Buffer> const Buffer& firstNonEmpty(const Buffer* buffers, size_t count) {
+  size_t index = 0;
+  while (index + 1 < count && buffers[index].size == 0) {
+    ++index;
+  }
+
+  return buffers[index];
+}
+
+template<typename Buffer> int toIovecs(const Buffer* buffers, size_t count, iovec* vectors) {
+  count = std::min(count, MAX_BUFFERS);
+  for (size_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = const_cast<uint8_t*>(buffers[i].data);
+    vectors[i].iov_len = buffers[i].size;
+  }
+
+  return static_cast<int>(count);
+}
+
+ssize_t receiveBuffers(int socket, const IoBuffer* buffers, size_t count) {
+  if (count == 1) {
+    return ::recv(socket, buffers[0].data, buffers[0].size, 0);
+  }
+
+  iovec vectors[MAX_BUFFERS];
+  return ::readv(socket, vectors, toIovecs(buffers, count, vectors));
+}
+
+ssize_t sendBuffers(int socket, const ConstIoBuffer* buffers, size_t count) {
+  if (count == 1) {
+    return ::send(socket, buffers[0].data, buffers[0].size, MSG_NOSIGNAL);
+  }
+
+  iovec vectors[MAX_BUFFERS];
+  msghdr message = {};
+  message.msg_iov = vectors;
+  message.msg_iovlen = toIovecs(buffers, count, vectors);
+  return ::sendmsg(socket, &message, MSG_NOSIGNAL);
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -55,6 +115,11 @@ TcpConnection& TcpConnection::operator=(TcpConnection&& other) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 size_t TcpConnection::read(uint8_t* data, size_t size) {
+  IoBuffer buffer = { data, size };
+  return read(&buffer, 1);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t TcpConnection::read(const IoBuffer* buffers, size_t count) {
   assert(dispatcher != nullptr);
   assert(contextPair.readContext == nullptr);
   if (dispatcher->interrupted()) {
@@ -62,10 +127,19 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
   }
 
   std::string message;
-  ssize_t transferred = ::recv(connection, (void *)data, size, 0);
+  size_t size = totalSize(buffers, count);
+  if (size == 0) {
+    return 0;
+  }
+
+  ssize_t transferred = receiveBuffers(connection, buffers, count);
   if (transferred == -1) {
     if (errno != EAGAIN) {
       message = "recv failed, " + lastErrorMessage();
+    } else if (dispatcher->hasIoUring()) {
+      // a short read from the first buffer keeps the completion path to plain receives
+      const IoBuffer& buffer = firstNonEmpty(buffers, count);
+      return transferWithIoUring(contextPair.readContext, true, buffer.data, buffer.size);
     } else {
       epoll_event connectionEvent;
       OperationContext operationContext;
@@ -125,7 +199,7 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::read");
         }
 
-        ssize_t transferred = ::recv(connection, (void *)data, size, 0);
+        ssize_t transferred = receiveBuffers(connection, buffers, count);
         if (transferred == -1) {
           message = "recv failed, " + lastErrorMessage();
         } else {
@@ -143,6 +217,24 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
+  if(size == 0) {
+    assert(dispatcher != nullptr);
+    if (dispatcher->interrupted()) {
+      throw InterruptedException();
+    }
+
+    if(shutdown(connection, SHUT_WR) == -1) {
+      throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
+    }
+
+    return 0;
+  }
+
+  ConstIoBuffer buffer = { data, size };
+  return write(&buffer, 1);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+std::size_t TcpConnection::write(const ConstIoBuffer* buffers, size_t count) {
   assert(dispatcher != nullptr);
   assert(contextPair.writeContext == nullptr);
   if (dispatcher->interrupted()) {
@@ -150,18 +242,19 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
   }
 
   std::string message;
-  if(size == 0) {
-    if(shutdown(connection, SHUT_WR) == -1) {
-      throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
-    }
-
+  // unlike write(data, 0), nothing to write doesn't shut the connection down
+  size_t size = totalSize(buffers, count);
+  if (size == 0) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  ssize_t transferred = sendBuffers(connection, buffers, count);
   if (transferred == -1) {
     if (errno != EAGAIN) {
       message = "send failed, " + lastErrorMessage();
+    } else if (dispatcher->hasIoUring()) {
+      const ConstIoBuffer& buffer = firstNonEmpty(buffers, count);
+      return transferWithIoUring(contextPair.writeContext, false, buffer.data, buffer.size);
     } else {
       epoll_event connectionEvent;
       OperationContext operationContext;
@@ -221,7 +314,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = sendBuffers(connection, buffers, count);
         if (transferred == -1) {
           message = "send failed, "  + lastErrorMessage();
         } else {
@@ -261,4 +354,42 @@ TcpConnection::TcpConnection(Dispatcher& dispatcher, int socket) : dispatcher(&d
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+std::size_t TcpConnection::transferWithIoUring(OperationContext*& pendingContext, bool receive, const uint8_t* data, std::size_t size) {
+  OperationContext operationContext;
+  operationContext.interrupted = false;
+  operationContext.context = dispatcher->getCurrentContext();
+  pendingContext = &operationContext;
+  if (receive) {
+    dispatcher->submitReceive(connection, const_cast<uint8_t*>(data), size, operationContext);
+  } else {
+    dispatcher->submitSend(connection, data, size, operationContext);
+  }
+
+  dispatcher->getCurrentContext()->interruptProcedure = [&]() {
+    // the kernel may still be using the buffer, the completion of the canceled operation resumes the context
+    operationContext.interrupted = true;
+    dispatcher->cancelIo(operationContext);
+  };
+
+  dispatcher->dispatch();
+  dispatcher->getCurrentContext()->interruptProcedure = nullptr;
+  assert(operationContext.context == dispatcher->getCurrentContext());
+  assert(pendingContext == &operationContext);
+  pendingContext = nullptr;
+  if (operationContext.result < 0) {
+    if (operationContext.interrupted && (operationContext.result == -ECANCELED || operationContext.result == -EINTR)) {
+      throw InterruptedException();
+    }
+
+    throw std::runtime_error(std::string(receive ? "TcpConnection::read, recv failed, " : "TcpConnection::write, send failed, ") + errorMessage(-operationContext.result));
+  }
+
+  if (operationContext.interrupted) {
+    // the operation finished before it was canceled, the interrupt applies to the next one
+    dispatcher->interrupt();
+  }
+
+  assert(static_cast<std::size_t>(operationContext.result) <= size);
+  return static_cast<std::size_t>(operationContext.result);
+}
 }
@@ -20,7 +20,6 @@ public:
 private:
   Dispatcher* dispatcher;
   void* context;
-  int timer;
 };
 
 }
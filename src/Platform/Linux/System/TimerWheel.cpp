@@ -0,0 +1,161 @@
+#include "TimerWheel.h"
+#include <cassert>
+#include <cstring>
+
+namespace System {
+
+namespace {
+
+unsigned lowestBit(uint64_t mask) {
+  return static_cast<unsigned>(__builtin_ctzll(mask));
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TimerWheel::TimerWheel(uint64_t now) : current(now), count(0) {
+  memset(occupied, 0, sizeof(occupied));
+  memset(slots, 0, sizeof(slots));
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool TimerWheel::empty() const {
+  return count == 0;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t TimerWheel::now() const {
+  return current;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TimerWheel::add(TimerWheelEntry& entry) {
+  if (entry.time <= current) {
+    entry.time = current + 1;
+  }
+
+  insert(entry);
+  ++count;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TimerWheel::remove(TimerWheelEntry& entry) {
+  assert(entry.link != nullptr);
+  *entry.link = entry.next;
+  if (entry.next != nullptr) {
+    entry.next->link = entry.link;
+  }
+
+  // the link of the first entry of a slot points into the slot table, clear the bit of a slot left empty
+  TimerWheelEntry** first = &slots[0][0];
+  if (entry.link >= first && entry.link < first + LEVELS * SLOTS && *entry.link == nullptr) {
+    size_t index = static_cast<size_t>(entry.link - first);
+    occupied[index / SLOTS] &= ~(uint64_t(1) << (index % SLOTS));
+  }
+
+  entry.link = nullptr;
+  --count;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TimerWheelEntry* TimerWheel::advance(uint64_t now) {
+  TimerWheelEntry* expired = nullptr;
+  while (current < now) {
+    // jumps over ticks with nothing to expire or cascade
+    uint64_t next;
+    if (!nextTime(next) || next > now) {
+      current = now;
+      break;
+    }
+
+    current = next;
+
+    if ((current & (SLOTS - 1)) == 0) {
+      for (unsigned level = 1; level < LEVELS; ++level) {
+        cascade(level);
+        if (((current >> (SLOT_BITS * level)) & (SLOTS - 1)) != 0) {
+          break;
+        }
+      }
+    }
+
+    unsigned slot = current & (SLOTS - 1);
+    if ((occupied[0] & (uint64_t(1) << slot)) != 0) {
+      TimerWheelEntry* entry = slots[0][slot];
+      slots[0][slot] = nullptr;
+      occupied[0] &= ~(uint64_t(1) << slot);
+      while (entry != nullptr) {
+        TimerWheelEntry* following = entry->next;
+        assert(entry->time == current);
+        entry->link = nullptr;
+        entry->next = expired;
+        expired = entry;
+        --count;
+        entry = following;
+      }
+    }
+  }
+
+  return expired;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool TimerWheel::nextTime(uint64_t& time) const {
+  if (count == 0) {
+    return false;
+  }
+
+  bool found = false;
+  for (unsigned level = 0; level < LEVELS; ++level) {
+    if (occupied[level] == 0) {
+      continue;
+    }
+
+    // slot s of this level is reached when the tick has s in these bits and zeros below
+    unsigned shift = SLOT_BITS * level;
+    unsigned position = (current >> shift) & (SLOTS - 1);
+    uint64_t rotation = current >> shift >> SLOT_BITS << SLOT_BITS;
+    uint64_t ahead = position == SLOTS - 1 ? 0 : occupied[level] & (~uint64_t(0) << (position + 1));
+    uint64_t slotTime = ahead != 0 ? rotation + lowestBit(ahead) : rotation + SLOTS + lowestBit(occupied[level]);
+    slotTime <<= shift;
+    if (!found || slotTime < time) {
+      time = slotTime;
+      found = true;
+    }
+  }
+
+  assert(found);
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TimerWheel::insert(TimerWheelEntry& entry) {
+  uint64_t delta = entry.time - current;
+  unsigned level = 0;
+  while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+    ++level;
+  }
+
+  uint64_t time = entry.time;
+  if (delta >= (uint64_t(1) << (SLOT_BITS * LEVELS))) {
+    // parked in the farthest slot, placed again when it is cascaded
+    time = current + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+  }
+
+  unsigned slot = (time >> (SLOT_BITS * level)) & (SLOTS - 1);
+  TimerWheelEntry*& first = slots[level][slot];
+  entry.next = first;
+  entry.link = &first;
+  if (first != nullptr) {
+    first->link = &entry.next;
+  }
+
+  first = &entry;
+  occupied[level] |= uint64_t(1) << slot;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TimerWheel::cascade(unsigned level) {
+  unsigned slot = (current >> (SLOT_BITS * level)) & (SLOTS - 1);
+  TimerWheelEntry* entry = slots[level][slot];
+  slots[level][slot] = nullptr;
+  occupied[level] &= ~(uint64_t(1) << slot);
+  while (entry != nullptr) {
+    TimerWheelEntry* following = entry->next;
+    insert(*entry);
+    entry = following;
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace System {
+
+struct TimerWheelEntry {
+  uint64_t time;
+  TimerWheelEntry* next;
+  TimerWheelEntry** link;
+};
+
+// Hierarchical timer wheel over integer ticks. Level n has 64 slots of 64^n ticks each, entries move to a lower
+// level when the wheel reaches their slot, so adding and removing an entry is O(1). Entries further away than
+// the top level can hold are parked in its last slot and placed again when it comes around.
+class TimerWheel {
+public:
+  explicit TimerWheel(uint64_t now);
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  bool empty() const;
+  uint64_t now() const;
+  // an entry due before the next tick expires on the next tick
+  void add(TimerWheelEntry& entry);
+  void remove(TimerWheelEntry& entry);
+  // moves the wheel to now, returns the expired entries linked by next
+  TimerWheelEntry* advance(uint64_t now);
+  // the earliest tick at which advance has work to do, false if the wheel is empty
+  bool nextTime(uint64_t& time) const;
+
+private:
+  static const unsigned LEVELS = 5;
+  static const unsigned SLOT_BITS = 6;
+  static const unsigned SLOTS = 1 << SLOT_BITS;
+
+  void insert(TimerWheelEntry& entry);
+  void cascade(unsigned level);
+
+  uint64_t current;
+  size_t count;
+  uint64_t occupied[LEVELS];
+  TimerWheelEntry* slots[LEVELS][SLOTS];
+};
+
+}
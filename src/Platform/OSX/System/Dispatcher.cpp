@@ -318,7 +318,7 @@ int Dispatcher::getKqueue() const {
   return kqueue;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-NativeContext& Dispatcher::getReusableContext() {
+NativeContext& Dispatcher::getReusableContext(size_t) {
   if(firstReusableContext == nullptr) {
    uctx* newlyCreatedContext = new uctx;
    uint8_t* stackPointer = new uint8_t[STACK_SIZE];
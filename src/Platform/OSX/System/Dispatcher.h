@@ -51,7 +51,8 @@ public:
   void yield();
 
   int getKqueue() const;
-  NativeContext& getReusableContext();
+  // stack sizes are fixed on this platform, stackSize is ignored
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   int getTimer();
   void pushTimer(int timer);
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <utility>
+#include <System/IoBuffer.h>
 
 namespace System {
 
@@ -19,6 +20,10 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   std::size_t read(uint8_t* data, std::size_t size);
   std::size_t write(const uint8_t* data, std::size_t size);
+  // scattered read into the buffers in order, returns the bytes read, 0 at the end of the stream
+  std::size_t read(const IoBuffer* buffers, std::size_t count);
+  // gathered write from the buffers in order, returns the bytes written, which may be fewer than their total
+  std::size_t write(const ConstIoBuffer* buffers, std::size_t count);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
@@ -232,6 +232,47 @@ void MemoryMappedFile::flush(uint8_t* data, uint64_t size) {
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MemoryMappedFile::resize(uint64_t newSize, std::error_code& ec) {
+  assert(isOpened());
+
+  if (newSize == m_size) {
+    ec = std::error_code();
+    return;
+  }
+
+  // Dirty pages of the old mapping stay in the page cache, the caller flushes the ranges it needs on disk
+  int result = ::ftruncate(m_file, static_cast<off_t>(newSize));
+  if (result == -1) {
+    ec = std::error_code(errno, std::system_category());
+    return;
+  }
+
+  // Map the new size first, so the file stays mapped if it fails
+  uint8_t* data = reinterpret_cast<uint8_t*>(::mmap(nullptr, static_cast<size_t>(newSize), PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0));
+  if (data == MAP_FAILED) {
+    ec = std::error_code(errno, std::system_category());
+    if (newSize > m_size) {
+      int ignore = ::ftruncate(m_file, static_cast<off_t>(m_size));
+      (void)ignore;
+    }
+
+    return;
+  }
+
+  ::munmap(m_data, static_cast<size_t>(m_size));
+  m_data = data;
+  m_size = newSize;
+  ec = std::error_code();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MemoryMappedFile::resize(uint64_t newSize) {
+  std::error_code ec;
+  resize(newSize, ec);
+  if (ec) {
+    throw std::system_error(ec, "MemoryMappedFile::resize");
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void MemoryMappedFile::swap(MemoryMappedFile& other) {
   std::swap(m_file, other.m_file);
   std::swap(m_path, other.m_path);
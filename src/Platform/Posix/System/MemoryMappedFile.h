@@ -30,6 +30,10 @@ public:
   void flush(uint8_t* data, uint64_t size, std::error_code& ec);
   void flush(uint8_t* data, uint64_t size);
 
+  // Changes file size in place, previously returned data pointers become invalid
+  void resize(uint64_t newSize, std::error_code& ec);
+  void resize(uint64_t newSize);
+
   void swap(MemoryMappedFile& other);
 
 private:
@@ -317,7 +317,7 @@ void* Dispatcher::getCompletionPort() const {
   return completionPort;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-NativeContext& Dispatcher::getReusableContext() {
+NativeContext& Dispatcher::getReusableContext(size_t) {
   if (firstReusableContext == nullptr) {
     void* fiber = CreateFiberEx(STACK_SIZE, RESERVE_STACK_SIZE, 0, contextProcedureStatic, this);
     if (fiber == NULL) {
@@ -46,7 +46,8 @@ public:
   // Platform-specific
   void addTimer(uint64_t time, NativeContext* context);
   void* getCompletionPort() const;
-  NativeContext& getReusableContext();
+  // stack sizes are fixed on this platform, stackSize is ignored
+  NativeContext& getReusableContext(size_t stackSize = 0);
   void pushReusableContext(NativeContext&);
   void interruptTimer(uint64_t time, NativeContext* context);
 
@@ -265,6 +265,67 @@ void MemoryMappedFile::flush(uint8_t* data, uint64_t size) {
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MemoryMappedFile::resize(uint64_t newSize, std::error_code& ec) {
+  assert(isOpened());
+
+  if (newSize == m_size) {
+    ec = std::error_code();
+    return;
+  }
+
+  // Dirty pages of an unmapped view are still written by the system, the caller flushes the ranges it needs on disk
+  // A mapped file can't change its size, so the view is recreated
+  Tools::ScopeExit failExitHandler([this, &ec] {
+    ec = std::error_code(::GetLastError(), std::system_category());
+    std::error_code ignore;
+    close(ignore);
+  });
+
+  if (!::UnmapViewOfFile(m_data)) {
+    return;
+  }
+
+  m_data = nullptr;
+  if (!::CloseHandle(m_mappingHandle)) {
+    return;
+  }
+
+  m_mappingHandle = INVALID_HANDLE_VALUE;
+
+  LONG distanceToMoveHigh = static_cast<LONG>((newSize >> 32) & UINT64_C(0xffffffff));
+  DWORD filePointer = ::SetFilePointer(m_fileHandle, static_cast<LONG>(newSize & UINT64_C(0xffffffff)), &distanceToMoveHigh, FILE_BEGIN);
+  if (filePointer == INVALID_SET_FILE_POINTER) {
+    return;
+  }
+
+  if (!::SetEndOfFile(m_fileHandle)) {
+    return;
+  }
+
+  m_mappingHandle = ::CreateFileMapping(m_fileHandle, NULL, PAGE_READWRITE, 0, 0, NULL);
+  if (m_mappingHandle == NULL) {
+    return;
+  }
+
+  m_data = reinterpret_cast<uint8_t*>(::MapViewOfFile(m_mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+  if (m_data == NULL) {
+    return;
+  }
+
+  m_size = newSize;
+  ec = std::error_code();
+
+  failExitHandler.cancel();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MemoryMappedFile::resize(uint64_t newSize) {
+  std::error_code ec;
+  resize(newSize, ec);
+  if (ec) {
+    throw std::system_error(ec, "MemoryMappedFile::resize");
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void MemoryMappedFile::swap(MemoryMappedFile& other) {
   std::swap(m_fileHandle, other.m_fileHandle);
   std::swap(m_mappingHandle, other.m_mappingHandle);
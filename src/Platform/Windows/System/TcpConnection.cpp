@@ -197,6 +197,28 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
   return transferred;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t TcpConnection::read(const IoBuffer* buffers, size_t count) {
+  // without scattered reads here, filling the first non-empty buffer is a valid short read
+  for (size_t i = 0; i < count; ++i) {
+    if (buffers[i].size != 0) {
+      return read(buffers[i].data, buffers[i].size);
+    }
+  }
+
+  return 0;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t TcpConnection::write(const ConstIoBuffer* buffers, size_t count) {
+  // an empty write would shut the connection down, so empty buffers are skipped
+  for (size_t i = 0; i < count; ++i) {
+    if (buffers[i].size != 0) {
+      return write(buffers[i].data, buffers[i].size);
+    }
+  }
+
+  return 0;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
   sockaddr_in address;
   int size = sizeof(address);
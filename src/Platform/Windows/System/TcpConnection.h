@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <System/IoBuffer.h>
 
 namespace System {
 
@@ -18,6 +19,10 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   size_t read(uint8_t* data, size_t size);
   size_t write(const uint8_t* data, size_t size);
+  // scattered read into the buffers in order, returns the bytes read, 0 at the end of the stream
+  size_t read(const IoBuffer* buffers, size_t count);
+  // gathered write from the buffers in order, returns the bytes written, which may be fewer than their total
+  size_t write(const ConstIoBuffer* buffers, size_t count);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
@@ -6,7 +6,8 @@ namespace System {
 
 class ContextGroup {
 public:
-  explicit ContextGroup(Dispatcher& dispatcher);
+  // stackSize 0 selects the dispatcher's default stack size
+  explicit ContextGroup(Dispatcher& dispatcher, size_t stackSize = 0);
   ContextGroup(const ContextGroup&) = delete;
   ContextGroup(ContextGroup&& other);
   ~ContextGroup();
@@ -18,6 +19,7 @@ public:
 
 private:
   Dispatcher* dispatcher;
+  size_t stackSize;
   NativeContextGroup contextGroup;
 };
 
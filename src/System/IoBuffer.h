@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace System {
+
+// one piece of a scattered read
+struct IoBuffer {
+  uint8_t* data;
+  std::size_t size;
+};
+
+// one piece of a gathered write
+struct ConstIoBuffer {
+  const uint8_t* data;
+  std::size_t size;
+};
+
+}
@@ -0,0 +1,251 @@
+#include "Scheduler.h"
+#include <algorithm>
+#include <cassert>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include "common/Metrics.h"
+
+namespace System {
+
+namespace {
+
+struct CurrentWorker {
+  const Scheduler* scheduler;
+  Dispatcher* dispatcher;
+  size_t index;
+};
+
+thread_local CurrentWorker currentWorker = { nullptr, nullptr, 0 };
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// process wide totals over all schedulers
+struct SchedulerMetrics {
+  SchedulerMetrics() :
+    tasks(Common::MetricsRegistry::instance().counter("scheduler_tasks_total", "Tasks started by scheduler workers")),
+    stolen(Common::MetricsRegistry::instance().counter("scheduler_tasks_stolen_total", "Tasks an idle scheduler worker took from the run queue of another")),
+    wakeups(Common::MetricsRegistry::instance().counter("scheduler_worker_wakeups_total", "Idle scheduler workers woken for new tasks")) {
+  }
+
+  Common::MetricsCounter& tasks;
+  Common::MetricsCounter& stolen;
+  Common::MetricsCounter& wakeups;
+};
+
+SchedulerMetrics& schedulerMetrics() {
+  static SchedulerMetrics metrics;
+  return metrics;
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Scheduler::Scheduler(size_t threadCount, size_t stackSize) : stackSize(stackSize), nextWorker(0), stopping(false), startedCount(0), stoppedCount(0) {
+  if (threadCount == 0) {
+    threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers.emplace_back(new Worker);
+    workers.back()->sleeping.store(false);
+    workers.back()->dispatcher = nullptr;
+    workers.back()->wakeEvent = nullptr;
+  }
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers[i]->thread = std::thread(&Scheduler::workerProcedure, this, i);
+  }
+
+  std::unique_lock<std::mutex> lock(stateMutex);
+  stateCondition.wait(lock, [this] { return startedCount == workers.size(); });
+  if (startError) {
+    lock.unlock();
+    stop();
+    std::rethrow_exception(startError);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Scheduler::~Scheduler() {
+  stop();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Scheduler::spawn(std::function<void()>&& procedure) {
+  assert(!stopping.load());
+  size_t index = currentWorker.scheduler == this ? currentWorker.index : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+  Worker& worker = *workers[index];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(procedure));
+  }
+
+  // a worker sets sleeping before it checks the run queues for the last time, so either it sees the task or it is woken
+  if (worker.sleeping.load()) {
+    wake(worker);
+    return;
+  }
+
+  // the owner is busy, an idle worker steals the task
+  for (auto& other : workers) {
+    if (other->sleeping.load()) {
+      wake(*other);
+      break;
+    }
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t Scheduler::getThreadCount() const {
+  return workers.size();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Dispatcher* Scheduler::currentDispatcher() {
+  return currentWorker.dispatcher;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Scheduler::workerProcedure(size_t index) {
+  Worker& worker = *workers[index];
+  std::unique_ptr<Dispatcher> dispatcher;
+  try {
+    dispatcher.reset(new Dispatcher);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (!startError) {
+      startError = std::current_exception();
+    }
+
+    ++startedCount;
+    ++stoppedCount;
+    stateCondition.notify_all();
+    return;
+  }
+
+  Event wakeEvent(*dispatcher);
+  worker.dispatcher = dispatcher.get();
+  worker.wakeEvent = &wakeEvent;
+  currentWorker = CurrentWorker{ this, dispatcher.get(), index };
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    ++startedCount;
+    stateCondition.notify_all();
+  }
+
+  {
+    ContextGroup tasks(*dispatcher, stackSize);
+    std::function<void()> task;
+    while (!stopping.load()) {
+      if (!takeTask(index, task)) {
+        wakeEvent.clear();
+        worker.sleeping.store(true);
+        if (!takeTask(index, task)) {
+          if (!stopping.load()) {
+            wakeEvent.wait();
+          }
+
+          worker.sleeping.store(false);
+          continue;
+        }
+
+        worker.sleeping.store(false);
+      }
+
+      schedulerMetrics().tasks.increment();
+      tasks.spawn(std::move(task));
+      task = nullptr;
+      // runs the task until it blocks or finishes, then the worker looks for the next one
+      dispatcher->yield();
+    }
+
+    tasks.interrupt();
+    tasks.wait();
+  }
+
+  // finishing tasks of other workers and stop() may still wake this one, so its dispatcher lives until they are all done
+  {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    ++stoppedCount;
+    stateCondition.notify_all();
+    stateCondition.wait(lock, [this] { return stoppedCount == workers.size() + 1; });
+  }
+
+  worker.wakeEvent = nullptr;
+  currentWorker = CurrentWorker{ nullptr, nullptr, 0 };
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Scheduler::takeTask(size_t index, std::function<void()>& task) {
+  Worker& worker = *workers[index];
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (!worker.tasks.empty()) {
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        return true;
+      }
+    }
+
+    if (!stealTasks(index)) {
+      return false;
+    }
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Scheduler::stealTasks(size_t index) {
+  std::vector<std::function<void()>> stolen;
+  for (size_t i = 1; i < workers.size() && stolen.empty(); ++i) {
+    Worker& victim = *workers[(index + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    // the newest half, the owner keeps taking the oldest tasks from the front
+    size_t count = (victim.tasks.size() + 1) / 2;
+    for (size_t j = 0; j < count; ++j) {
+      stolen.push_back(std::move(victim.tasks.back()));
+      victim.tasks.pop_back();
+    }
+  }
+
+  if (stolen.empty()) {
+    return false;
+  }
+
+  schedulerMetrics().stolen.increment(stolen.size());
+  Worker& worker = *workers[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  for (auto it = stolen.rbegin(); it != stolen.rend(); ++it) {
+    worker.tasks.push_back(std::move(*it));
+  }
+
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Scheduler::wake(Worker& worker) {
+  if (worker.sleeping.exchange(false)) {
+    schedulerMetrics().wakeups.increment();
+    Worker* wokenWorker = &worker;
+    // runs on the worker, its wake event is gone once it has stopped
+    worker.dispatcher->remoteSpawn([wokenWorker] {
+      if (wokenWorker->wakeEvent != nullptr) {
+        wokenWorker->wakeEvent->set();
+      }
+    });
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Scheduler::stop() {
+  // a worker checks stopping after setting sleeping, so either it doesn't wait or it is woken here
+  stopping.store(true);
+  for (auto& worker : workers) {
+    if (worker->dispatcher != nullptr) {
+      wake(*worker);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    ++stoppedCount;
+    stateCondition.notify_all();
+  }
+
+  for (auto& worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace System {
+
+class Dispatcher;
+class Event;
+
+// Runs tasks on a fixed set of threads, each driving its own Dispatcher. A task runs in a context of the worker that
+// takes it, so it uses ContextGroup, Event, Timer and sockets with currentDispatcher() like any other context.
+// Every worker has a run queue of tasks not started yet, an idle worker steals half of the queue of a busy one.
+// A started task stays on its worker, contexts are bound to the dispatcher which created them.
+class Scheduler {
+public:
+  // threadCount 0 selects std::thread::hardware_concurrency(), stackSize 0 the dispatcher's default stack size
+  explicit Scheduler(size_t threadCount = 0, size_t stackSize = 0);
+  Scheduler(const Scheduler&) = delete;
+  // interrupts running tasks and waits for them, tasks not started yet are dropped
+  ~Scheduler();
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  // may be called from any thread, a task spawned by a worker of this scheduler is queued on that worker
+  void spawn(std::function<void()>&& procedure);
+  size_t getThreadCount() const;
+  // dispatcher of the worker running the calling thread, nullptr on other threads
+  static Dispatcher* currentDispatcher();
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    // set while the worker waits for tasks, cleared by whoever wakes it
+    std::atomic<bool> sleeping;
+    Dispatcher* dispatcher;
+    Event* wakeEvent;
+    std::thread thread;
+  };
+
+  void workerProcedure(size_t index);
+  bool takeTask(size_t index, std::function<void()>& task);
+  bool stealTasks(size_t index);
+  void wake(Worker& worker);
+  void stop();
+
+  size_t stackSize;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<size_t> nextWorker;
+  std::atomic<bool> stopping;
+  std::mutex stateMutex;
+  std::condition_variable stateCondition;
+  size_t startedCount;
+  size_t stoppedCount;
+  std::exception_ptr startError;
+};
+
+}
@@ -1,17 +1,37 @@
 #include "TcpStream.h"
+#include <algorithm>
+#include <cstring>
 #include <System/TcpConnection.h>
 
 namespace System {
 
-TcpStreambuf::TcpStreambuf(TcpConnection& connection) : connection(connection) {
-  setg(&readBuf.front(), &readBuf.front(), &readBuf.front());
-  setp(reinterpret_cast<char*>(&writeBuf.front()), reinterpret_cast<char *>(&writeBuf.front() + writeBuf.max_size()));
+TcpStreambuf::TcpStreambuf(TcpConnection& connection, size_t readBufferSize, size_t writeBufferSize) :
+  connection(connection), readBuf(std::max<size_t>(readBufferSize, 1)), writeBuf(std::max<size_t>(writeBufferSize, 1)) {
+  setg(readBuf.data(), readBuf.data(), readBuf.data());
+  setp(writeBuf.data(), writeBuf.data() + writeBuf.size());
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 TcpStreambuf::~TcpStreambuf() {
   dumpBuffer(true);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TcpStreambuf::setReadBufferSize(size_t size) {
+  size_t unread = egptr() - gptr();
+  std::vector<char> buffer(std::max(std::max<size_t>(size, 1), unread));
+  std::memcpy(buffer.data(), gptr(), unread);
+  readBuf.swap(buffer);
+  setg(readBuf.data(), readBuf.data(), readBuf.data() + unread);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TcpStreambuf::setWriteBufferSize(size_t size) {
+  size_t buffered = pptr() - pbase();
+  std::vector<char> buffer(std::max(std::max<size_t>(size, 1), buffered));
+  std::memcpy(buffer.data(), pbase(), buffered);
+  writeBuf.swap(buffer);
+  setp(writeBuf.data(), writeBuf.data() + writeBuf.size());
+  pbump(static_cast<int>(buffered));
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 std::streambuf::int_type TcpStreambuf::overflow(std::streambuf::int_type ch) {
   if (ch == traits_type::eof()) {
     return traits_type::eof();
@@ -39,7 +59,7 @@ std::streambuf::int_type TcpStreambuf::underflow() {
 
   size_t bytesRead;
   try {
-    bytesRead = connection.read(reinterpret_cast<uint8_t*>(&readBuf.front()), readBuf.max_size());
+    bytesRead = connection.read(reinterpret_cast<uint8_t*>(readBuf.data()), readBuf.size());
   } catch (std::exception&) {
     return traits_type::eof();
   }
@@ -48,37 +68,94 @@ std::streambuf::int_type TcpStreambuf::underflow() {
     return traits_type::eof();
   }
 
-  setg(&readBuf.front(), &readBuf.front(), &readBuf.front() + bytesRead);
+  setg(readBuf.data(), readBuf.data(), readBuf.data() + bytesRead);
   return traits_type::to_int_type(*gptr());
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool TcpStreambuf::dumpBuffer(bool finalize) {
-  try {
-    size_t count = pptr() - pbase();
-    if(count == 0) {
-      return true;
+std::streamsize TcpStreambuf::xsgetn(char* data, std::streamsize size) {
+  std::streamsize copied = 0;
+  while (copied < size) {
+    size_t remaining = static_cast<size_t>(size - copied);
+    size_t available = egptr() - gptr();
+    if (available != 0) {
+      size_t count = std::min(available, remaining);
+      std::memcpy(data + copied, gptr(), count);
+      gbump(static_cast<int>(count));
+      copied += count;
+      continue;
     }
 
-    size_t transferred = connection.write(&writeBuf.front(), count);
-    if(transferred == count) {
-      pbump(-static_cast<int>(count));
+    if (remaining < readBuf.size()) {
+      if (underflow() == traits_type::eof()) {
+        break;
+      }
+
+      continue;
+    }
+
+    IoBuffer buffers[2] = {
+      { reinterpret_cast<uint8_t*>(data + copied), remaining },
+      { reinterpret_cast<uint8_t*>(readBuf.data()), readBuf.size() }
+    };
+
+    size_t transferred;
+    try {
+      transferred = connection.read(buffers, 2);
+    } catch (std::exception&) {
+      break;
+    }
+
+    if (transferred == 0) {
+      break;
+    }
+
+    if (transferred <= remaining) {
+      copied += transferred;
     } else {
-      if(!finalize) {
-        size_t front = 0;
-        for (size_t pos = transferred; pos < count; ++pos, ++front) {
-          writeBuf[front] = writeBuf[pos];
-        }
+      copied += remaining;
+      setg(readBuf.data(), readBuf.data(), readBuf.data() + (transferred - remaining));
+    }
+  }
 
-        pbump(-static_cast<int>(transferred));
-      } else {
-        size_t offset = transferred;
-        while( offset != count) {
-          offset += connection.write(&writeBuf.front() + offset, count - offset);
-        }
+  return copied;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+std::streamsize TcpStreambuf::xsputn(const char* data, std::streamsize size) {
+  std::streamsize written = 0;
+  while (written < size) {
+    size_t remaining = static_cast<size_t>(size - written);
+    size_t available = epptr() - pptr();
+    if (remaining <= available) {
+      std::memcpy(pptr(), data + written, remaining);
+      pbump(static_cast<int>(remaining));
+      return size;
+    }
 
-        pbump(-static_cast<int>(count));
-      }
+    if (remaining >= writeBuf.size()) {
+      return written + static_cast<std::streamsize>(writeThrough(data + written, remaining));
     }
+
+    std::memcpy(pptr(), data + written, available);
+    pbump(static_cast<int>(available));
+    written += available;
+    if (!dumpBuffer(false)) {
+      break;
+    }
+  }
+
+  return written;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool TcpStreambuf::dumpBuffer(bool finalize) {
+  try {
+    do {
+      size_t count = pptr() - pbase();
+      if (count == 0) {
+        return true;
+      }
+
+      consumeWritten(connection.write(reinterpret_cast<const uint8_t*>(pbase()), count));
+    } while (finalize);
   } catch (std::exception&) {
     return false;
   }
@@ -86,4 +163,35 @@ bool TcpStreambuf::dumpBuffer(bool finalize) {
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// returns the bytes of data written, fewer than size only if the connection failed
+size_t TcpStreambuf::writeThrough(const char* data, size_t size) {
+  size_t written = 0;
+  try {
+    while (written < size) {
+      size_t buffered = pptr() - pbase();
+      ConstIoBuffer buffers[2] = {
+        { reinterpret_cast<const uint8_t*>(pbase()), buffered },
+        { reinterpret_cast<const uint8_t*>(data + written), size - written }
+      };
+
+      size_t transferred = buffered != 0 ? connection.write(buffers, 2) : connection.write(&buffers[1], 1);
+      if (transferred < buffered) {
+        consumeWritten(transferred);
+      } else {
+        consumeWritten(buffered);
+        written += transferred - buffered;
+      }
+    }
+  } catch (std::exception&) {
+  }
+
+  return written;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void TcpStreambuf::consumeWritten(size_t count) {
+  size_t buffered = pptr() - pbase();
+  std::memmove(pbase(), pbase() + count, buffered - count);
+  pbump(-static_cast<int>(count));
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 }
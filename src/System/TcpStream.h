@@ -1,29 +1,44 @@
 #pragma once
 
-#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <streambuf>
+#include <vector>
 
 namespace System {
 
 class TcpConnection;
 
+// Buffers both directions of a connection. Spans at least as long as a buffer bypass it: a long write goes out
+// with the buffered bytes in one gathered write, a long read is received straight into the destination and
+// whatever follows it fills the read buffer in the same call.
 class TcpStreambuf : public std::streambuf {
 public:
-  explicit TcpStreambuf(TcpConnection& connection);
+  static const size_t DEFAULT_READ_BUFFER_SIZE = 16 * 1024;
+  static const size_t DEFAULT_WRITE_BUFFER_SIZE = 16 * 1024;
+
+  explicit TcpStreambuf(TcpConnection& connection, size_t readBufferSize = DEFAULT_READ_BUFFER_SIZE, size_t writeBufferSize = DEFAULT_WRITE_BUFFER_SIZE);
   TcpStreambuf(const TcpStreambuf&) = delete;
   ~TcpStreambuf();
   TcpStreambuf& operator=(const TcpStreambuf&) = delete;
 
+  // buffered data is kept, a buffer never becomes shorter than the data it holds
+  void setReadBufferSize(size_t size);
+  void setWriteBufferSize(size_t size);
+
 private:
   TcpConnection& connection;
-  std::array<char, 4096> readBuf;
-  std::array<uint8_t, 1024> writeBuf;
+  std::vector<char> readBuf;
+  std::vector<char> writeBuf;
 
   std::streambuf::int_type overflow(std::streambuf::int_type ch) override;
   int sync() override;
   std::streambuf::int_type underflow() override;
+  std::streamsize xsgetn(char* data, std::streamsize size) override;
+  std::streamsize xsputn(const char* data, std::streamsize size) override;
   bool dumpBuffer(bool finalize);
+  size_t writeThrough(const char* data, size_t size);
+  void consumeWritten(size_t count);
 };
 
 }
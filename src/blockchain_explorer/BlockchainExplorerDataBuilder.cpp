@@ -3,6 +3,7 @@
 #include <boost/utility/value_init.hpp>
 #include <boost/range/combine.hpp>
 
+#include "common/Math.h"
 #include "common/StringTools.h"
 #include "base/CryptoNoteFormatUtils.h"
 #include "base/CryptoNoteTools.h"
@@ -12,6 +13,10 @@
 
 namespace CryptoNote {
 
+namespace {
+const size_t REWARD_INFO_CACHE_SIZE = 10000;
+}
+
 BlockchainExplorerDataBuilder::BlockchainExplorerDataBuilder(CryptoNote::ICore& core, CryptoNote::ICryptoNoteProtocolQuery& protocol) :
 core(core),
 protocol(protocol) {
@@ -57,21 +62,42 @@ bool BlockchainExplorerDataBuilder::fillTxExtra(const std::vector<uint8_t>& rawE
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-size_t BlockchainExplorerDataBuilder::median(std::vector<size_t>& v) {
-  if (v.empty())
-    return boost::value_initialized<size_t>();
-  if (v.size() == 1)
-    return v[0];
-
-  size_t n = (v.size()) / 2;
-  std::sort(v.begin(), v.end());
-  //nth_element(v.begin(), v.begin()+n-1, v.end());
-  if (v.size() % 2) {//1, 3, 5...
-    return v[n];
-  } else {//2, 4, 6...
-    return (v[n - 1] + v[n]) / 2;
+bool BlockchainExplorerDataBuilder::getBlockRewardInfo(const Block& block, const Crypto::Hash& hash, uint32_t height, bool isOrphaned, size_t cumulativeSize,
+  BlockRewardInfo& info) {
+  if (!isOrphaned) {
+    std::lock_guard<std::mutex> lock(rewardInfoCacheMutex);
+    auto it = rewardInfoCache.find(hash);
+    if (it != rewardInfoCache.end()) {
+      info = it->second;
+      return true;
+    }
+  }
+
+  std::vector<size_t> blocksSizes;
+  if (!core.getBackwardBlocksSizes(height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
+    return false;
+  }
+
+  uint64_t prevBlockGeneratedCoins = 0;
+  if (height > 0) {
+    if (!core.getAlreadyGeneratedCoins(block.previousBlockHash, prevBlockGeneratedCoins)) {
+      return false;
+    }
   }
 
+  if (!core.currency().getBlockRewardInfo(block.majorVersion, Common::medianValue(blocksSizes), cumulativeSize, prevBlockGeneratedCoins, height, info)) {
+    return false;
+  }
+
+  if (!isOrphaned) {
+    std::lock_guard<std::mutex> lock(rewardInfoCacheMutex);
+    if (rewardInfoCache.size() >= REWARD_INFO_CACHE_SIZE) {
+      rewardInfoCache.clear();
+    }
+    rewardInfoCache.emplace(hash, info);
+  }
+
+  return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDetails& blockDetails) {
@@ -100,12 +126,6 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
     return false;
   }
 
-  std::vector<size_t> blocksSizes;
-  if (!core.getBackwardBlocksSizes(blockDetails.height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
-    return false;
-  }
-  blockDetails.sizeMedian = median(blocksSizes);
-
   size_t blockSize = 0;
   if (!core.getBlockSize(hash, blockSize)) {
     return false;
@@ -124,31 +144,14 @@ bool BlockchainExplorerDataBuilder::fillBlockDetails(const Block &block, BlockDe
     return false;
   }
 
-  uint64_t prevBlockGeneratedCoins = 0;
-  if (blockDetails.height > 0) {
-    if (!core.getAlreadyGeneratedCoins(block.previousBlockHash, prevBlockGeneratedCoins)) {
-      return false;
-    }
-  }
-  uint64_t maxReward = 0;
-  uint64_t currentReward = 0;
-  int64_t emissionChange = 0;
-  if (!core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, 0, prevBlockGeneratedCoins, 0, blockDetails.height, maxReward, emissionChange)) {
-    return false;
-  }
-  if (!core.getBlockReward(block.majorVersion, blockDetails.sizeMedian, blockDetails.transactionsCumulativeSize, prevBlockGeneratedCoins, 0, blockDetails.height, currentReward, emissionChange)) {
+  BlockRewardInfo rewardInfo;
+  if (!getBlockRewardInfo(block, hash, blockDetails.height, blockDetails.isOrphaned, blockDetails.transactionsCumulativeSize, rewardInfo)) {
     return false;
   }
 
-  blockDetails.baseReward = maxReward;
-  if (maxReward == 0 && currentReward == 0) {
-    blockDetails.penalty = static_cast<double>(0);
-  } else {
-    if (maxReward < currentReward) {
-      return false;
-    }
-    blockDetails.penalty = static_cast<double>(maxReward - currentReward) / static_cast<double>(maxReward);
-  }
+  blockDetails.sizeMedian = rewardInfo.sizeMedian;
+  blockDetails.baseReward = rewardInfo.baseReward;
+  blockDetails.penalty = rewardInfo.penalty;
 
 
   blockDetails.transactions.reserve(block.transactionHashes.size() + 1);
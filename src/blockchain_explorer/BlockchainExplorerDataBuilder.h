@@ -2,10 +2,13 @@
 
 #include <vector>
 #include <array>
+#include <mutex>
+#include <unordered_map>
 
 #include "ICryptoNoteProtocolQuery.h"
 #include "ICore.h"
 #include "BlockchainExplorerData.h"
+#include "core/Currency.h"
 
 namespace CryptoNote {
 
@@ -30,9 +33,13 @@ private:
 
   bool getMixin(const Transaction& transaction, uint64_t& mixin);
   bool fillTxExtra(const std::vector<uint8_t>& rawExtra, TransactionExtraDetails& extraDetails);
-  size_t median(std::vector<size_t>& v);
+  bool getBlockRewardInfo(const Block& block, const Crypto::Hash& hash, uint32_t height, bool isOrphaned, size_t cumulativeSize, BlockRewardInfo& info);
 
   CryptoNote::ICore& core;
   CryptoNote::ICryptoNoteProtocolQuery& protocol;
+
+  // reward info of main chain blocks, a block hash fixes all the blocks the info depends on
+  std::mutex rewardInfoCacheMutex;
+  std::unordered_map<Crypto::Hash, BlockRewardInfo> rewardInfoCache;
 };
 }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Common {
+
+// Bloom filter for uniformly distributed keys (key images, hashes) answering "definitely not present" without
+// touching the main container. All bits of a key are set in one 512 bit block, so a check reads one cache line.
+// Keys can't be removed, removed() only counts keys whose bits stay set, the owner rebuilds the filter
+// from its container when needsRebuild() tells it has become too full or too stale.
+template<typename Key>
+class BlockedBloomFilter {
+  static_assert(sizeof(Key) >= 32, "BlockedBloomFilter key must be at least 32 bytes long");
+
+  static const size_t WORDS_PER_BLOCK = 8;
+  static const size_t BITS_PER_KEY = 16;
+  static const size_t MIN_KEYS = 1024;
+
+public:
+  explicit BlockedBloomFilter(size_t expectedCount = 0) {
+    clear(expectedCount);
+  }
+
+  // empties the filter and sizes it for expectedCount keys
+  void clear(size_t expectedCount) {
+    m_capacity = std::max(expectedCount, MIN_KEYS);
+    size_t blockCount = (m_capacity * BITS_PER_KEY + WORDS_PER_BLOCK * 64 - 1) / (WORDS_PER_BLOCK * 64);
+    m_words.assign(blockCount * WORDS_PER_BLOCK, 0);
+    m_words.shrink_to_fit();
+    m_count = 0;
+    m_removed = 0;
+  }
+
+  void add(const Key& key) {
+    uint64_t* block = blockFor(key);
+    uint64_t probes = word(key, 16);
+    for (unsigned i = 0; i < 7; ++i, probes >>= 9) {
+      setBit(block, probes & 511);
+    }
+
+    setBit(block, word(key, 24) & 511);
+    ++m_count;
+  }
+
+  void removed() {
+    ++m_removed;
+  }
+
+  bool mayContain(const Key& key) const {
+    const uint64_t* block = blockFor(key);
+    uint64_t probes = word(key, 16);
+    for (unsigned i = 0; i < 7; ++i, probes >>= 9) {
+      if (!testBit(block, probes & 511)) {
+        return false;
+      }
+    }
+
+    return testBit(block, word(key, 24) & 511);
+  }
+
+  bool needsRebuild() const {
+    return m_count >= m_capacity || (m_removed > MIN_KEYS && m_removed > m_count / 2);
+  }
+
+  size_t memoryUsage() const {
+    return m_words.size() * sizeof(uint64_t);
+  }
+
+private:
+  static uint64_t word(const Key& key, size_t offset) {
+    uint64_t value;
+    std::memcpy(&value, reinterpret_cast<const uint8_t*>(&key) + offset, sizeof(value));
+    return value;
+  }
+
+  size_t blockIndex(const Key& key) const {
+    // maps 32 random bits to [0, blockCount) without division
+    uint64_t blockCount = m_words.size() / WORDS_PER_BLOCK;
+    return static_cast<size_t>(((word(key, 8) & 0xFFFFFFFF) * blockCount) >> 32);
+  }
+
+  uint64_t* blockFor(const Key& key) {
+    return &m_words[blockIndex(key) * WORDS_PER_BLOCK];
+  }
+
+  const uint64_t* blockFor(const Key& key) const {
+    return &m_words[blockIndex(key) * WORDS_PER_BLOCK];
+  }
+
+  static void setBit(uint64_t* block, uint64_t bit) {
+    block[bit >> 6] |= uint64_t(1) << (bit & 63);
+  }
+
+  static bool testBit(const uint64_t* block, uint64_t bit) {
+    return (block[bit >> 6] & (uint64_t(1) << (bit & 63))) != 0;
+  }
+
+  std::vector<uint64_t> m_words;
+  size_t m_capacity;
+  size_t m_count;
+  size_t m_removed;
+};
+
+}
@@ -270,6 +270,9 @@ public:
   uint8_t* suffix();
   uint64_t suffixSize() const;
   void resizeSuffix(uint64_t newSuffixSize);
+  // Grows the suffix in place without copying the file. Unlike resizeSuffix() it is not atomic,
+  // the caller must be able to detect a partially written tail. Only the appended range is flushed.
+  void appendToSuffix(const uint8_t* data, uint64_t dataSize);
 
   void rename(const std::string& newPath, std::error_code& ec);
   void rename(const std::string& newPath);
@@ -707,6 +710,22 @@ void FileMappedVector<T>::resizeSuffix(uint64_t newSuffixSize) {
   }
 }
 
+template<class T>
+void FileMappedVector<T>::appendToSuffix(const uint8_t* data, uint64_t dataSize) {
+  assert(isOpened());
+
+  if (dataSize == 0) {
+    return;
+  }
+
+  uint64_t oldSuffixSize = suffixSize();
+  m_file.resize(m_file.size() + dataSize);
+  m_suffixSize += dataSize;
+
+  std::copy(data, data + dataSize, suffixPtr() + oldSuffixSize);
+  m_file.flush(suffixPtr() + oldSuffixSize, dataSize);
+}
+
 template<class T>
 void FileMappedVector<T>::rename(const std::string& newPath, std::error_code& ec) {
   m_file.rename(newPath, ec);
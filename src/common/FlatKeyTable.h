@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLAT_KEY_TABLE_SSE2
+#endif
+
+namespace Common {
+
+// Open addressing hash table for uniformly distributed keys, such as hashes, key images and public keys.
+// Key bytes are used as the hash: bytes 0..7 select the position, byte 8 is kept as a 7 bit tag in a control byte per slot.
+// Control bytes are probed 16 at a time (with SSE2 where available), so most lookups touch one group and one slot.
+// Slots are stored inline, the key is obtained from a slot by KeyOfSlot, which allows slots holding only a reference
+// to a key stored elsewhere (e.g. an index in a vector); the full key is always compared after a tag match.
+template<typename Key, typename Slot, typename KeyOfSlot>
+class FlatKeyTable {
+  static_assert(sizeof(Key) >= 9, "FlatKeyTable key must be at least 9 bytes long");
+
+  static const uint8_t EMPTY = 0x80;
+  static const uint8_t DELETED = 0xFE;
+  static const size_t GROUP_SIZE = 16;
+  static const size_t MIN_CAPACITY = GROUP_SIZE;
+
+public:
+  typedef Key key_type;
+  typedef Slot value_type;
+
+  template<typename TableT, typename SlotT>
+  class basic_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef SlotT value_type;
+    typedef ptrdiff_t difference_type;
+    typedef SlotT* pointer;
+    typedef SlotT& reference;
+
+    basic_iterator() : m_table(nullptr), m_index(0) {
+    }
+
+    basic_iterator(TableT* table, size_t index) : m_table(table), m_index(index) {
+    }
+
+    template<typename OtherTableT, typename OtherSlotT>
+    basic_iterator(const basic_iterator<OtherTableT, OtherSlotT>& other) : m_table(other.m_table), m_index(other.m_index) {
+    }
+
+    reference operator*() const {
+      return m_table->m_slots[m_index];
+    }
+
+    pointer operator->() const {
+      return &m_table->m_slots[m_index];
+    }
+
+    basic_iterator& operator++() {
+      m_index = m_table->nextFull(m_index + 1);
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      basic_iterator result = *this;
+      ++*this;
+      return result;
+    }
+
+    bool operator==(const basic_iterator& other) const {
+      return m_index == other.m_index;
+    }
+
+    bool operator!=(const basic_iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+  private:
+    template<typename, typename> friend class basic_iterator;
+    friend class FlatKeyTable;
+
+    TableT* m_table;
+    size_t m_index;
+  };
+
+  typedef basic_iterator<FlatKeyTable, Slot> iterator;
+  typedef basic_iterator<const FlatKeyTable, const Slot> const_iterator;
+
+  explicit FlatKeyTable(KeyOfSlot keyOfSlot = KeyOfSlot()) : m_keyOfSlot(keyOfSlot), m_size(0), m_deleted(0) {
+    allocate(MIN_CAPACITY);
+  }
+
+  iterator begin() {
+    return iterator(this, nextFull(0));
+  }
+
+  iterator end() {
+    return iterator(this, capacity());
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, nextFull(0));
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, capacity());
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  bool empty() const {
+    return m_size == 0;
+  }
+
+  size_t capacity() const {
+    return m_slots.size();
+  }
+
+  // approximate heap memory used by the table
+  size_t memoryUsage() const {
+    return capacity() * sizeof(Slot) + capacity() + GROUP_SIZE;
+  }
+
+  void clear() {
+    allocate(MIN_CAPACITY);
+  }
+
+  void reserve(size_t count) {
+    size_t required = capacityFor(count);
+    if (required > capacity()) {
+      rehash(required);
+    }
+  }
+
+  iterator find(const Key& key) {
+    return iterator(this, findIndex(key));
+  }
+
+  const_iterator find(const Key& key) const {
+    return const_iterator(this, findIndex(key));
+  }
+
+  size_t count(const Key& key) const {
+    return findIndex(key) != capacity() ? 1 : 0;
+  }
+
+  std::pair<iterator, bool> insert(const Slot& slot) {
+    const Key& key = m_keyOfSlot(slot);
+    size_t index = findIndex(key);
+    if (index != capacity()) {
+      return std::make_pair(iterator(this, index), false);
+    }
+
+    if (m_size + m_deleted + 1 > maxLoad(capacity())) {
+      // a table full of tombstones is cleaned at the same size
+      rehash(m_size + 1 > maxLoad(capacity()) / 2 ? capacity() * 2 : capacity());
+    }
+
+    index = findInsertIndex(key);
+    if (m_control[index] == DELETED) {
+      --m_deleted;
+    }
+
+    m_slots[index] = slot;
+    setControl(index, tag(key));
+    ++m_size;
+    return std::make_pair(iterator(this, index), true);
+  }
+
+  size_t erase(const Key& key) {
+    size_t index = findIndex(key);
+    if (index == capacity()) {
+      return 0;
+    }
+
+    erase(iterator(this, index));
+    return 1;
+  }
+
+  void erase(iterator it) {
+    assert(it.m_table == this && it.m_index < capacity());
+    m_slots[it.m_index] = Slot();
+    setControl(it.m_index, DELETED);
+    --m_size;
+    ++m_deleted;
+  }
+
+protected:
+  KeyOfSlot m_keyOfSlot;
+
+private:
+  static size_t maxLoad(size_t capacity) {
+    return capacity - capacity / 8;
+  }
+
+  static size_t capacityFor(size_t count) {
+    size_t capacity = MIN_CAPACITY;
+    while (maxLoad(capacity) < count) {
+      capacity *= 2;
+    }
+
+    return capacity;
+  }
+
+  static uint64_t position(const Key& key) {
+    uint64_t value;
+    std::memcpy(&value, &key, sizeof(value));
+    return value;
+  }
+
+  static uint8_t tag(const Key& key) {
+    return reinterpret_cast<const uint8_t*>(&key)[8] & 0x7F;
+  }
+
+  static bool keysEqual(const Key& key1, const Key& key2) {
+    return std::memcmp(&key1, &key2, sizeof(Key)) == 0;
+  }
+
+  // bit i is set if control byte i of the group at index equals value
+  uint32_t matchGroup(size_t index, uint8_t value) const {
+#ifdef FLAT_KEY_TABLE_SSE2
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_control[index]));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(value)))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_SIZE; ++i) {
+      mask |= static_cast<uint32_t>(m_control[index + i] == value) << i;
+    }
+
+    return mask;
+#endif
+  }
+
+  // bit i is set if control byte i of the group at index is empty or deleted, both have the high bit set
+  uint32_t matchFree(size_t index) const {
+#ifdef FLAT_KEY_TABLE_SSE2
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_control[index]))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_SIZE; ++i) {
+      mask |= static_cast<uint32_t>(m_control[index + i] >> 7) << i;
+    }
+
+    return mask;
+#endif
+  }
+
+  static unsigned lowestBit(uint32_t mask) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned bit = 0;
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      ++bit;
+    }
+
+    return bit;
+#endif
+  }
+
+  // returns capacity() if the key isn't in the table
+  size_t findIndex(const Key& key) const {
+    size_t mask = capacity() - 1;
+    uint8_t keyTag = tag(key);
+    size_t index = static_cast<size_t>(position(key)) & mask;
+    for (size_t step = GROUP_SIZE;; step += GROUP_SIZE) {
+      for (uint32_t matches = matchGroup(index, keyTag); matches != 0; matches &= matches - 1) {
+        size_t slotIndex = (index + lowestBit(matches)) & mask;
+        if (keysEqual(m_keyOfSlot(m_slots[slotIndex]), key)) {
+          return slotIndex;
+        }
+      }
+
+      if (matchGroup(index, EMPTY) != 0) {
+        return capacity();
+      }
+
+      index = (index + step) & mask;
+    }
+  }
+
+  size_t findInsertIndex(const Key& key) const {
+    size_t mask = capacity() - 1;
+    size_t index = static_cast<size_t>(position(key)) & mask;
+    for (size_t step = GROUP_SIZE;; step += GROUP_SIZE) {
+      uint32_t free = matchFree(index);
+      if (free != 0) {
+        return (index + lowestBit(free)) & mask;
+      }
+
+      index = (index + step) & mask;
+    }
+  }
+
+  size_t nextFull(size_t index) const {
+    while (index < capacity() && (m_control[index] & 0x80) != 0) {
+      ++index;
+    }
+
+    return index;
+  }
+
+  // the first GROUP_SIZE - 1 control bytes are mirrored after the end, so a group can be loaded at any index
+  void setControl(size_t index, uint8_t value) {
+    m_control[index] = value;
+    if (index < GROUP_SIZE - 1) {
+      m_control[capacity() + index] = value;
+    }
+  }
+
+  void allocate(size_t newCapacity) {
+    m_slots.assign(newCapacity, Slot());
+    m_slots.shrink_to_fit();
+    m_control.reset(new uint8_t[newCapacity + GROUP_SIZE]);
+    std::memset(m_control.get(), EMPTY, newCapacity + GROUP_SIZE);
+    m_size = 0;
+    m_deleted = 0;
+  }
+
+  void rehash(size_t newCapacity) {
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(m_slots);
+    std::unique_ptr<uint8_t[]> oldControl = std::move(m_control);
+
+    allocate(newCapacity);
+    for (size_t i = 0; i < oldSlots.size(); ++i) {
+      if ((oldControl[i] & 0x80) == 0) {
+        const Key& key = m_keyOfSlot(oldSlots[i]);
+        size_t index = findInsertIndex(key);
+        m_slots[index] = oldSlots[i];
+        setControl(index, tag(key));
+        ++m_size;
+      }
+    }
+  }
+
+  std::vector<Slot> m_slots;
+  std::unique_ptr<uint8_t[]> m_control;
+  size_t m_size;
+  size_t m_deleted;
+};
+
+template<typename Key, typename Value>
+struct FlatKeyMapKeyOf {
+  const Key& operator()(const std::pair<Key, Value>& slot) const {
+    return slot.first;
+  }
+};
+
+template<typename Key, typename Value>
+class FlatKeyMap : public FlatKeyTable<Key, std::pair<Key, Value>, FlatKeyMapKeyOf<Key, Value>> {
+public:
+  typedef Value mapped_type;
+
+  Value& at(const Key& key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("FlatKeyMap::at");
+    }
+
+    return it->second;
+  }
+
+  const Value& at(const Key& key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw std::out_of_range("FlatKeyMap::at");
+    }
+
+    return it->second;
+  }
+};
+
+}
@@ -0,0 +1,217 @@
+#include "Metrics.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace Common {
+
+namespace {
+
+uint64_t toBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double fromBits(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+std::string labelSet(const std::string& labels, const std::string& extra = std::string()) {
+  if (labels.empty() && extra.empty()) {
+    return std::string();
+  }
+
+  if (labels.empty() || extra.empty()) {
+    return "{" + labels + extra + "}";
+  }
+
+  return "{" + labels + "," + extra + "}";
+}
+
+}
+
+MetricsCounter::MetricsCounter() : m_value(0) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MetricsCounter::increment(uint64_t value) {
+  m_value.fetch_add(value, std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MetricsCounter::advanceTo(uint64_t total) {
+  uint64_t value = m_value.load(std::memory_order_relaxed);
+  while (value < total && !m_value.compare_exchange_weak(value, total, std::memory_order_relaxed)) {
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t MetricsCounter::get() const {
+  return m_value.load(std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsGauge::MetricsGauge() : m_value(0) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MetricsGauge::set(int64_t value) {
+  m_value.store(value, std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MetricsGauge::add(int64_t value) {
+  m_value.fetch_add(value, std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+int64_t MetricsGauge::get() const {
+  return m_value.load(std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsHistogram::MetricsHistogram(const std::vector<double>& bounds) :
+  m_bounds(bounds), m_buckets(new std::atomic<uint64_t>[bounds.size() + 1]), m_count(0), m_sumBits(toBits(0.0)) {
+  for (size_t i = 0; i <= m_bounds.size(); ++i) {
+    m_buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void MetricsHistogram::observe(double value) {
+  size_t bucket = 0;
+  while (bucket < m_bounds.size() && value > m_bounds[bucket]) {
+    ++bucket;
+  }
+
+  m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t oldBits = m_sumBits.load(std::memory_order_relaxed);
+  while (!m_sumBits.compare_exchange_weak(oldBits, toBits(fromBits(oldBits) + value), std::memory_order_relaxed)) {
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t MetricsHistogram::cumulativeCount(size_t index) const {
+  uint64_t result = 0;
+  for (size_t i = 0; i <= index && i <= m_bounds.size(); ++i) {
+    result += m_buckets[i].load(std::memory_order_relaxed);
+  }
+
+  return result;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t MetricsHistogram::count() const {
+  return m_count.load(std::memory_order_relaxed);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+double MetricsHistogram::sum() const {
+  return fromBits(m_sumBits.load(std::memory_order_relaxed));
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsTimer::MetricsTimer(MetricsHistogram& histogram) : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsTimer::~MetricsTimer() {
+  m_histogram.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsRegistry& MetricsRegistry::instance() {
+  static MetricsRegistry registry;
+  return registry;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsCounter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& metric = family(name, help, MetricType::COUNTER).counters[labels];
+  if (!metric) {
+    metric.reset(new MetricsCounter());
+  }
+
+  return *metric;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& metric = family(name, help, MetricType::GAUGE).gauges[labels];
+  if (!metric) {
+    metric.reset(new MetricsGauge());
+  }
+
+  return *metric;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels,
+  const std::vector<double>& bounds) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& metric = family(name, help, MetricType::HISTOGRAM).histograms[labels];
+  if (!metric) {
+    metric.reset(new MetricsHistogram(bounds));
+  }
+
+  return *metric;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+std::string MetricsRegistry::format() const {
+  std::ostringstream stream;
+  stream.precision(9);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const auto& kv : m_families) {
+    const std::string& name = kv.first;
+    const Family& family = kv.second;
+
+    stream << "# HELP " << name << " " << family.help << "\n";
+    switch (family.type) {
+    case MetricType::COUNTER:
+      stream << "# TYPE " << name << " counter\n";
+      for (const auto& metric : family.counters) {
+        stream << name << labelSet(metric.first) << " " << metric.second->get() << "\n";
+      }
+      break;
+
+    case MetricType::GAUGE:
+      stream << "# TYPE " << name << " gauge\n";
+      for (const auto& metric : family.gauges) {
+        stream << name << labelSet(metric.first) << " " << metric.second->get() << "\n";
+      }
+      break;
+
+    case MetricType::HISTOGRAM:
+      stream << "# TYPE " << name << " histogram\n";
+      for (const auto& metric : family.histograms) {
+        const MetricsHistogram& histogram = *metric.second;
+        for (size_t i = 0; i < histogram.bounds().size(); ++i) {
+          std::ostringstream bound;
+          bound << "le=\"" << histogram.bounds()[i] << "\"";
+          stream << name << "_bucket" << labelSet(metric.first, bound.str()) << " " << histogram.cumulativeCount(i) << "\n";
+        }
+
+        stream << name << "_bucket" << labelSet(metric.first, "le=\"+Inf\"") << " " << histogram.cumulativeCount(histogram.bounds().size()) << "\n";
+        stream << name << "_sum" << labelSet(metric.first) << " " << histogram.sum() << "\n";
+        stream << name << "_count" << labelSet(metric.first) << " " << histogram.count() << "\n";
+      }
+      break;
+    }
+  }
+
+  return stream.str();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const std::vector<double>& MetricsRegistry::latencyBounds() {
+  static const std::vector<double> bounds = { 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10 };
+  return bounds;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, MetricType type) {
+  auto it = m_families.find(name);
+  if (it == m_families.end()) {
+    Family& family = m_families[name];
+    family.type = type;
+    family.help = help;
+    return family;
+  }
+
+  if (it->second.type != type) {
+    throw std::runtime_error("Metric " + name + " is already registered with another type");
+  }
+
+  return it->second;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Common {
+
+class MetricsCounter {
+public:
+  MetricsCounter();
+
+  void increment(uint64_t value = 1);
+  // for totals counted elsewhere and sampled on scrape, never moves the counter back
+  void advanceTo(uint64_t total);
+  uint64_t get() const;
+
+private:
+  std::atomic<uint64_t> m_value;
+};
+
+class MetricsGauge {
+public:
+  MetricsGauge();
+
+  void set(int64_t value);
+  void add(int64_t value);
+  int64_t get() const;
+
+private:
+  std::atomic<int64_t> m_value;
+};
+
+// Histogram with fixed bucket upper bounds, observe() doesn't take locks
+class MetricsHistogram {
+public:
+  explicit MetricsHistogram(const std::vector<double>& bounds);
+
+  void observe(double value);
+
+  const std::vector<double>& bounds() const { return m_bounds; }
+  // cumulative count of observations not greater than bounds()[index], index == bounds().size() is +Inf
+  uint64_t cumulativeCount(size_t index) const;
+  uint64_t count() const;
+  double sum() const;
+
+private:
+  const std::vector<double> m_bounds;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_buckets;
+  std::atomic<uint64_t> m_count;
+  std::atomic<uint64_t> m_sumBits;
+};
+
+// Observes the time from construction to destruction in seconds
+class MetricsTimer {
+public:
+  explicit MetricsTimer(MetricsHistogram& histogram);
+  ~MetricsTimer();
+
+  MetricsTimer(const MetricsTimer&) = delete;
+  MetricsTimer& operator=(const MetricsTimer&) = delete;
+
+private:
+  MetricsHistogram& m_histogram;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+// Process wide set of metrics. A metric is identified by its name and labels (e.g. "method=\"getinfo\""),
+// requesting an existing one returns the same object, so references can be kept for the process lifetime.
+class MetricsRegistry {
+public:
+  static MetricsRegistry& instance();
+
+  MetricsCounter& counter(const std::string& name, const std::string& help, const std::string& labels = std::string());
+  MetricsGauge& gauge(const std::string& name, const std::string& help, const std::string& labels = std::string());
+  MetricsHistogram& histogram(const std::string& name, const std::string& help, const std::string& labels = std::string(),
+    const std::vector<double>& bounds = latencyBounds());
+
+  // Prometheus text exposition format
+  std::string format() const;
+
+  // bucket bounds in seconds suitable for request and block processing times
+  static const std::vector<double>& latencyBounds();
+
+private:
+  enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+  struct Family {
+    MetricType type;
+    std::string help;
+    std::map<std::string, std::unique_ptr<MetricsCounter>> counters;
+    std::map<std::string, std::unique_ptr<MetricsGauge>> gauges;
+    std::map<std::string, std::unique_ptr<MetricsHistogram>> histograms;
+  };
+
+  MetricsRegistry() = default;
+
+  Family& family(const std::string& name, const std::string& help, MetricType type);
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Family> m_families;
+};
+
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Common {
+
+// Bounded lock free queue, any thread may push and pop.
+// Each cell carries a sequence number telling whether it is ready for the next push or pop.
+// try* calls never block; push() and pop() yield a few times, then sleep until the queue has space or values,
+// only threads which found it full or empty touch the mutex, and a notification is sent only if one is waiting.
+template<typename T>
+class MpmcQueue {
+  static const unsigned SPIN_COUNT = 64;
+
+public:
+  explicit MpmcQueue(size_t capacity) :
+    m_mask(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1),
+    m_cells(new Cell[m_mask + 1]),
+    m_pushPosition(0),
+    m_popPosition(0),
+    m_closed(false),
+    m_waitingPushers(0),
+    m_waitingPoppers(0) {
+    for (size_t i = 0; i <= m_mask; ++i) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // returns false if the queue is full
+  bool tryPush(T&& value) {
+    if (!pushValue(value)) {
+      return false;
+    }
+
+    notifyPoppers(false);
+    return true;
+  }
+
+  // returns false if the queue is empty
+  bool tryPop(T& value) {
+    if (!popValue(value)) {
+      return false;
+    }
+
+    notifyPushers(false);
+    return true;
+  }
+
+  // moves values from the front of the array while there is space, returns how many were pushed
+  size_t tryPush(T* values, size_t count) {
+    size_t pushed = 0;
+    while (pushed < count && pushValue(values[pushed])) {
+      ++pushed;
+    }
+
+    if (pushed != 0) {
+      notifyPoppers(pushed > 1);
+    }
+
+    return pushed;
+  }
+
+  // pops up to count values into the array, returns how many were popped
+  size_t tryPop(T* values, size_t count) {
+    size_t popped = 0;
+    while (popped < count && popValue(values[popped])) {
+      ++popped;
+    }
+
+    if (popped != 0) {
+      notifyPushers(popped > 1);
+    }
+
+    return popped;
+  }
+
+  // waits while the queue is full, returns false if it is closed
+  bool push(T&& value) {
+    for (unsigned spin = 0;; ++spin) {
+      if (m_closed.load(std::memory_order_acquire)) {
+        return false;
+      }
+
+      if (tryPush(std::move(value))) {
+        return true;
+      }
+
+      if (spin < SPIN_COUNT) {
+        std::this_thread::yield();
+      } else {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waitingPushers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_closed.load() && isFull()) {
+          m_notFull.wait(lock);
+        }
+
+        m_waitingPushers.fetch_sub(1);
+      }
+    }
+  }
+
+  // waits while the queue is empty, returns false once it is closed and empty
+  bool pop(T& value) {
+    for (unsigned spin = 0;; ++spin) {
+      if (tryPop(value)) {
+        return true;
+      }
+
+      if (m_closed.load(std::memory_order_acquire)) {
+        // a value pushed before close() is still taken
+        return tryPop(value);
+      }
+
+      if (spin < SPIN_COUNT) {
+        std::this_thread::yield();
+      } else {
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waitingPoppers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_closed.load() && empty()) {
+          m_notEmpty.wait(lock);
+        }
+
+        m_waitingPoppers.fetch_sub(1);
+      }
+    }
+  }
+
+  // pushing fails from now on, popping drains the values left; a push racing with close() may succeed
+  // after the last pop has returned false, so producers should close the queue once they have finished
+  void close() {
+    m_closed.store(true);
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+  }
+
+  bool closed() const {
+    return m_closed.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    size_t position = m_popPosition.load(std::memory_order_relaxed);
+    return static_cast<intptr_t>(m_cells[position & m_mask].sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position + 1) < 0;
+  }
+
+  size_t capacity() const {
+    return m_mask + 1;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+
+    return result;
+  }
+
+  bool isFull() const {
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    return static_cast<intptr_t>(m_cells[position & m_mask].sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position) < 0;
+  }
+
+  bool pushValue(T& value) {
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = m_cells[position & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = m_pushPosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool popValue(T& value) {
+    size_t position = m_popPosition.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = m_cells[position & m_mask];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+      if (difference == 0) {
+        if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = std::move(cell.value);
+          cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = m_popPosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // a waiter registers before its last check under the mutex, the fence orders that check against this load
+  void notifyPoppers(bool all) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waitingPoppers.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(m_waitMutex);
+      if (all) {
+        m_notEmpty.notify_all();
+      } else {
+        m_notEmpty.notify_one();
+      }
+    }
+  }
+
+  void notifyPushers(bool all) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waitingPushers.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(m_waitMutex);
+      if (all) {
+        m_notFull.notify_all();
+      } else {
+        m_notFull.notify_one();
+      }
+    }
+  }
+
+  const size_t m_mask;
+  std::unique_ptr<Cell[]> m_cells;
+  alignas(64) std::atomic<size_t> m_pushPosition;
+  alignas(64) std::atomic<size_t> m_popPosition;
+  alignas(64) std::atomic<bool> m_closed;
+  std::atomic<size_t> m_waitingPushers;
+  std::atomic<size_t> m_waitingPoppers;
+  std::mutex m_waitMutex;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+};
+
+}
@@ -0,0 +1,5 @@
+#include "SlidingWindowMedian.h"
+
+namespace {
+char suppressMSVCWarningLNK4221;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <set>
+
+namespace Common {
+
+// Keeps the last `windowSize` values of a sequence and their median.
+// The window can be moved in both directions: pushBack() appends a value and drops
+// the oldest one when the window is full, popBack()/pushFront() undo that.
+// median() returns the same value as medianValue() over the window contents.
+template <class T> class SlidingWindowMedian {
+public:
+  explicit SlidingWindowMedian(size_t windowSize);
+
+  void pushBack(const T& value);
+  void popBack();
+  void pushFront(const T& value);
+  void popFront();
+  void clear();
+
+  T median() const;
+  size_t size() const { return m_values.size(); }
+  size_t windowSize() const { return m_windowSize; }
+  bool empty() const { return m_values.empty(); }
+
+private:
+  void insert(const T& value);
+  void erase(const T& value);
+  void rebalance();
+
+  const size_t m_windowSize;
+  std::deque<T> m_values;
+  // m_low holds the smaller half of the values and is never smaller than m_high
+  std::multiset<T> m_low;
+  std::multiset<T> m_high;
+};
+
+template <class T>
+SlidingWindowMedian<T>::SlidingWindowMedian(size_t windowSize) : m_windowSize(windowSize) {
+  assert(windowSize > 0);
+}
+
+template <class T>
+void SlidingWindowMedian<T>::pushBack(const T& value) {
+  if (m_values.size() == m_windowSize) {
+    popFront();
+  }
+
+  m_values.push_back(value);
+  insert(value);
+}
+
+template <class T>
+void SlidingWindowMedian<T>::popBack() {
+  assert(!m_values.empty());
+  erase(m_values.back());
+  m_values.pop_back();
+}
+
+template <class T>
+void SlidingWindowMedian<T>::pushFront(const T& value) {
+  assert(m_values.size() < m_windowSize);
+  m_values.push_front(value);
+  insert(value);
+}
+
+template <class T>
+void SlidingWindowMedian<T>::popFront() {
+  assert(!m_values.empty());
+  erase(m_values.front());
+  m_values.pop_front();
+}
+
+template <class T>
+void SlidingWindowMedian<T>::clear() {
+  m_values.clear();
+  m_low.clear();
+  m_high.clear();
+}
+
+template <class T>
+T SlidingWindowMedian<T>::median() const {
+  if (m_values.empty()) {
+    return T();
+  }
+
+  if (m_low.size() > m_high.size()) {
+    return *m_low.rbegin();
+  }
+
+  return (*m_low.rbegin() + *m_high.begin()) / 2;
+}
+
+template <class T>
+void SlidingWindowMedian<T>::insert(const T& value) {
+  if (m_low.empty() || !(*m_low.rbegin() < value)) {
+    m_low.insert(value);
+  } else {
+    m_high.insert(value);
+  }
+
+  rebalance();
+}
+
+template <class T>
+void SlidingWindowMedian<T>::erase(const T& value) {
+  if (!(*m_low.rbegin() < value)) {
+    m_low.erase(m_low.find(value));
+  } else {
+    m_high.erase(m_high.find(value));
+  }
+
+  rebalance();
+}
+
+template <class T>
+void SlidingWindowMedian<T>::rebalance() {
+  if (m_low.size() > m_high.size() + 1) {
+    auto it = std::prev(m_low.end());
+    m_high.insert(*it);
+    m_low.erase(it);
+  } else if (m_high.size() > m_low.size()) {
+    auto it = m_high.begin();
+    m_low.insert(*it);
+    m_high.erase(it);
+  }
+}
+
+}
@@ -0,0 +1,141 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "Metrics.h"
+
+namespace Common {
+
+namespace {
+
+// process wide totals over all pools
+struct ThreadPoolMetrics {
+  ThreadPoolMetrics() :
+    tasks(MetricsRegistry::instance().counter("thread_pool_tasks_total", "Tasks run by thread pool workers")),
+    queued(MetricsRegistry::instance().gauge("thread_pool_queued_tasks", "Tasks waiting for a thread pool worker")) {
+  }
+
+  MetricsCounter& tasks;
+  MetricsGauge& queued;
+};
+
+ThreadPoolMetrics& threadPoolMetrics() {
+  static ThreadPoolMetrics metrics;
+  return metrics;
+}
+
+size_t configuredThreadCount() {
+  const char* setting = getenv("THREAD_POOL_THREADS");
+  if (setting == nullptr) {
+    return 0;
+  }
+
+  return static_cast<size_t>(strtoul(setting, nullptr, 10));
+}
+
+bool configuredAffinity() {
+  const char* setting = getenv("THREAD_POOL_AFFINITY");
+  return setting != nullptr && strcmp(setting, "1") == 0;
+}
+
+void pinToCore(size_t index) {
+#ifdef __linux__
+  unsigned cores = std::thread::hardware_concurrency();
+  if (cores == 0) {
+    return;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(static_cast<int>(index % cores), &set);
+  // failure leaves the thread unpinned, e.g. when the process is restricted to fewer cores
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)index;
+#endif
+}
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+ThreadPool& ThreadPool::instance() {
+  static ThreadPool pool(configuredThreadCount(), configuredAffinity());
+  return pool;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+ThreadPool::ThreadPool(size_t threadCount, bool pinThreads) : stopping(false) {
+  // metrics are created first, so they outlive instance() and its workers at exit
+  threadPoolMetrics();
+  if (threadCount == 0) {
+    threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  workers.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers.emplace_back(&ThreadPool::workerProcedure, this, i, pinThreads);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void ThreadPool::post(std::function<void()>&& procedure) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(!stopping);
+    tasks.push_back(std::move(procedure));
+  }
+
+  threadPoolMetrics().queued.add(1);
+  condition.notify_one();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t ThreadPool::getThreadCount() const {
+  return workers.size();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void ThreadPool::workerProcedure(size_t index, bool pinThread) {
+  if (pinThread) {
+    pinToCore(index);
+  }
+
+  ThreadPoolMetrics& metrics = threadPoolMetrics();
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+
+    metrics.queued.add(-1);
+    metrics.tasks.increment();
+    try {
+      task();
+    } catch (...) {
+    }
+  }
+}
+
+}
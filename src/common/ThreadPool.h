@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Common {
+
+// Fixed set of threads, one per core by default, running tasks from a shared queue.
+// instance() is the process wide pool for CPU bound work, it is created on first use with THREAD_POOL_THREADS workers
+// (std::thread::hardware_concurrency() if unset), pinned to cores if THREAD_POOL_AFFINITY=1.
+// Tasks run in submission order but not one after another, so a task must not wait for a task submitted after it.
+// Code waiting for its tasks should take a share of the work itself, it then progresses even if all workers are busy.
+class ThreadPool {
+public:
+  static ThreadPool& instance();
+
+  // threadCount 0 selects std::thread::hardware_concurrency(), pinThreads binds worker i to core i modulo core count
+  explicit ThreadPool(size_t threadCount = 0, bool pinThreads = false);
+  ThreadPool(const ThreadPool&) = delete;
+  // runs tasks already queued and waits for them
+  ~ThreadPool();
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // the future gets the result of the function or the exception it has thrown
+  template<typename Function>
+  std::future<typename std::result_of<Function()>::type> submit(Function&& function) {
+    typedef typename std::result_of<Function()>::type Result;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+    std::future<Result> result = task->get_future();
+    post([task] { (*task)(); });
+    return result;
+  }
+
+  // an exception thrown by the procedure is dropped
+  void post(std::function<void()>&& procedure);
+  size_t getThreadCount() const;
+
+private:
+  void workerProcedure(size_t index, bool pinThread);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::function<void()>> tasks;
+  bool stopping;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "Core.h"
 
+#include <algorithm>
 #include <sstream>
 #include <unordered_set>
 #include "CryptoNoteConfig.h"
@@ -28,6 +29,25 @@ using namespace  Common;
 
 namespace CryptoNote {
 
+namespace {
+
+const size_t QUERY_BLOCKS_LITE_CACHE_SIZE = 256;
+const size_t POOL_CHANGES_LITE_CACHE_SIZE = 1024;
+
+Crypto::Hash getPoolChangesKey(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds) {
+  std::vector<Crypto::Hash> ids;
+  ids.reserve(knownTxsIds.size() + 1);
+  ids.push_back(tailBlockId);
+  ids.insert(ids.end(), knownTxsIds.begin(), knownTxsIds.end());
+  std::sort(ids.begin() + 1, ids.end(), [](const Crypto::Hash& a, const Crypto::Hash& b) {
+    return memcmp(a.data, b.data, sizeof(a.data)) < 0;
+  });
+
+  return Crypto::cn_fast_hash(ids.data(), ids.size() * sizeof(Crypto::Hash));
+}
+
+}
+
 class BlockWithTransactions : public IBlock {
 	
 public:
@@ -59,7 +79,11 @@ core::core(const Currency& currency, i_cryptonote_protocol* pprotocol, Logging::
   m_mempool(currency, m_blockchain, m_timeProvider, logger, blockchainIndexesEnabled),
   m_blockchain(currency, m_mempool, logger, blockchainIndexesEnabled),
   m_miner(new miner(currency, *this, logger)),
-  m_starter_message_showed(false) {
+  m_starter_message_showed(false),
+  m_blockchainVersion(1),
+  m_poolVersion(1),
+  m_queryBlocksLiteCache(QUERY_BLOCKS_LITE_CACHE_SIZE),
+  m_poolChangesLiteCache(POOL_CHANGES_LITE_CACHE_SIZE) {
 
   set_cryptonote_protocol(pprotocol);
   m_blockchain.addObserver(this);
@@ -132,6 +156,7 @@ bool core::init(const CoreConfig& config, const MinerConfig& minerConfig, bool l
     return false;
   }
 
+  m_blockchain.setPruningDepth(config.pruneBlockchain ? config.pruneDepth : 0);
   r = m_blockchain.init(m_config_folder, load_existing);
   if (!(r)) {
     logger(ERROR, BRIGHT_RED) << "Failed to initialize blockchain storage";
@@ -538,18 +563,34 @@ bool core::getPoolChanges(const Crypto::Hash& tailBlockId, const std::vector<Cry
 bool core::getPoolChangesLite(const Crypto::Hash& tailBlockId, const std::vector<Crypto::Hash>& knownTxsIds,
         std::vector<TransactionPrefixInfo>& addedTxs, std::vector<Crypto::Hash>& deletedTxsIds) {
 
+  uint64_t version = m_poolVersion.load();
+  Crypto::Hash key = getPoolChangesKey(tailBlockId, knownTxsIds);
+
+  std::shared_ptr<const PoolChangesLiteResult> cached = m_poolChangesLiteCache.find(version, key);
+  if (cached) {
+    addedTxs.insert(addedTxs.end(), cached->addedTxs.begin(), cached->addedTxs.end());
+    deletedTxsIds.insert(deletedTxsIds.end(), cached->deletedTxsIds.begin(), cached->deletedTxsIds.end());
+    return cached->isTailBlockActual;
+  }
+
   std::vector<Transaction> added;
-  bool returnStatus = getPoolChanges(tailBlockId, knownTxsIds, added, deletedTxsIds);
+  std::shared_ptr<PoolChangesLiteResult> result = std::make_shared<PoolChangesLiteResult>();
+  result->isTailBlockActual = getPoolChanges(tailBlockId, knownTxsIds, added, result->deletedTxsIds);
 
+  result->addedTxs.reserve(added.size());
   for (const auto& tx: added) {
     TransactionPrefixInfo tpi;
     tpi.txPrefix = tx;
     tpi.txHash = getObjectHash(tx);
 
-    addedTxs.push_back(std::move(tpi));
+    result->addedTxs.push_back(std::move(tpi));
   }
 
-  return returnStatus;
+  addedTxs.insert(addedTxs.end(), result->addedTxs.begin(), result->addedTxs.end());
+  deletedTxsIds.insert(deletedTxsIds.end(), result->deletedTxsIds.begin(), result->deletedTxsIds.end());
+  m_poolChangesLiteCache.insert(version, key, result);
+
+  return result->isTailBlockActual;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void core::getPoolChanges(const std::vector<Crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
@@ -730,6 +771,9 @@ bool core::removeObserver(ICoreObserver* observer) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void core::blockchainUpdated() {
+  // new block also removes its transactions from the pool
+  ++m_blockchainVersion;
+  ++m_poolVersion;
   m_observerManager.notify(&ICoreObserver::blockchainUpdated);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -738,9 +782,38 @@ void core::txDeletedFromPool() {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void core::poolUpdated() {
+  ++m_poolVersion;
   m_observerManager.notify(&ICoreObserver::poolUpdated);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t core::getBlockchainVersion() const {
+  return m_blockchainVersion.load();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint64_t core::getPoolVersion() const {
+  return m_poolVersion.load();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats core::getQueryBlocksLiteCacheStats() const {
+  return m_queryBlocksLiteCache.getStats();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats core::getPoolChangesLiteCacheStats() const {
+  return m_poolChangesLiteCache.getStats();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats core::getVerifiedSignaturesCacheStats() const {
+  return m_blockchain.getVerifiedSignaturesCacheStats();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats core::getBlocksCacheStats() const {
+  return m_blockchain.getBlocksCacheStats();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint32_t core::getPrunedHeight() {
+  return m_blockchain.getPrunedHeight();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp,
   uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockFullInfo>& entries) {
 
@@ -785,6 +858,10 @@ bool core::queryBlocks(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t
       std::list<Transaction> txs;
       std::list<Crypto::Hash> missedTxs;
       lbs->getTransactions(b.transactionHashes, txs, missedTxs);
+      if (!missedTxs.empty()) {
+        logger(DEBUGGING) << "Can't query full block " << item.block_id << ", its transactions are pruned";
+        return false;
+      }
 
       // fill data
       block_complete_entry& completeEntry = item;
@@ -838,6 +915,7 @@ bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
   uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
   LockedBlockchainStorage lbs(m_blockchain);
 
+  uint64_t version = m_blockchainVersion.load();
   resCurrentHeight = lbs->getCurrentBlockchainHeight();
   resStartHeight = 0;
   resFullOffset = 0;
@@ -846,7 +924,25 @@ bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
     return false;
   }
 
-  std::vector<Crypto::Hash> blockIds = findIdsForShortBlocks(resStartHeight, resFullOffset);
+  QueryBlocksLiteKey key = { resCurrentHeight, resStartHeight, resFullOffset, timestamp };
+  std::shared_ptr<const std::vector<BlockShortInfo>> cached = m_queryBlocksLiteCache.find(version, key);
+  if (cached) {
+    entries = *cached;
+    return true;
+  }
+
+  std::vector<BlockShortInfo> result;
+  if (!queryBlocksLiteEntries(lbs, timestamp, resStartHeight, resFullOffset, result)) {
+    return false;
+  }
+
+  entries = result;
+  m_queryBlocksLiteCache.insert(version, key, std::make_shared<const std::vector<BlockShortInfo>>(std::move(result)));
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool core::queryBlocksLiteEntries(LockedBlockchainStorage& lbs, uint64_t timestamp, uint32_t startOffset, uint32_t fullOffset, std::vector<BlockShortInfo>& entries) {
+  std::vector<Crypto::Hash> blockIds = findIdsForShortBlocks(startOffset, fullOffset);
   entries.reserve(blockIds.size());
 
   for (const auto& id : blockIds) {
@@ -861,7 +957,7 @@ bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
   }
 
   std::list<Block> blocks;
-  lbs->getBlocks(resFullOffset, blocksLeft, blocks);
+  lbs->getBlocks(fullOffset, blocksLeft, blocks);
 
   for (auto& b : blocks) {
     BlockShortInfo item;
@@ -869,16 +965,21 @@ bool core::queryBlocksLite(const std::vector<Crypto::Hash>& knownBlockIds, uint6
     item.blockId = get_block_hash(b);
 
     if (b.timestamp >= timestamp) {
-      std::list<Transaction> txs;
+      // prefixes are served from pruned blocks too, hashes are taken from the block
+      std::list<std::pair<Crypto::Hash, TransactionPrefix>> prefixes;
       std::list<Crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
+      lbs->getTransactionPrefixes(b.transactionHashes, prefixes, missedTxs);
+      if (!missedTxs.empty()) {
+        logger(ERROR, BRIGHT_RED) << "Can't query lite block " << item.blockId << ", " << missedTxs.size() << " of its transactions are missing";
+        return false;
+      }
 
       item.block = asString(toBinaryArray(b));
 
-      for (const auto& tx: txs) {
+      for (auto& prefix : prefixes) {
         TransactionPrefixInfo info;
-        info.txPrefix = tx;
-        info.txHash = getObjectHash(tx);
+        info.txHash = prefix.first;
+        info.txPrefix = std::move(prefix.second);
 
         item.txPrefixes.push_back(std::move(info));
       }
@@ -898,6 +999,14 @@ bool core::getBlockSize(const Crypto::Hash& hash, size_t& size) {
   return m_blockchain.getBlockSize(hash, size);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool core::getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries) {
+  return m_blockchain.getBlockSummaries(startHeight, count, summaries);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool core::getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary) {
+  return m_blockchain.getBlockSummary(hash, summary);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool core::getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) {
   return m_blockchain.getAlreadyGeneratedCoins(hash, generatedCoins);
 }
@@ -907,6 +1016,10 @@ bool core::getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t c
   return m_currency.getBlockReward(blockMajorVersion, medianSize, currentBlockSize, alreadyGeneratedCoins, fee, height, reward, emissionChange);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool core::getBlockRewardInfo(uint32_t height, BlockRewardInfo& info) {
+  return m_blockchain.getBlockRewardInfo(height, info);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool core::scanOutputkeysForIndices(const KeyInput& txInToKey, std::list<std::pair<Crypto::Hash, size_t>>& outputReferences) {
   struct outputs_visitor
   {
@@ -1097,7 +1210,7 @@ std::unique_ptr<IBlock> core::getBlock(const Crypto::Hash& blockId) {
   blockPtr->transactions.reserve(blockPtr->block.transactionHashes.size());
   std::vector<Crypto::Hash> missedTxs;
   lbs->getTransactions(blockPtr->block.transactionHashes, blockPtr->transactions, missedTxs, true);
-  assert(missedTxs.empty() || !lbs->isBlockInMainChain(blockId)); //if can't find transaction for blockchain block -> error
+  assert(missedTxs.empty() || !lbs->isBlockInMainChain(blockId) || get_block_height(blockPtr->block) < lbs->getPrunedHeight()); //if can't find transaction for blockchain block -> error
 
   if (!missedTxs.empty()) {
     logger(DEBUGGING) << "Can't find transactions for block: " << blockId;
@@ -14,6 +14,7 @@
 #include "ICore.h"
 #include "ICoreObserver.h"
 #include "ObserverManager.h"
+#include "TipQueryCache.h"
 
 #include "System/Dispatcher.h"
 #include "MessageQueue.h"
@@ -58,9 +59,13 @@ namespace CryptoNote {
      virtual bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
      virtual bool getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) override;
      virtual bool getBlockSize(const Crypto::Hash& hash, size_t& size) override;
+     bool getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries);
+     // main chain block only, looked up and summarized under one blockchain lock
+     bool getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary);
      virtual bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) override;
      virtual bool getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint32_t height,
                                  uint64_t& reward, int64_t& emissionChange);
+     bool getBlockRewardInfo(uint32_t height, BlockRewardInfo& info);
      virtual bool scanOutputkeysForIndices(const KeyInput& txInToKey, std::list<std::pair<Crypto::Hash, size_t>>& outputReferences) override;
      virtual bool getBlockDifficulty(uint32_t height, difficulty_type& difficulty) override;
      virtual bool getBlockContainingTx(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) override;
@@ -145,7 +150,38 @@ namespace CryptoNote {
      uint64_t depositAmountAtHeight(size_t height) const;
      uint64_t depositInterestAtHeight(size_t height) const;
 
+     uint64_t getBlockchainVersion() const;
+     uint64_t getPoolVersion() const;
+     TipQueryCacheStats getQueryBlocksLiteCacheStats() const;
+     TipQueryCacheStats getPoolChangesLiteCacheStats() const;
+     TipQueryCacheStats getVerifiedSignaturesCacheStats() const;
+     TipQueryCacheStats getBlocksCacheStats() const;
+     uint32_t getPrunedHeight();
+
    private:
+
+     struct QueryBlocksLiteKey {
+       uint32_t currentHeight;
+       uint32_t startOffset;
+       uint32_t fullOffset;
+       uint64_t timestamp;
+
+       bool operator==(const QueryBlocksLiteKey& other) const {
+         return currentHeight == other.currentHeight && startOffset == other.startOffset && fullOffset == other.fullOffset && timestamp == other.timestamp;
+       }
+     };
+
+     struct QueryBlocksLiteKeyHasher {
+       size_t operator()(const QueryBlocksLiteKey& key) const {
+         return std::hash<uint64_t>()((static_cast<uint64_t>(key.startOffset) << 32 | key.fullOffset) ^ key.timestamp ^ (static_cast<uint64_t>(key.currentHeight) << 16));
+       }
+     };
+
+     struct PoolChangesLiteResult {
+       bool isTailBlockActual;
+       std::vector<TransactionPrefixInfo> addedTxs;
+       std::vector<Crypto::Hash> deletedTxsIds;
+     };
    
      bool add_new_tx(const Transaction& tx, const Crypto::Hash& tx_hash, size_t blob_size, tx_verification_context& tvc, bool keeped_by_block, uint32_t height);
      bool load_state_data();
@@ -171,6 +207,7 @@ namespace CryptoNote {
 
      bool findStartAndFullOffsets(const std::vector<Crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& startOffset, uint32_t& startFullOffset);
      std::vector<Crypto::Hash> findIdsForShortBlocks(uint32_t startOffset, uint32_t startFullOffset);
+     bool queryBlocksLiteEntries(LockedBlockchainStorage& lbs, uint64_t timestamp, uint32_t startOffset, uint32_t fullOffset, std::vector<BlockShortInfo>& entries);
 
      const Currency& m_currency;
      Logging::LoggerRef logger;
@@ -185,5 +222,10 @@ namespace CryptoNote {
      std::atomic<bool> m_starter_message_showed;
      Tools::ObserverManager<ICoreObserver> m_observerManager;
      time_t start_time;
+
+     std::atomic<uint64_t> m_blockchainVersion;
+     std::atomic<uint64_t> m_poolVersion;
+     TipQueryCache<QueryBlocksLiteKey, std::vector<BlockShortInfo>, QueryBlocksLiteKeyHasher> m_queryBlocksLiteCache;
+     TipQueryCache<Crypto::Hash, PoolChangesLiteResult> m_poolChangesLiteCache;
    };
 }
@@ -1,12 +1,21 @@
 #include "CoreConfig.h"
 
+#include <algorithm>
+
 #include "common/Util.h"
 #include "common/CommandLine.h"
+#include "CryptoNoteConfig.h"
 
 namespace CryptoNote {
 
+namespace {
+const command_line::arg_descriptor<bool>     arg_prune_blockchain = {"prune-blockchain", "Strip signatures from old blocks, a pruned node doesn't serve them to peers", false};
+const command_line::arg_descriptor<uint32_t> arg_prune_depth      = {"prune-blockchain-depth", "Number of last blocks kept with signatures when pruning, at least 1000", BLOCKCHAIN_PRUNING_DEFAULT_DEPTH};
+}
+
 CoreConfig::CoreConfig() {
   configFolder = Tools::getDefaultDataDirectory();
+  pruneDepth = BLOCKCHAIN_PRUNING_DEFAULT_DEPTH;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void CoreConfig::init(const boost::program_options::variables_map& options) {
@@ -14,9 +23,16 @@ void CoreConfig::init(const boost::program_options::variables_map& options) {
     configFolder = command_line::get_arg(options, command_line::arg_data_dir);
     configFolderDefaulted = options[command_line::arg_data_dir.name].defaulted();
   }
+
+  pruneBlockchain = command_line::has_arg(options, arg_prune_blockchain);
+  if (command_line::has_arg(options, arg_prune_depth)) {
+    pruneDepth = std::max(command_line::get_arg(options, arg_prune_depth), BLOCKCHAIN_PRUNING_MIN_DEPTH);
+  }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, arg_prune_blockchain);
+  command_line::add_arg(desc, arg_prune_depth);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 } //namespace CryptoNote
@@ -17,6 +17,9 @@ public:
 
   std::string configFolder;
   bool configFolderDefaulted = true;
+  // keep signatures only for the last pruneDepth blocks
+  bool pruneBlockchain = false;
+  uint32_t pruneDepth;
 };
 
 } //namespace CryptoNote
@@ -157,6 +157,25 @@ bool Currency::getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size
       return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Currency::getBlockRewardInfo(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins,
+  uint32_t height, BlockRewardInfo& info) const {
+  int64_t emissionChange = 0;
+  if (!getBlockReward(blockMajorVersion, medianSize, 0, alreadyGeneratedCoins, 0, height, info.baseReward, emissionChange)) {
+    return false;
+  }
+  if (!getBlockReward(blockMajorVersion, medianSize, currentBlockSize, alreadyGeneratedCoins, 0, height, info.currentReward, emissionChange)) {
+    return false;
+  }
+
+  if (info.baseReward < info.currentReward) {
+    return false;
+  }
+
+  info.sizeMedian = medianSize;
+  info.penalty = info.baseReward == 0 ? 0 : static_cast<double>(info.baseReward - info.currentReward) / static_cast<double>(info.baseReward);
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 uint64_t Currency::calculateInterest(uint64_t amount, uint32_t term, uint32_t height) const {
   assert(m_depositMinTerm <= term && term <= m_depositMaxTerm);
   assert(static_cast<uint64_t>(term)* m_depositMaxTotalRate > m_depositMinTotalRateFactor);
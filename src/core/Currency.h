@@ -14,6 +14,13 @@ namespace CryptoNote {
 
 class AccountBase;
 
+struct BlockRewardInfo {
+  size_t sizeMedian;
+  uint64_t baseReward;    // reward of an empty block
+  uint64_t currentReward; // reward for the actual block size, without fees
+  double penalty;
+};
+
 class Currency {
 	
 public:
@@ -93,6 +100,8 @@ public:
 
   bool getBlockReward(uint8_t blockMajorVersion,size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint32_t height,
   uint64_t& reward, int64_t& emissionChange) const;
+  bool getBlockRewardInfo(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint32_t height,
+  BlockRewardInfo& info) const;
   uint64_t calculateInterest(uint64_t amount, uint32_t term, uint32_t height) const;
   uint64_t calculateTotalTransactionInterest(const Transaction& tx, uint32_t height) const;
   uint64_t getTransactionInputAmount(const TransactionInput& in, uint32_t height) const;
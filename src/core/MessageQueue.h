@@ -1,19 +1,28 @@
 #pragma once
 
-#include <queue>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 #include "IntrusiveLinkedList.h"
+#include "common/MpmcQueue.h"
 
+#include "System/Dispatcher.h"
 #include "System/Event.h"
 #include "System/InterruptedException.h"
 
 namespace CryptoNote {
 
+// Messages may be pushed and the queue stopped from any thread, one context of the dispatcher consumes them.
+// Pushing never blocks: messages go to a lock free ring, and to an overflow list while the ring is full
+// or the list is not empty, which keeps the messages of each producer in order.
 template<class MessageType> class MessageQueue {
 	
 public:
 
-  MessageQueue(System::Dispatcher& dispatcher);
+  explicit MessageQueue(System::Dispatcher& dispatcher, size_t capacity = 1024);
+  ~MessageQueue();
 
   const MessageType& front();
   void pop();
@@ -26,9 +35,21 @@ public:
 private:
 
   void wait();
-  std::queue<MessageType> messageQueue;
+  bool takeMessage();
+  void wake();
+
+  System::Dispatcher& dispatcher;
+  Common::MpmcQueue<std::unique_ptr<MessageType>> messageQueue;
+  std::mutex overflowMutex;
+  std::deque<std::unique_ptr<MessageType>> overflow;
+  std::atomic<size_t> overflowCount;
+  std::unique_ptr<MessageType> head;
   System::Event event;
-  bool stopped;
+  // set while the consumer waits, the producer which clears it wakes the consumer through the dispatcher
+  std::atomic<bool> waiting;
+  // wakeups which may still touch the queue from the dispatcher
+  std::atomic<size_t> pendingWakeups;
+  std::atomic<bool> stopped;
 
   typename IntrusiveLinkedList<MessageQueue<MessageType>>::hook hook;
 };
@@ -55,44 +76,103 @@ private:
 };
 
 template<class MessageType>
-MessageQueue<MessageType>::MessageQueue(System::Dispatcher& dispatcher) : event(dispatcher), stopped(false) {}
+MessageQueue<MessageType>::MessageQueue(System::Dispatcher& dispatcher, size_t capacity) :
+  dispatcher(dispatcher), messageQueue(capacity), overflowCount(0), event(dispatcher), waiting(false), pendingWakeups(0), stopped(false) {}
+
+template<class MessageType>
+MessageQueue<MessageType>::~MessageQueue() {
+  while (pendingWakeups.load() != 0) {
+    dispatcher.yield();
+  }
+}
 
 template<class MessageType>
 void MessageQueue<MessageType>::wait() {
-  if (messageQueue.empty()) {
-    if (stopped) {
+  while (!head) {
+    if (takeMessage()) {
+      break;
+    }
+
+    if (stopped.load()) {
       throw System::InterruptedException();
     }
 
     event.clear();
+    waiting.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (takeMessage() || stopped.load()) {
+      waiting.store(false);
+      continue;
+    }
+
     while (!event.get()) {
       event.wait();
     }
   }
 }
 
+template<class MessageType>
+bool MessageQueue<MessageType>::takeMessage() {
+  // the ring holds the older messages while the overflow list is in use
+  if (messageQueue.tryPop(head)) {
+    return true;
+  }
+
+  if (overflowCount.load() != 0) {
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    if (!overflow.empty()) {
+      head = std::move(overflow.front());
+      overflow.pop_front();
+      overflowCount.fetch_sub(1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<class MessageType>
+void MessageQueue<MessageType>::wake() {
+  pendingWakeups.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.exchange(false)) {
+    dispatcher.remoteSpawn([this] {
+      event.set();
+      pendingWakeups.fetch_sub(1);
+    });
+  } else {
+    pendingWakeups.fetch_sub(1);
+  }
+}
+
 template<class MessageType>
 const MessageType& MessageQueue<MessageType>::front() {
   wait();
-  return messageQueue.front();
+  return *head;
 }
 
 template<class MessageType>
 void MessageQueue<MessageType>::pop() {
   wait();
-  messageQueue.pop();
+  head.reset();
 }
 
 template<class MessageType>
 void MessageQueue<MessageType>::push(const MessageType& message) {
-  messageQueue.push(message);
-  event.set();
+  std::unique_ptr<MessageType> value(new MessageType(message));
+  if (overflowCount.load() != 0 || !messageQueue.tryPush(std::move(value))) {
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflow.push_back(std::move(value));
+    overflowCount.fetch_add(1);
+  }
+
+  wake();
 }
 
 template<class MessageType>
 void MessageQueue<MessageType>::stop() {
-  stopped = true;
-  event.set();
+  stopped.store(true);
+  wake();
 }
 
 template<class MessageType>
@@ -0,0 +1,5 @@
+#include "TipQueryCache.h"
+
+namespace {
+char suppressMSVCWarningLNK4221;
+}
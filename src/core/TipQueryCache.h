@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace CryptoNote {
+
+struct TipQueryCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  size_t entries;
+};
+
+// Caches query results computed against a particular blockchain/pool state.
+// The state is identified by a monotonically increasing version; when a lookup
+// or insertion sees a newer version than the stored one, all entries are dropped.
+template<class Key, class Value, class KeyHash = std::hash<Key>> class TipQueryCache {
+public:
+
+  explicit TipQueryCache(size_t maxEntries);
+
+  std::shared_ptr<const Value> find(uint64_t version, const Key& key);
+  void insert(uint64_t version, const Key& key, std::shared_ptr<const Value> value);
+  void clear();
+
+  TipQueryCacheStats getStats() const;
+
+private:
+
+  void resetIfOutdated(uint64_t version);
+
+  const size_t m_maxEntries;
+  mutable std::mutex m_mutex;
+  uint64_t m_version;
+  std::unordered_map<Key, std::shared_ptr<const Value>, KeyHash> m_entries;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+template<class Key, class Value, class KeyHash>
+TipQueryCache<Key, Value, KeyHash>::TipQueryCache(size_t maxEntries) : m_maxEntries(maxEntries), m_version(0), m_hits(0), m_misses(0) {
+}
+
+template<class Key, class Value, class KeyHash>
+std::shared_ptr<const Value> TipQueryCache<Key, Value, KeyHash>::find(uint64_t version, const Key& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  resetIfOutdated(version);
+
+  auto it = m_version == version ? m_entries.find(key) : m_entries.end();
+  if (it == m_entries.end()) {
+    ++m_misses;
+    return nullptr;
+  }
+
+  ++m_hits;
+  return it->second;
+}
+
+template<class Key, class Value, class KeyHash>
+void TipQueryCache<Key, Value, KeyHash>::insert(uint64_t version, const Key& key, std::shared_ptr<const Value> value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  resetIfOutdated(version);
+
+  if (m_version != version) {
+    // result was computed against a state that is already replaced
+    return;
+  }
+
+  if (m_entries.size() >= m_maxEntries && m_entries.count(key) == 0) {
+    m_entries.clear();
+  }
+
+  m_entries[key] = std::move(value);
+}
+
+template<class Key, class Value, class KeyHash>
+void TipQueryCache<Key, Value, KeyHash>::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+}
+
+template<class Key, class Value, class KeyHash>
+TipQueryCacheStats TipQueryCache<Key, Value, KeyHash>::getStats() const {
+  TipQueryCacheStats stats;
+  stats.hits = m_hits.load();
+  stats.misses = m_misses.load();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stats.entries = m_entries.size();
+  return stats;
+}
+
+template<class Key, class Value, class KeyHash>
+void TipQueryCache<Key, Value, KeyHash>::resetIfOutdated(uint64_t version) {
+  if (version > m_version) {
+    m_entries.clear();
+    m_version = version;
+  }
+}
+
+}
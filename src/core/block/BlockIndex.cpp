@@ -38,7 +38,7 @@ namespace CryptoNote {
   }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
   std::vector<Crypto::Hash> BlockIndex::buildSparseChain(const Crypto::Hash& startBlockId) const {
-    assert(m_index.count(startBlockId) > 0);
+    assert(hasBlock(startBlockId));
 
     uint32_t startBlockHeight;
     getBlockHeight(startBlockId, startBlockHeight);
@@ -63,7 +63,12 @@ namespace CryptoNote {
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
   void BlockIndex::serialize(ISerializer& s) {
     if (s.type() == ISerializer::INPUT) {
+      clear();
       readSequence<Crypto::Hash>(std::back_inserter(m_container), "index", s);
+      m_index.reserve(m_container.size());
+      for (size_t i = 0; i < m_container.size(); ++i) {
+        m_index.insert(static_cast<uint32_t>(i));
+      }
     } else {
       writeSequence<Crypto::Hash>(m_container.begin(), m_container.end(), "index", s);
     }
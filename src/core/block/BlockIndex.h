@@ -1,7 +1,4 @@
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/random_access_index.hpp>
-
+#include "common/FlatKeyTable.h"
 #include "crypto/hash.h"
 #include <vector>
 
@@ -13,17 +10,27 @@ namespace CryptoNote
 
   public:
 
-    BlockIndex() : 
-      m_index(m_container.get<1>()) {}
+    BlockIndex() :
+      m_index(HashAtHeight(m_container)) {}
+
+    // m_index refers to m_container
+    BlockIndex(const BlockIndex&) = delete;
+    BlockIndex& operator=(const BlockIndex&) = delete;
 
     void pop() {
+      m_index.erase(m_container.back());
       m_container.pop_back();
     }
 
     // returns true if new element was inserted, false if already exists
     bool push(const Crypto::Hash& h) {
-      auto result = m_container.push_back(h);
-      return result.second;
+      if (hasBlock(h)) {
+        return false;
+      }
+
+      m_container.push_back(h);
+      m_index.insert(static_cast<uint32_t>(m_container.size() - 1));
+      return true;
     }
 
     bool hasBlock(const Crypto::Hash& h) const {
@@ -35,7 +42,7 @@ namespace CryptoNote
       if (hi == m_index.end())
         return false;
 
-      height = static_cast<uint32_t>(std::distance(m_container.begin(), m_container.project<0>(hi)));
+      height = *hi;
       return true;
     }
 
@@ -45,6 +52,7 @@ namespace CryptoNote
 
     void clear() {
       m_container.clear();
+      m_index.clear();
     }
 
     Crypto::Hash getBlockId(uint32_t height) const;
@@ -57,16 +65,19 @@ namespace CryptoNote
 
   private:
 
-    typedef boost::multi_index_container <
-      Crypto::Hash,
-      boost::multi_index::indexed_by<
-        boost::multi_index::random_access<>,
-        boost::multi_index::hashed_unique<boost::multi_index::identity<Crypto::Hash>>
-      >
-    > ContainerT;
+    // index keeps only heights, hashes are compared with the ones in m_container
+    struct HashAtHeight {
+      explicit HashAtHeight(const std::vector<Crypto::Hash>& container) : container(&container) {}
+
+      const Crypto::Hash& operator()(uint32_t height) const {
+        return (*container)[height];
+      }
+
+      const std::vector<Crypto::Hash>* container;
+    };
 
-    ContainerT m_container;
-    ContainerT::nth_index<1>::type& m_index;
+    std::vector<Crypto::Hash> m_container;
+    Common::FlatKeyTable<Crypto::Hash, uint32_t, HashAtHeight> m_index;
 
   };
 }
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cmath>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include "common/Math.h"
 #include "ShuffleGenerator.h"
@@ -17,6 +18,13 @@ using namespace Common;
 
 namespace {
 
+// ring signatures of roughly a few blocks worth of pool transactions
+const size_t VERIFIED_SIGNATURES_CACHE_SIZE = 16384;
+
+// pruning rewrites the whole blocks file, so it is skipped until this many blocks can be pruned
+const uint32_t BLOCKS_PRUNING_STEP = 10000;
+const char PRUNING_FILE_SUFFIX[] = ".pruning";
+
 std::string appendPath(const std::string& path, const std::string& fileName) {
   std::string result = path;
   if (!result.empty()) {
@@ -55,6 +63,11 @@ bool serialize(google::sparse_hash_map<K, V, Hash>& value, Common::StringView na
   return serializeMap(value, name, serializer, [&value](size_t size) { value.resize(size); });
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+template<typename K, typename V>
+bool serialize(Common::FlatKeyMap<K, V>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
+  return serializeMap(value, name, serializer, [&value](size_t size) { value.reserve(size); });
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 template<typename K, typename Hash>
 bool serialize(google::sparse_hash_set<K, Hash>& value, Common::StringView name, CryptoNote::ISerializer& serializer) {
   size_t size = value.size();
@@ -309,7 +322,22 @@ Blockchain::Blockchain(const Currency& currency, tx_memory_pool& tx_pool, ILogge
   m_currency(currency),
   m_tx_pool(tx_pool),
   m_current_block_cumul_sz_limit(0),
+  m_lastBlocksSizes(currency.rewardBlocksWindow()),
+  m_historicalBlocksSizes(currency.rewardBlocksWindow()),
+  m_historicalBlocksSizesHeight(std::numeric_limits<uint32_t>::max()),
   m_is_in_checkpoint_zone(false),
+  m_verifiedSignatures(VERIFIED_SIGNATURES_CACHE_SIZE),
+  m_blockProcessingTime(Common::MetricsRegistry::instance().histogram("block_processing_seconds", "Time spent validating and pushing a block to the main chain")),
+  m_difficultyCalculatingTime(Common::MetricsRegistry::instance().histogram("block_difficulty_seconds", "Time spent calculating difficulty of the next block")),
+  m_proofOfWorkCalculatingTime(Common::MetricsRegistry::instance().histogram("block_pow_seconds", "Time spent checking block proof of work or checkpoint")),
+  m_mainChainBlocks(Common::MetricsRegistry::instance().counter("blocks_total", "Blocks passed to the blockchain", "result=\"main_chain\"")),
+  m_alternativeBlocks(Common::MetricsRegistry::instance().counter("blocks_total", "Blocks passed to the blockchain", "result=\"alternative\"")),
+  m_rejectedBlocks(Common::MetricsRegistry::instance().counter("blocks_total", "Blocks passed to the blockchain", "result=\"rejected\"")),
+  m_spentKeysFilterNegatives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"blockchain\",result=\"negative\"")),
+  m_spentKeysFilterPositives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"blockchain\",result=\"positive\"")),
+  m_spentKeysFilterFalsePositives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"blockchain\",result=\"false_positive\"")),
+  m_prunedHeightGauge(Common::MetricsRegistry::instance().gauge("blockchain_pruned_height", "Height below which blocks are stored without signatures")),
+  m_prunedBytes(Common::MetricsRegistry::instance().counter("blockchain_pruned_bytes_total", "Bytes removed from the blocks file by pruning")),
   m_upgradeDetectorv2(currency, m_blocks, NEXT_BLOCK_MAJOR, logger),
   m_upgradeDetectorv3(currency, m_blocks, NEXT_BLOCK_MAJOR_LIMIT, logger),
   m_checkpoints(logger),
@@ -317,7 +345,9 @@ Blockchain::Blockchain(const Currency& currency, tx_memory_pool& tx_pool, ILogge
   m_timestampIndex(blockchainIndexesEnabled),
   m_generatedTransactionsIndex(blockchainIndexesEnabled),
   m_orthanBlocksIndex(blockchainIndexesEnabled),
-  m_blockchainIndexesEnabled(blockchainIndexesEnabled) {
+  m_blockchainIndexesEnabled(blockchainIndexesEnabled),
+  m_pruningDepth(0),
+  m_prunedHeight(0) {
 
   m_outputs.set_deleted_key(0);
   m_multisignatureOutputs.set_deleted_key(0);
@@ -400,7 +430,18 @@ bool Blockchain::haveTransaction(const Crypto::Hash &id) {
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool Blockchain::have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  return  m_spent_keys.find(key_im) != m_spent_keys.end();
+  if (!m_spentKeysFilter.mayContain(key_im)) {
+    m_spentKeysFilterNegatives.increment();
+    return false;
+  }
+
+  if (m_spent_keys.find(key_im) == m_spent_keys.end()) {
+    m_spentKeysFilterFalsePositives.increment();
+    return false;
+  }
+
+  m_spentKeysFilterPositives.increment();
+  return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 uint32_t Blockchain::getCurrentBlockchainHeight() {
@@ -417,10 +458,28 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   m_config_folder = config_folder;
 
-  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
+  std::string blocksFileName = appendPath(config_folder, m_currency.blocksFileName());
+  std::string indexesFileName = appendPath(config_folder, m_currency.blockIndexesFileName());
+  boost::system::error_code ec;
+  if (boost::filesystem::exists(indexesFileName + PRUNING_FILE_SUFFIX, ec) && !boost::filesystem::exists(blocksFileName + PRUNING_FILE_SUFFIX, ec)) {
+    // pruning was interrupted after the blocks file had been replaced
+    logger(WARNING, BRIGHT_YELLOW) << "Finishing interrupted blockchain pruning";
+    boost::filesystem::rename(indexesFileName + PRUNING_FILE_SUFFIX, indexesFileName, ec);
+    if (ec) {
+      logger(ERROR, BRIGHT_RED) << "Failed to replace " << indexesFileName << ": " << ec.message();
+      return false;
+    }
+  } else {
+    boost::filesystem::remove(blocksFileName + PRUNING_FILE_SUFFIX, ec);
+    boost::filesystem::remove(indexesFileName + PRUNING_FILE_SUFFIX, ec);
+  }
+
+  if (!m_blocks.open(blocksFileName, indexesFileName, 1024)) {
     return false;
   }
 
+  m_blockMetadata.clear();
+
   if (load_existing && !m_blocks.empty()) {
     logger(INFO, BRIGHT_WHITE) << "Loading blockchain...";
     BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
@@ -431,13 +490,24 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
       rebuildCache();
     }
 
+    rebuildSpentKeysFilter();
+
     if (m_blockchainIndexesEnabled) {
       loadBlockchainIndices();
     }
+
+    m_prunedHeight = findPrunedHeight();
+    if (m_prunedHeight != 0 && m_pruningDepth == 0) {
+      logger(WARNING, BRIGHT_YELLOW) << "Blockchain is pruned below height " << m_prunedHeight << ", pruned signatures can be restored only by synchronizing from scratch";
+    }
   } else {
     m_blocks.clear();
+    m_prunedHeight = 0;
   }
 
+  m_blockMetadata.resize(m_blocks.size(), BlockMetadata());
+  resetLastBlocksSizes();
+
   if (m_blocks.empty()) {
     logger(INFO, BRIGHT_WHITE)
       << "Blockchain not loaded, generating genesis block.";
@@ -491,6 +561,12 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
     return false;
   }
 
+  if (m_pruningDepth != 0 && !pruneBlocks()) {
+    logger(ERROR, BRIGHT_RED) << "Failed to prune blockchain";
+    return false;
+  }
+
+  m_prunedHeightGauge.set(m_prunedHeight);
   update_next_comulative_size_limit();
 
   uint64_t timestamp_diff = time(NULL) - m_blocks.back().bl.timestamp;
@@ -526,7 +602,8 @@ void Blockchain::rebuildCache() {
     uint64_t interest = 0;
     for (uint16_t t = 0; t < block.transactions.size(); ++t) {
       const TransactionEntry& transaction = block.transactions[t];
-      Crypto::Hash transactionHash = getObjectHash(transaction.tx);
+      // hashes of pruned transactions can't be calculated, the block keeps them
+      Crypto::Hash transactionHash = t == 0 ? getObjectHash(transaction.tx) : block.bl.transactionHashes[t - 1];
       TransactionIndex transactionIndex = { b, t };
       m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
 
@@ -561,6 +638,128 @@ void Blockchain::rebuildCache() {
   logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count();
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+uint32_t Blockchain::getPrunedHeight() {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_prunedHeight;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// Pruned blocks always form the beginning of the chain.
+// Precondition: m_blockchain_lock is locked.
+uint32_t Blockchain::findPrunedHeight() {
+  uint32_t low = 0;
+  uint32_t high = static_cast<uint32_t>(m_blocks.size());
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (m_blocks[middle].pruned) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// Strips signatures from transactions of blocks older than m_pruningDepth. Entries can't be rewritten in place,
+// so a pruned copy of the blocks file is written next to it and replaces it once complete.
+// Precondition: m_blockchain_lock is locked.
+bool Blockchain::pruneBlocks() {
+  uint32_t height = static_cast<uint32_t>(m_blocks.size());
+  if (height <= m_pruningDepth || height - m_pruningDepth < m_prunedHeight + BLOCKS_PRUNING_STEP) {
+    return true;
+  }
+
+  uint32_t targetHeight = height - m_pruningDepth;
+  std::string blocksFileName = appendPath(m_config_folder, m_currency.blocksFileName());
+  std::string indexesFileName = appendPath(m_config_folder, m_currency.blockIndexesFileName());
+  std::string prunedBlocksFileName = blocksFileName + PRUNING_FILE_SUFFIX;
+  std::string prunedIndexesFileName = indexesFileName + PRUNING_FILE_SUFFIX;
+
+  boost::system::error_code ec;
+  uint64_t sizeBefore = boost::filesystem::file_size(blocksFileName, ec);
+  if (ec) {
+    logger(ERROR, BRIGHT_RED) << "Failed to get size of " << blocksFileName << ": " << ec.message();
+    return false;
+  }
+
+  logger(INFO, BRIGHT_WHITE) << "Pruning blocks " << m_prunedHeight << " - " << targetHeight - 1 << ", " << sizeBefore / (1024 * 1024) << " MB of free disk space is required";
+  std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
+
+  {
+    Blocks prunedBlocks;
+    if (!prunedBlocks.open(prunedBlocksFileName, prunedIndexesFileName, 1)) {
+      logger(ERROR, BRIGHT_RED) << "Failed to create " << prunedBlocksFileName;
+      return false;
+    }
+
+    for (uint32_t b = 0; b < height; ++b) {
+      if (b % 10000 == 0) {
+        logger(INFO, BRIGHT_WHITE) << "Height " << b << " of " << height;
+      }
+
+      BlockEntry block = m_blocks[b];
+      if (b < targetHeight && !block.pruned) {
+        for (TransactionEntry& transaction : block.transactions) {
+          transaction.tx.signatures.clear();
+        }
+
+        block.pruned = true;
+      }
+
+      prunedBlocks.push_back(std::move(block));
+    }
+  }
+
+  // the indexes file is renamed last, init finishes the job if only it is left
+  m_blocks.close();
+  boost::filesystem::rename(prunedBlocksFileName, blocksFileName, ec);
+  if (!ec) {
+    boost::filesystem::rename(prunedIndexesFileName, indexesFileName, ec);
+  }
+
+  if (ec) {
+    logger(ERROR, BRIGHT_RED) << "Failed to replace " << blocksFileName << ": " << ec.message();
+    return false;
+  }
+
+  if (!m_blocks.open(blocksFileName, indexesFileName, 1024)) {
+    logger(ERROR, BRIGHT_RED) << "Failed to open pruned " << blocksFileName;
+    return false;
+  }
+
+  m_prunedHeight = targetHeight;
+  uint64_t sizeAfter = boost::filesystem::file_size(blocksFileName, ec);
+  uint64_t saved = !ec && sizeAfter < sizeBefore ? sizeBefore - sizeAfter : 0;
+  m_prunedBytes.increment(saved);
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_GREEN) << "Blockchain pruned below height " << m_prunedHeight << " in " << duration.count() << " s, blocks file size " <<
+    sizeAfter / (1024 * 1024) << " MB, saved " << saved / (1024 * 1024) << " MB";
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Blockchain::isTransactionPruned(const TransactionIndex& index) const {
+  // miner transactions have no signatures to prune
+  return index.block < m_prunedHeight && index.transaction != 0;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Blockchain::addSpentKeyToFilter(const Crypto::KeyImage& keyImage) {
+  if (m_spentKeysFilter.needsRebuild()) {
+    // keyImage is already in m_spent_keys
+    rebuildSpentKeysFilter();
+  } else {
+    m_spentKeysFilter.add(keyImage);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void Blockchain::rebuildSpentKeysFilter() {
+  // room for growth, so the filter isn't rebuilt again soon
+  m_spentKeysFilter.clear(m_spent_keys.size() * 2);
+  for (const auto& keyImage : m_spent_keys) {
+    m_spentKeysFilter.add(keyImage);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool Blockchain::storeCache() {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
@@ -588,10 +787,15 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
   m_blocks.clear();
   m_blockIndex.clear();
   m_transactionMap.clear();
+  m_blockMetadata.clear();
+  resetLastBlocksSizes();
 
   m_spent_keys.clear();
+  rebuildSpentKeysFilter();
   m_alternative_chains.clear();
   m_outputs.clear();
+  m_prunedHeight = 0;
+  m_prunedHeightGauge.set(0);
 
   m_paymentIdIndex.clear();
   m_timestampIndex.clear();
@@ -997,9 +1201,7 @@ bool Blockchain::validate_miner_transaction(const Block& b, uint32_t height, siz
     minerReward += o.amount;
   }
 
-  std::vector<size_t> lastBlocksSizes;
-  get_last_n_blocks_sizes(lastBlocksSizes, m_currency.rewardBlocksWindow());
-  size_t blocksSizeMedian = Common::medianValue(lastBlocksSizes);
+  size_t blocksSizeMedian = m_lastBlocksSizes.median();
 
   if (!m_currency.getBlockReward(blockMajorVersion, blocksSizeMedian, cumulativeBlockSize, alreadyGeneratedCoins, fee, height, reward, emissionChange)) {
     logger(INFO, BRIGHT_WHITE) << "block size " << cumulativeBlockSize << " is bigger than allowed for this blockchain";
@@ -1039,15 +1241,6 @@ bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>&
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool Blockchain::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  if (!m_blocks.size()) {
-    return true;
-  }
-
-  return getBackwardBlocksSize(m_blocks.size() - 1, sz, count);
-}
-//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 uint64_t Blockchain::getCurrentCumulativeBlocksizeLimit() {
   return m_current_block_cumul_sz_limit;
 }
@@ -1100,6 +1293,16 @@ bool Blockchain::handle_alternative_block(const Block& b, const Crypto::Hash& id
     return false;
   }
 
+  // switching to such a chain would pop pruned blocks, whose transactions can't be validated again
+  if (block_height <= m_prunedHeight) {
+    logger(TRACE) << "Block with id: " << id << std::endl <<
+      " can't be accepted for alternative chain, block height: " << block_height << std::endl <<
+      " pruned height: " << m_prunedHeight;
+
+    bvc.m_verification_failed = true;
+    return false;
+  }
+
   if (!checkBlockVersion(b, id)) {
     bvc.m_verification_failed = true;
     return false;
@@ -1319,8 +1522,13 @@ bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTI
   for (const auto& bl : blocks) {
     std::list<Crypto::Hash> missed_tx_id;
     std::list<Transaction> txs;
-    getTransactions(bl.transactionHashes, txs, rsp.missed_ids);
-    if (!(!missed_tx_id.size())) { logger(ERROR, BRIGHT_RED) << "Internal error: have missed missed_tx_id.size()=" << missed_tx_id.size() << ENDL << "for block id = " << get_block_hash(bl); return false; } //WTF???
+    getTransactions(bl.transactionHashes, txs, missed_tx_id);
+    if (!missed_tx_id.empty()) {
+      // transactions of pruned blocks can't be served
+      rsp.missed_ids.push_back(get_block_hash(bl));
+      continue;
+    }
+
     rsp.blocks.push_back(block_complete_entry());
     block_complete_entry& e = rsp.blocks.back();
     //pack block
@@ -1361,7 +1569,7 @@ bool Blockchain::add_out_to_get_random_outs(std::vector<std::pair<TransactionInd
   const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
   if (!(tx.outputs.size() > amount_outs[i].second)) {
     logger(ERROR, BRIGHT_RED) << "internal error: in global outs index, transaction out index="
-      << amount_outs[i].second << " more than transaction outputs = " << tx.outputs.size() << ", for tx id = " << getObjectHash(tx); return false;
+      << amount_outs[i].second << " more than transaction outputs = " << tx.outputs.size() << ", for tx id = " << transactionHashByIndex(amount_outs[i].first); return false;
   }
   if (!(tx.outputs[amount_outs[i].second].target.type() == typeid(KeyOutput))) { logger(ERROR, BRIGHT_RED) << "unknown tx out type"; return false; }
 
@@ -1500,7 +1708,7 @@ void Blockchain::print_blockchain_outs(const std::string& file) {
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << getObjectHash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        ss << "\t" << transactionHashByIndex(vals[i].first) << ": " << vals[i].second << ENDL;
       }
     }
   }
@@ -1609,21 +1817,24 @@ bool Blockchain::haveTransactionKeyImagesAsSpent(const Transaction &tx) {
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height) {
   Crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix*>(&tx));
-  return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height);
+  return checkTransactionInputs(tx, getObjectHash(tx), tx_prefix_hash, pmax_used_block_height);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Blockchain::checkTransactionInputs(const CachedTransaction& transaction, uint32_t* pmax_used_block_height) {
+  return checkTransactionInputs(transaction.getTransaction(), transaction.getTransactionHash(), transaction.getTransactionPrefixHash(), pmax_used_block_height);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height) {
+bool Blockchain::checkTransactionInputs(const Transaction& tx, const Crypto::Hash& transactionHash, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
   }
 
-  Crypto::Hash transactionHash = getObjectHash(tx);
   for (const auto& txin : tx.inputs) {
     assert(inputIndex < tx.signatures.size());
     if (txin.type() == typeid(KeyInput)) {
       const KeyInput& in_to_key = boost::get<KeyInput>(txin);
-      if (!(!in_to_key.outputIndexes.empty())) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << getObjectHash(tx); return false; }
+      if (!(!in_to_key.outputIndexes.empty())) { logger(ERROR, BRIGHT_RED) << "empty in_to_key.outputIndexes in transaction with id " << transactionHash; return false; }
 
       if (have_tx_keyimg_as_spent(in_to_key.keyImage)) {
         logger(DEBUGGING) <<
@@ -1702,14 +1913,6 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
     }
   };
 
-  // additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
-  static const Crypto::KeyImage I = { { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
-  static const Crypto::KeyImage L = { { 0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
-  if (!(scalarmultKey(txin.keyImage, L) == I)) {
-	 logger(ERROR) << "Transaction uses key image not in the valid domain";
-	 return false;
-  }
-
   //check ring signature
   std::vector<const Crypto::PublicKey *> output_keys;
   outputs_visitor vi(output_keys, *this, logger.getLogger());
@@ -1727,11 +1930,34 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_pre
   }
 
   if (!(sig.size() == output_keys.size())) { logger(ERROR, BRIGHT_RED) << "internal error: tx signatures count=" << sig.size() << " mismatch with outputs keys count for inputs=" << output_keys.size(); return false; }
+
+  // the key depends only on the transaction and the ring member keys, so a hit is valid on any chain state
+  Crypto::Hash cacheKey;
+  if (!m_is_in_checkpoint_zone) {
+    cacheKey = VerifiedSignatureCache::makeKey(tx_prefix_hash, txin.keyImage, output_keys, sig);
+    if (m_verifiedSignatures.contains(cacheKey)) {
+      return true;
+    }
+  }
+
+  // additional key_image check, fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
+  static const Crypto::KeyImage I = { { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+  static const Crypto::KeyImage L = { { 0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
+  if (!(scalarmultKey(txin.keyImage, L) == I)) {
+	 logger(ERROR) << "Transaction uses key image not in the valid domain";
+	 return false;
+  }
+
   if (m_is_in_checkpoint_zone) {
     return true;
   }
 
-  return Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  if (!Crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data())) {
+    return false;
+  }
+
+  m_verifiedSignatures.insert(cacheKey);
+  return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 uint64_t Blockchain::get_adjusted_time() {
@@ -1866,10 +2092,7 @@ bool Blockchain::update_next_comulative_size_limit() {
   uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(static_cast<uint32_t>(m_blocks.size()));
   size_t nextBlockGrantedFullRewardZone = m_currency.blockGrantedFullRewardZoneByBlockVersion(nextBlockMajorVersion);
 
-  std::vector<size_t> sz;
-  get_last_n_blocks_sizes(sz, m_currency.rewardBlocksWindow());
-
-  uint64_t median = Common::medianValue(sz);
+  uint64_t median = m_lastBlocksSizes.median();
   if (median <= nextBlockGrantedFullRewardZone) {
     median = nextBlockGrantedFullRewardZone;
   }
@@ -1918,6 +2141,14 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
     }
   }
 
+  if (bvc.m_verification_failed) {
+    m_rejectedBlocks.increment();
+  } else if (bvc.m_added_to_main_chain) {
+    m_mainChainBlocks.increment();
+  } else if (add_result) {
+    m_alternativeBlocks.increment();
+  }
+
   if (add_result && bvc.m_added_to_main_chain) {
     m_observerManager.notify(&IBlockchainStorageObserver::blockchainUpdated);
   }
@@ -1929,8 +2160,14 @@ const Blockchain::TransactionEntry& Blockchain::transactionByIndex(TransactionIn
   return m_blocks[index.block].transactions[index.transaction];
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// Hashes of pruned transactions can't be calculated, the block keeps them
+Crypto::Hash Blockchain::transactionHashByIndex(TransactionIndex index) {
+  const BlockEntry& block = m_blocks[index.block];
+  return index.transaction == 0 ? getObjectHash(block.bl.baseTransaction) : block.bl.transactionHashes[index.transaction - 1];
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool Blockchain::pushBlock(const Block& blockData, block_verification_context& bvc, uint32_t height) {
-  std::vector<Transaction> transactions;
+  std::vector<CachedTransaction> transactions;
   if (!loadTransactions(blockData, transactions, height)) {
     bvc.m_verification_failed = true;
     return false;
@@ -1944,7 +2181,7 @@ bool Blockchain::pushBlock(const Block& blockData, block_verification_context& b
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, block_verification_context& bvc) {
+bool Blockchain::pushBlock(const Block& blockData, const std::vector<CachedTransaction>& transactions, block_verification_context& bvc) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   auto blockProcessingStart = std::chrono::steady_clock::now();
@@ -1987,7 +2224,9 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   auto targetTimeStart = std::chrono::steady_clock::now();
   difficulty_type currentDifficulty = getDifficultyForNextBlock();
-  auto target_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - targetTimeStart).count();
+  auto targetCalculatingDuration = std::chrono::steady_clock::now() - targetTimeStart;
+  auto target_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(targetCalculatingDuration).count();
+  m_difficultyCalculatingTime.observe(std::chrono::duration<double>(targetCalculatingDuration).count());
 
   if (!(currentDifficulty)) {
     logger(ERROR, BRIGHT_RED) << "!!!!!!!!! difficulty overhead !!!!!!!!!";
@@ -2012,7 +2251,9 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     }
   }
 
-  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - longhashTimeStart).count();
+  auto longhashCalculatingDuration = std::chrono::steady_clock::now() - longhashTimeStart;
+  auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(longhashCalculatingDuration).count();
+  m_proofOfWorkCalculatingTime.observe(std::chrono::duration<double>(longhashCalculatingDuration).count());
 
   if (!prevalidate_miner_transaction(blockData, static_cast<uint32_t>(m_blocks.size()))) {
     logger(INFO, BRIGHT_WHITE) <<
@@ -2026,6 +2267,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   BlockEntry block;
   block.bl = blockData;
   block.height = static_cast<uint32_t>(m_blocks.size());
+  block.pruned = false;
   block.transactions.resize(1);
   block.transactions[0].tx = blockData.baseTransaction;
   TransactionIndex transactionIndex = { block.height, static_cast<uint16_t>(0) };
@@ -2038,18 +2280,19 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   for (size_t i = 0; i < transactions.size(); ++i) {
     const Crypto::Hash& tx_id = blockData.transactionHashes[i];
+    const Transaction& transaction = transactions[i].getTransaction();
     block.transactions.resize(block.transactions.size() + 1);
-    block.transactions.back().tx = transactions[i];
-    size_t blob_size = toBinaryArray(transactions[i]).size();
+    block.transactions.back().tx = transaction;
+    size_t blob_size = transactions[i].getTransactionBinarySize();
 
-    uint64_t in_amount = m_currency.getTransactionAllInputsAmount(transactions[i], block.height);
-	  uint64_t out_amount = getOutputAmount(transactions[i]);
+    uint64_t in_amount = m_currency.getTransactionAllInputsAmount(transaction, block.height);
+	  uint64_t out_amount = getOutputAmount(transaction);
     uint64_t fee = in_amount < out_amount ? CryptoNote::parameters::MINIMUM_FEE : in_amount - out_amount;
 
     bool isTransactionValid = true;
-    if (block.bl.majorVersion == CURRENT_BLOCK_MAJOR && transactions[i].version > CURRENT_TRANSACTION_VERSION) {
+    if (block.bl.majorVersion == CURRENT_BLOCK_MAJOR && transaction.version > CURRENT_TRANSACTION_VERSION) {
       isTransactionValid = false;
-      logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " can't contain transaction " << tx_id << " because it has invalid version " << transactions[i].version;
+      logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " can't contain transaction " << tx_id << " because it has invalid version " << transaction.version;
     }
 
     if (!checkTransactionInputs(transactions[i])) {
@@ -2057,7 +2300,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id;
     }
 
-    if (!check_tx_outputs(transactions[i])) {
+    if (!check_tx_outputs(transaction)) {
       isTransactionValid = false;
       logger(INFO, BRIGHT_WHITE) << "Transaction " << tx_id << " has at least one invalid output";
     }
@@ -2076,7 +2319,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
     cumulative_block_size += blob_size;
     fee_summary += fee;
-    interestSummary += m_currency.calculateTotalTransactionInterest(transactions[i], block.height);
+    interestSummary += m_currency.calculateTotalTransactionInterest(transaction, block.height);
   }
 
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, block.height)) {
@@ -2102,15 +2345,18 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     block.cumulative_difficulty += m_blocks.back().cumulative_difficulty;
   }
 
-  pushBlock(block);
   pushToDepositIndex(block, interestSummary);
+  uint32_t blockHeight = block.height;
+  pushBlock(std::move(block));
 
-  auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
+  auto blockProcessingDuration = std::chrono::steady_clock::now() - blockProcessingStart;
+  auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(blockProcessingDuration).count();
+  m_blockProcessingTime.observe(std::chrono::duration<double>(blockProcessingDuration).count());
 
   logger(DEBUGGING) <<
     "+++++ BLOCK SUCCESSFULLY ADDED" << ENDL << "id:\t" << blockHash
     << ENDL << "PoW:\t" << proof_of_work
-    << ENDL << "HEIGHT " << block.height << ", difficulty:\t" << currentDifficulty
+    << ENDL << "HEIGHT " << blockHeight << ", difficulty:\t" << currentDifficulty
     << ENDL << "block reward: " << m_currency.formatAmount(reward) << ", fee = " << m_currency.formatAmount(fee_summary)
     << ", coinbase_blob_size: " << coinbase_blob_size << ", cumulative size: " << cumulative_block_size
     << ", " << block_processing_time << "(" << target_calculating_time << "/" << longhash_calculating_time << ")ms";
@@ -2167,15 +2413,18 @@ void Blockchain::pushToDepositIndex(const BlockEntry& block, uint64_t interest)
   m_depositIndex.pushBlock(deposit, interest);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool Blockchain::pushBlock(BlockEntry& block) {
+bool Blockchain::pushBlock(BlockEntry&& block) {
   Crypto::Hash blockHash = get_block_hash(block.bl);
 
-  m_blocks.push_back(block);
   m_blockIndex.push(blockHash);
+  m_blockMetadata.push_back(BlockMetadata());
+  m_lastBlocksSizes.pushBack(block.block_cumulative_size);
 
   m_timestampIndex.add(block.bl.timestamp, blockHash);
   m_generatedTransactionsIndex.add(block.bl);
 
+  m_blocks.push_back(std::move(block));
+
   assert(m_blockIndex.size() == m_blocks.size());
 
   return true;
@@ -2189,9 +2438,14 @@ void Blockchain::popBlock() {
     return;
   }
 
-  std::vector<Transaction> transactions(m_blocks.back().transactions.size() - 1);
-  for (size_t i = 0; i < m_blocks.back().transactions.size() - 1; ++i) {
-    transactions[i] = m_blocks.back().transactions[1 + i].tx;
+  const BlockEntry& block = m_blocks.back();
+  std::vector<CachedTransaction> transactions;
+  // transactions of a pruned block have no signatures and can't go back to the pool
+  if (!block.pruned) {
+    transactions.reserve(block.transactions.size() - 1);
+    for (size_t i = 0; i < block.transactions.size() - 1; ++i) {
+      transactions.emplace_back(block.transactions[1 + i].tx);
+    }
   }
 
   uint32_t height = m_blocks.size(); //height of popped block should be same as number of blocks
@@ -2230,11 +2484,14 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
 
         for (size_t j = 0; j < i; ++j) {
           m_spent_keys.erase(::boost::get<KeyInput>(transaction.tx.inputs[i - 1 - j]).keyImage);
+          m_spentKeysFilter.removed();
         }
 
         m_transactionMap.erase(transactionHash);
         return false;
       }
+
+      addSpentKeyToFilter(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage);
     }
   }
 
@@ -2260,7 +2517,7 @@ bool Blockchain::pushTransaction(BlockEntry& block, const Crypto::Hash& transact
     }
   }
 
-  m_paymentIdIndex.add(transaction.tx);
+  m_paymentIdIndex.add(transaction.tx, transactionHash);
 
   return true;
 }
@@ -2350,6 +2607,7 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
   for (auto& input : transaction.inputs) {
     if (input.type() == typeid(KeyInput)) {
       size_t count = m_spent_keys.erase(::boost::get<KeyInput>(input).keyImage);
+      m_spentKeysFilter.removed();
       if (count != 1) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - cannot find spent key.";
@@ -2366,7 +2624,7 @@ void Blockchain::popTransaction(const Transaction& transaction, const Crypto::Ha
     }
   }
 
-  m_paymentIdIndex.remove(transaction);
+  m_paymentIdIndex.remove(transaction, transactionHash);
 
   size_t count = m_transactionMap.erase(transactionHash);
   if (count != 1) {
@@ -2495,6 +2753,21 @@ void Blockchain::removeLastBlock() {
 
   m_blocks.pop_back();
   m_blockIndex.pop();
+  m_blockMetadata.pop_back();
+  if (m_prunedHeight > m_blocks.size()) {
+    m_prunedHeight = static_cast<uint32_t>(m_blocks.size());
+    m_prunedHeightGauge.set(m_prunedHeight);
+  }
+
+  m_lastBlocksSizes.popBack();
+  if (m_blocks.size() >= m_lastBlocksSizes.windowSize()) {
+    m_lastBlocksSizes.pushFront(m_blocks[m_blocks.size() - m_lastBlocksSizes.windowSize()].block_cumulative_size);
+  }
+
+  if (m_historicalBlocksSizesHeight != std::numeric_limits<uint32_t>::max() && m_historicalBlocksSizesHeight >= m_blocks.size()) {
+    m_historicalBlocksSizes.clear();
+    m_historicalBlocksSizesHeight = std::numeric_limits<uint32_t>::max();
+  }
 
   assert(m_blockIndex.size() == m_blocks.size());
 }
@@ -2586,6 +2859,154 @@ bool Blockchain::getBlockSize(const Crypto::Hash& hash, size_t& size) {
   return false;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const Blockchain::BlockMetadata& Blockchain::blockMetadata(uint32_t height) {
+  assert(height < m_blockMetadata.size());
+  BlockMetadata& metadata = m_blockMetadata[height];
+  if (metadata.headerSize == 0) {
+    const Block& block = m_blocks[height].bl;
+    metadata.headerSize = static_cast<uint32_t>(getObjectBinarySize(block) - getObjectBinarySize(block.baseTransaction));
+    metadata.transactionCount = static_cast<uint32_t>(block.transactionHashes.size() + 1);
+    metadata.reward = getOutputAmount(block.baseTransaction);
+  }
+
+  return metadata;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// Precondition: m_blockchain_lock is locked.
+void Blockchain::resetLastBlocksSizes() {
+  m_lastBlocksSizes.clear();
+  size_t startHeight = m_blocks.size() - std::min(m_blocks.size(), m_lastBlocksSizes.windowSize());
+  for (size_t height = startHeight; height < m_blocks.size(); ++height) {
+    m_lastBlocksSizes.pushBack(m_blocks[height].block_cumulative_size);
+  }
+
+  m_historicalBlocksSizes.clear();
+  m_historicalBlocksSizesHeight = std::numeric_limits<uint32_t>::max();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+// Median of the sizes of the rewardBlocksWindow() blocks ending at the given height.
+// Precondition: m_blockchain_lock is locked.
+size_t Blockchain::blockSizeMedian(uint32_t height) {
+  assert(height < m_blocks.size());
+  if (height + 1 == m_blocks.size()) {
+    return m_lastBlocksSizes.median();
+  }
+
+  size_t windowSize = m_historicalBlocksSizes.windowSize();
+  if (m_historicalBlocksSizesHeight != std::numeric_limits<uint32_t>::max() && height == m_historicalBlocksSizesHeight + 1) {
+    m_historicalBlocksSizes.pushBack(m_blocks[height].block_cumulative_size);
+  } else if (m_historicalBlocksSizesHeight != std::numeric_limits<uint32_t>::max() && height + 1 == m_historicalBlocksSizesHeight) {
+    m_historicalBlocksSizes.popBack();
+    if (height + 1 >= windowSize) {
+      m_historicalBlocksSizes.pushFront(m_blocks[height + 1 - windowSize].block_cumulative_size);
+    }
+  } else if (height != m_historicalBlocksSizesHeight) {
+    m_historicalBlocksSizes.clear();
+    uint32_t startHeight = height + 1 - static_cast<uint32_t>(std::min<size_t>(height + 1, windowSize));
+    for (uint32_t i = startHeight; i <= height; ++i) {
+      m_historicalBlocksSizes.pushBack(m_blocks[i].block_cumulative_size);
+    }
+  }
+
+  m_historicalBlocksSizesHeight = height;
+  return m_historicalBlocksSizes.median();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Blockchain::getBlockRewardInfo(uint32_t height, BlockRewardInfo& info) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (height >= m_blocks.size()) {
+    logger(DEBUGGING) << "Can't get reward info for block at height " << height << ", blockchain height " << m_blocks.size();
+    return false;
+  }
+
+  if (!m_blockMetadata[height].rewardInfoCalculated) {
+    size_t sizeMedian = blockSizeMedian(height);
+    uint64_t prevBlockGeneratedCoins = height == 0 ? 0 : m_blocks[height - 1].already_generated_coins;
+    const BlockEntry& entry = m_blocks[height];
+    if (!m_currency.getBlockRewardInfo(entry.bl.majorVersion, sizeMedian, entry.block_cumulative_size, prevBlockGeneratedCoins, height, info)) {
+      logger(DEBUGGING) << "Failed to calculate reward info for block at height " << height;
+      return false;
+    }
+
+    BlockMetadata& metadata = m_blockMetadata[height];
+    metadata.sizeMedian = static_cast<uint32_t>(info.sizeMedian);
+    metadata.baseReward = info.baseReward;
+    metadata.currentReward = info.currentReward;
+    metadata.rewardInfoCalculated = true;
+    return true;
+  }
+
+  const BlockMetadata& metadata = m_blockMetadata[height];
+  info.sizeMedian = metadata.sizeMedian;
+  info.baseReward = metadata.baseReward;
+  info.currentReward = metadata.currentReward;
+  info.penalty = info.baseReward == 0 ? 0 : static_cast<double>(info.baseReward - info.currentReward) / static_cast<double>(info.baseReward);
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats Blockchain::getVerifiedSignaturesCacheStats() const {
+  return m_verifiedSignatures.getStats();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats Blockchain::getBlocksCacheStats() const {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return { m_blocks.cacheHits(), m_blocks.cacheMisses(), m_blocks.cacheSize() };
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Blockchain::getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (startHeight >= m_blocks.size()) {
+    logger(DEBUGGING) << "Can't get block summaries from height " << startHeight << ", blockchain height " << m_blocks.size();
+    return false;
+  }
+
+  uint32_t endHeight = static_cast<uint32_t>(std::min<uint64_t>(m_blocks.size(), static_cast<uint64_t>(startHeight) + count));
+  summaries.reserve(summaries.size() + (endHeight - startHeight));
+
+  difficulty_type previousCumulativeDifficulty = startHeight == 0 ? 0 : m_blocks[startHeight - 1].cumulative_difficulty;
+  for (uint32_t height = startHeight; height < endHeight; ++height) {
+    const BlockMetadata& metadata = blockMetadata(height);
+    const BlockEntry& entry = m_blocks[height];
+
+    BlockSummary summary;
+    summary.hash = m_blockIndex.getBlockId(height);
+    summary.previousBlockHash = entry.bl.previousBlockHash;
+    summary.height = height;
+    summary.depth = static_cast<uint32_t>(m_blocks.size() - height - 1);
+    summary.timestamp = entry.bl.timestamp;
+    summary.majorVersion = entry.bl.majorVersion;
+    summary.minorVersion = entry.bl.minorVersion;
+    summary.nonce = entry.bl.nonce;
+    summary.transactionsCumulativeSize = entry.block_cumulative_size;
+    summary.blockSize = metadata.headerSize + entry.block_cumulative_size;
+    summary.difficulty = entry.cumulative_difficulty - previousCumulativeDifficulty;
+    summary.reward = metadata.reward;
+    summary.alreadyGeneratedCoins = entry.already_generated_coins;
+    summary.transactionCount = metadata.transactionCount;
+    summaries.push_back(summary);
+
+    previousCumulativeDifficulty = entry.cumulative_difficulty;
+  }
+
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool Blockchain::getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary) {
+  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  uint32_t height;
+  if (!m_blockIndex.getBlockHeight(hash, height)) {
+    return false;
+  }
+
+  std::vector<BlockSummary> summaries;
+  if (!getBlockSummaries(height, 1, summaries)) {
+    return false;
+  }
+
+  summary = summaries.front();
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   MultisignatureOutputsContainer::const_iterator amountIter = m_multisignatureOutputs.find(txInMultisig.amount);
@@ -2598,8 +3019,7 @@ bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMulti
     return false;
   }
   const MultisignatureOutputUsage& outputIndex = amountIter->second[txInMultisig.outputIndex];
-  const Transaction& outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
-  outputReference.first = getObjectHash(outputTransaction);
+  outputReference.first = transactionHashByIndex(outputIndex.transactionIndex);
   outputReference.second = outputIndex.outputIndex;
   return true;
 }
@@ -2643,7 +3063,8 @@ bool Blockchain::loadBlockchainIndices() {
       m_generatedTransactionsIndex.add(block.bl);
       for (uint16_t t = 0; t < block.transactions.size(); ++t) {
         const TransactionEntry& transaction = block.transactions[t];
-        m_paymentIdIndex.add(transaction.tx);
+        Crypto::Hash transactionHash = t == 0 ? getObjectHash(transaction.tx) : block.bl.transactionHashes[t - 1];
+        m_paymentIdIndex.add(transaction.tx, transactionHash);
       }
     }
 
@@ -2673,30 +3094,29 @@ bool Blockchain::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std
   return m_paymentIdIndex.find(paymentId, transactionHashes);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool Blockchain::loadTransactions(const Block& block, std::vector<Transaction>& transactions, uint32_t height) {
-  transactions.resize(block.transactionHashes.size());
+bool Blockchain::loadTransactions(const Block& block, std::vector<CachedTransaction>& transactions, uint32_t height) {
+  transactions.clear();
+  transactions.reserve(block.transactionHashes.size());
   size_t transactionSize;
   uint64_t fee;
   for (size_t i = 0; i < block.transactionHashes.size(); ++i) {
-    if (!m_tx_pool.take_tx(block.transactionHashes[i], transactions[i], transactionSize, fee)) {
-      tx_verification_context context;
-      for (size_t j = 0; j < i; ++j) {
-        if (!m_tx_pool.add_tx(transactions[i - 1 - j], context, true, height)
-		) {
-          logger(WARNING, BRIGHT_YELLOW) << "Blockchain::saveTransactions, failed to add transaction to pool";
-        }
-      }
-
+    Transaction transaction;
+    if (!m_tx_pool.take_tx(block.transactionHashes[i], transaction, transactionSize, fee)) {
+      saveTransactions(transactions, height);
       return false;
     }
+
+    // hash and size are known by the pool, so the transaction isn't serialized again
+    transactions.emplace_back(std::move(transaction), block.transactionHashes[i], transactionSize);
   }
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-void Blockchain::saveTransactions(const std::vector<Transaction>& transactions, uint32_t height) {
+void Blockchain::saveTransactions(const std::vector<CachedTransaction>& transactions, uint32_t height) {
   tx_verification_context context;
   for (size_t i = 0; i < transactions.size(); ++i) {
-    if (!m_tx_pool.add_tx(transactions[transactions.size() - 1 - i], context, true, height)) {
+    const CachedTransaction& transaction = transactions[transactions.size() - 1 - i];
+    if (!m_tx_pool.add_tx(transaction.getTransaction(), transaction.getTransactionHash(), transaction.getTransactionBinarySize(), context, true, height)) {
       logger(WARNING, BRIGHT_YELLOW) << "Blockchain::saveTransactions, failed to add transaction to pool";
     }
   }
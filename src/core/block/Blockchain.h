@@ -6,6 +6,10 @@
 #include "google/sparse_hash_map"
 
 #include "ObserverManager.h"
+#include "common/BlockedBloomFilter.h"
+#include "common/FlatKeyTable.h"
+#include "common/Metrics.h"
+#include "common/SlidingWindowMedian.h"
 #include "common/Util.h"
 #include "BlockIndex.h"
 #include "Checkpoints.h"
@@ -15,6 +19,7 @@
 #include "ITransactionValidator.h"
 #include "SwappedVector.h"
 #include "base/CryptoNoteFormatUtils.h"
+#include "core/trans/CachedTransaction.h"
 #include "core/trans/TransactionPool.h"
 #include "BlockchainIndices.h"
 #include "core/UpgradeDetector.h"
@@ -22,6 +27,7 @@
 #include "core/MessageQueue.h"
 #include "BlockchainMessages.h"
 #include "IntrusiveLinkedList.h"
+#include "VerifiedSignatureCache.h"
 
 #include <log/LoggerRef.h>
 
@@ -35,6 +41,25 @@ namespace CryptoNote {
   struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount;
 
   using CryptoNote::BlockInfo;
+
+  struct BlockSummary {
+    Crypto::Hash hash;
+    Crypto::Hash previousBlockHash;
+    uint32_t height;
+    // blocks on top of this one when the summary was taken
+    uint32_t depth;
+    uint64_t timestamp;
+    uint8_t majorVersion;
+    uint8_t minorVersion;
+    uint32_t nonce;
+    uint64_t blockSize;
+    uint64_t transactionsCumulativeSize;
+    difficulty_type difficulty;
+    uint64_t reward;
+    uint64_t alreadyGeneratedCoins;
+    size_t transactionCount;
+  };
+
   class Blockchain : public CryptoNote::ITransactionValidator {
 	  
   public:
@@ -54,6 +79,11 @@ namespace CryptoNote {
     bool init(const std::string& config_folder, bool load_existing);
     bool deinit();
 
+    // keep signatures only for the last depth blocks, 0 disables pruning; takes effect on init
+    void setPruningDepth(uint32_t depth) { m_pruningDepth = depth; }
+    // transactions of blocks below this height are stored without signatures
+    uint32_t getPrunedHeight();
+
     bool getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_t& height);
     std::vector<Crypto::Hash> getBlockIds(uint32_t startHeight, uint32_t maxCount);
 
@@ -99,6 +129,11 @@ namespace CryptoNote {
     bool getBlockContainingTransaction(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight);
     bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins);
     bool getBlockSize(const Crypto::Hash& hash, size_t& size);
+    bool getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries);
+    bool getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary);
+    bool getBlockRewardInfo(uint32_t height, BlockRewardInfo& info);
+    TipQueryCacheStats getVerifiedSignaturesCacheStats() const;
+    TipQueryCacheStats getBlocksCacheStats() const;
     bool getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference);
     bool getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions);
     bool getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash>& blockHashes);
@@ -141,7 +176,7 @@ namespace CryptoNote {
 
       for (const auto& tx_id : txs_ids) {
         auto it = m_transactionMap.find(tx_id);
-        if (it == m_transactionMap.end()) {
+        if (it == m_transactionMap.end() || isTransactionPruned(it->second)) {
           missed_txs.push_back(tx_id);
         } else {
           txs.push_back(transactionByIndex(it->second).tx);
@@ -149,6 +184,21 @@ namespace CryptoNote {
       }
     }
 
+    // prefixes are kept for pruned transactions too, each one is returned with its transaction hash
+    template<class t_ids_container, class t_prefix_container, class t_missed_container>
+    void getTransactionPrefixes(const t_ids_container& txs_ids, t_prefix_container& prefixes, t_missed_container& missed_txs) {
+      std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+
+      for (const auto& tx_id : txs_ids) {
+        auto it = m_transactionMap.find(tx_id);
+        if (it == m_transactionMap.end()) {
+          missed_txs.push_back(tx_id);
+        } else {
+          prefixes.emplace_back(tx_id, static_cast<const TransactionPrefix&>(transactionByIndex(it->second).tx));
+        }
+      }
+    }
+
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void getTransactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs, bool checkTxPool = false) {
       if (checkTxPool){
@@ -202,6 +252,11 @@ namespace CryptoNote {
         s(tx, "tx");
         s(m_global_output_indexes, "indexes");
       }
+
+      void serializePruned(ISerializer& s) {
+        s(static_cast<TransactionPrefix&>(tx), "tx");
+        s(m_global_output_indexes, "indexes");
+      }
     };
 
     struct BlockEntry {
@@ -211,17 +266,53 @@ namespace CryptoNote {
       difficulty_type cumulative_difficulty;
       uint64_t already_generated_coins;
       std::vector<TransactionEntry> transactions;
+      bool pruned; // transactions have no signatures
+
+      static const uint32_t PRUNED_FLAG = 0x80000000;
 
       void serialize(ISerializer& s) {
         s(bl, "block");
-        s(height, "height");
+        // pruned entries are stored with PRUNED_FLAG set in the height
+        uint32_t storedHeight = pruned ? (height | PRUNED_FLAG) : height;
+        s(storedHeight, "height");
+        if (s.type() == ISerializer::INPUT) {
+          pruned = (storedHeight & PRUNED_FLAG) != 0;
+          height = storedHeight & ~PRUNED_FLAG;
+        }
+
         s(block_cumulative_size, "block_cumulative_size");
         s(cumulative_difficulty, "cumulative_difficulty");
         s(already_generated_coins, "already_generated_coins");
-        s(transactions, "transactions");
+        if (!pruned) {
+          s(transactions, "transactions");
+          return;
+        }
+
+        size_t count = transactions.size();
+        s.beginArray(count, "transactions");
+        if (s.type() == ISerializer::INPUT) {
+          transactions.resize(count);
+        }
+
+        for (TransactionEntry& transaction : transactions) {
+          transaction.serializePruned(s);
+        }
+
+        s.endArray();
       }
     };
 
+    // per-block data derived from serialized block, filled on first request
+    struct BlockMetadata {
+      uint32_t headerSize; // block blob size without miner transaction, 0 if not calculated yet
+      uint32_t transactionCount;
+      uint64_t reward;
+      bool rewardInfoCalculated;
+      uint32_t sizeMedian;
+      uint64_t baseReward;
+      uint64_t currentReward;
+    };
+
     typedef google::sparse_hash_set<Crypto::KeyImage> key_images_container;
     typedef std::unordered_map<Crypto::Hash, BlockEntry> blocks_ext_by_hash;
     typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //Crypto::Hash - tx hash, size_t - index of out in transaction
@@ -234,17 +325,37 @@ namespace CryptoNote {
     Tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
     key_images_container m_spent_keys;
+    // answers most have_tx_keyimg_as_spent() checks without a lookup in m_spent_keys
+    Common::BlockedBloomFilter<Crypto::KeyImage> m_spentKeysFilter;
     size_t m_current_block_cumul_sz_limit;
+    // sizes of the last rewardBlocksWindow() blocks of the main chain
+    Common::SlidingWindowMedian<size_t> m_lastBlocksSizes;
+    // window used to calculate size medians of older blocks, ends at m_historicalBlocksSizesHeight
+    Common::SlidingWindowMedian<size_t> m_historicalBlocksSizes;
+    uint32_t m_historicalBlocksSizesHeight;
     blocks_ext_by_hash m_alternative_chains; // Crypto::Hash -> block_extended_info
     outputs_container m_outputs;
 
     std::string m_config_folder;
     Checkpoints m_checkpoints;
     std::atomic<bool> m_is_in_checkpoint_zone;
+    VerifiedSignatureCache m_verifiedSignatures;
+
+    Common::MetricsHistogram& m_blockProcessingTime;
+    Common::MetricsHistogram& m_difficultyCalculatingTime;
+    Common::MetricsHistogram& m_proofOfWorkCalculatingTime;
+    Common::MetricsCounter& m_mainChainBlocks;
+    Common::MetricsCounter& m_alternativeBlocks;
+    Common::MetricsCounter& m_rejectedBlocks;
+    Common::MetricsCounter& m_spentKeysFilterNegatives;
+    Common::MetricsCounter& m_spentKeysFilterPositives;
+    Common::MetricsCounter& m_spentKeysFilterFalsePositives;
+    Common::MetricsGauge& m_prunedHeightGauge;
+    Common::MetricsCounter& m_prunedBytes;
 
     typedef SwappedVector<BlockEntry> Blocks;
     typedef std::unordered_map<Crypto::Hash, uint32_t> BlockMap;
-    typedef std::unordered_map<Crypto::Hash, TransactionIndex> TransactionMap;
+    typedef Common::FlatKeyMap<Crypto::Hash, TransactionIndex> TransactionMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
 
     friend class BlockCacheSerializer;
@@ -254,6 +365,7 @@ namespace CryptoNote {
     CryptoNote::BlockIndex m_blockIndex;
     CryptoNote::DepositIndex m_depositIndex;
     TransactionMap m_transactionMap;
+    std::vector<BlockMetadata> m_blockMetadata;
     MultisignatureOutputsContainer m_multisignatureOutputs;
     UpgradeDetector m_upgradeDetectorv2;
     UpgradeDetector m_upgradeDetectorv3;
@@ -263,12 +375,19 @@ namespace CryptoNote {
     GeneratedTransactionsIndex m_generatedTransactionsIndex;
     OrphanBlocksIndex m_orthanBlocksIndex;
     bool m_blockchainIndexesEnabled;
+    uint32_t m_pruningDepth;
+    uint32_t m_prunedHeight;
 
     IntrusiveLinkedList<MessageQueue<BlockchainMessage>> m_messageQueueList;
 
     Logging::LoggerRef logger;
 
     void rebuildCache();
+    uint32_t findPrunedHeight();
+    bool pruneBlocks();
+    bool isTransactionPruned(const TransactionIndex& index) const;
+    void addSpentKeyToFilter(const Crypto::KeyImage& keyImage);
+    void rebuildSpentKeysFilter();
     bool storeCache();
     bool switch_to_alternative_blockchain(std::list<blocks_ext_by_hash::iterator>& alt_chain, bool discard_disconnected_chain);
     bool handle_alternative_block(const Block& b, const Crypto::Hash& id, block_verification_context& bvc, bool sendNewAlternativeBlockMessage = true);
@@ -277,7 +396,6 @@ namespace CryptoNote {
     bool prevalidate_miner_transaction(const Block& b, uint32_t height);
     bool validate_miner_transaction(const Block& b, uint32_t height, size_t cumulativeBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint64_t& reward, int64_t& emissionChange);
     bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
-    bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
     bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
     bool is_tx_spendtime_unlocked(uint64_t unlock_time);
     size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
@@ -292,14 +410,19 @@ namespace CryptoNote {
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
     bool check_tx_input(const KeyInput& txin, const Crypto::Hash& tx_prefix_hash, const std::vector<Crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
+    bool checkTransactionInputs(const Transaction& tx, const Crypto::Hash& transactionHash, const Crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
     bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
+    bool checkTransactionInputs(const CachedTransaction& transaction, uint32_t* pmax_used_block_height = NULL);
     bool check_tx_outputs(const Transaction& tx) const;
     bool have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im);
     const TransactionEntry& transactionByIndex(TransactionIndex index);
+    Crypto::Hash transactionHashByIndex(TransactionIndex index);
+    const BlockMetadata& blockMetadata(uint32_t height);
+    size_t blockSizeMedian(uint32_t height);
+    void resetLastBlocksSizes();
     bool pushBlock(const Block& blockData, block_verification_context& bvc, uint32_t height);
-    bool pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, block_verification_context& bvc);
-    bool pushBlock(BlockEntry& block);
+    bool pushBlock(const Block& blockData, const std::vector<CachedTransaction>& transactions, block_verification_context& bvc);
+    bool pushBlock(BlockEntry&& block);
     void popBlock();
     bool pushTransaction(BlockEntry& block, const Crypto::Hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const Crypto::Hash& transactionHash);
@@ -313,8 +436,8 @@ namespace CryptoNote {
     bool storeBlockchainIndices();
     bool loadBlockchainIndices();
 
-    bool loadTransactions(const Block& block, std::vector<Transaction>& transactions, uint32_t height);
-    void saveTransactions(const std::vector<Transaction>& transactions, uint32_t height);
+    bool loadTransactions(const Block& block, std::vector<CachedTransaction>& transactions, uint32_t height);
+    void saveTransactions(const std::vector<CachedTransaction>& transactions, uint32_t height);
 
     void sendMessage(const BlockchainMessage& message);
 
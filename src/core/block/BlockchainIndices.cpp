@@ -15,13 +15,12 @@ namespace {
 PaymentIdIndex::PaymentIdIndex(bool _enabled) : enabled(_enabled), index(DEFAULT_BUCKET_COUNT, paymentIdHash) {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool PaymentIdIndex::add(const Transaction& transaction) {
+bool PaymentIdIndex::add(const Transaction& transaction, const Crypto::Hash& transactionHash) {
   if (!enabled) {
     return false;
   }
 
   Crypto::Hash paymentId;
-  Crypto::Hash transactionHash = getObjectHash(transaction);
   if (!BlockchainExplorerDataBuilder::getPaymentId(transaction, paymentId)) {
     return false;
   }
@@ -31,13 +30,12 @@ bool PaymentIdIndex::add(const Transaction& transaction) {
   return true;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
-bool PaymentIdIndex::remove(const Transaction& transaction) {
+bool PaymentIdIndex::remove(const Transaction& transaction, const Crypto::Hash& transactionHash) {
   if (!enabled) {
     return false;
   }
 
   Crypto::Hash paymentId;
-  Crypto::Hash transactionHash = getObjectHash(transaction);
   if (!BlockchainExplorerDataBuilder::getPaymentId(transaction, paymentId)) {
     return false;
   }
@@ -22,8 +22,9 @@ public:
 
   PaymentIdIndex(bool enabled);
 
-  bool add(const Transaction& transaction);
-  bool remove(const Transaction& transaction);
+  // transactionHash is passed in, pruned transactions have no signatures to calculate it from
+  bool add(const Transaction& transaction, const Crypto::Hash& transactionHash);
+  bool remove(const Transaction& transaction, const Crypto::Hash& transactionHash);
   bool find(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes);
   void clear();
 
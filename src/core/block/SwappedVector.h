@@ -144,6 +144,11 @@ public:
   void clear();
   void pop_back();
   void push_back(const T& item);
+  void push_back(T&& item);
+
+  uint64_t cacheHits() const;
+  uint64_t cacheMisses() const;
+  size_t cacheSize() const;
 
 private:
   struct ItemEntry;
@@ -171,6 +176,7 @@ private:
   uint64_t m_cacheMisses;
 
   T* prepare(uint64_t index);
+  void write(const T& item);
 };
 
 template<class T> SwappedVector<T>::SwappedVector() {
@@ -235,7 +241,28 @@ template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, c
 }
 
 template<class T> void SwappedVector<T>::close() {
+  if (!m_itemsFile.is_open()) {
+    return;
+  }
+
   std::cout << "SwappedVector cache hits: " << m_cacheHits << ", misses: " << m_cacheMisses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(m_cacheMisses) / (m_cacheHits + m_cacheMisses) * 100 << "%)" << std::endl;
+  m_itemsFile.close();
+  m_indexesFile.close();
+  m_offsets.clear();
+  m_items.clear();
+  m_cache.clear();
+}
+
+template<class T> uint64_t SwappedVector<T>::cacheHits() const {
+  return m_cacheHits;
+}
+
+template<class T> uint64_t SwappedVector<T>::cacheMisses() const {
+  return m_cacheMisses;
+}
+
+template<class T> size_t SwappedVector<T>::cacheSize() const {
+  return m_cache.size();
 }
 
 template<class T> bool SwappedVector<T>::empty() const {
@@ -334,6 +361,20 @@ template<class T> void SwappedVector<T>::pop_back() {
 }
 
 template<class T> void SwappedVector<T>::push_back(const T& item) {
+  write(item);
+
+  T* newItem = prepare(m_offsets.size() - 1);
+  *newItem = item;
+}
+
+template<class T> void SwappedVector<T>::push_back(T&& item) {
+  write(item);
+
+  T* newItem = prepare(m_offsets.size() - 1);
+  *newItem = std::move(item);
+}
+
+template<class T> void SwappedVector<T>::write(const T& item) {
   uint64_t itemsFileSize;
 
   {
@@ -372,9 +413,6 @@ template<class T> void SwappedVector<T>::push_back(const T& item) {
 
   m_offsets.push_back(m_itemsFileSize);
   m_itemsFileSize = itemsFileSize;
-
-  T* newItem = prepare(m_offsets.size() - 1);
-  *newItem = item;
 }
 
 template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
@@ -0,0 +1,74 @@
+#include "VerifiedSignatureCache.h"
+
+#include <cstring>
+
+namespace CryptoNote {
+
+VerifiedSignatureCache::VerifiedSignatureCache(size_t maxEntries) : m_maxEntries(maxEntries), m_hits(0), m_misses(0) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Crypto::Hash VerifiedSignatureCache::makeKey(const Crypto::Hash& prefixHash, const Crypto::KeyImage& keyImage,
+  const std::vector<const Crypto::PublicKey*>& outputKeys, const std::vector<Crypto::Signature>& signatures) {
+
+  std::vector<uint8_t> data(sizeof(Crypto::Hash) + sizeof(Crypto::KeyImage) + outputKeys.size() * sizeof(Crypto::PublicKey) +
+    signatures.size() * sizeof(Crypto::Signature));
+
+  uint8_t* position = data.data();
+  std::memcpy(position, &prefixHash, sizeof(prefixHash));
+  position += sizeof(prefixHash);
+  std::memcpy(position, &keyImage, sizeof(keyImage));
+  position += sizeof(keyImage);
+
+  for (const Crypto::PublicKey* key : outputKeys) {
+    std::memcpy(position, key, sizeof(Crypto::PublicKey));
+    position += sizeof(Crypto::PublicKey);
+  }
+
+  if (!signatures.empty()) {
+    std::memcpy(position, signatures.data(), signatures.size() * sizeof(Crypto::Signature));
+  }
+
+  return Crypto::cn_fast_hash(data.data(), data.size());
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool VerifiedSignatureCache::contains(const Crypto::Hash& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_entries.count(key) == 0) {
+    ++m_misses;
+    return false;
+  }
+
+  ++m_hits;
+  return true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void VerifiedSignatureCache::insert(const Crypto::Hash& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_entries.insert(key).second) {
+    return;
+  }
+
+  m_insertionOrder.push_back(key);
+  if (m_insertionOrder.size() > m_maxEntries) {
+    m_entries.erase(m_insertionOrder.front());
+    m_insertionOrder.pop_front();
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void VerifiedSignatureCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_insertionOrder.clear();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+TipQueryCacheStats VerifiedSignatureCache::getStats() const {
+  TipQueryCacheStats stats;
+  stats.hits = m_hits.load();
+  stats.misses = m_misses.load();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stats.entries = m_entries.size();
+  return stats;
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "core/TipQueryCache.h"
+
+namespace CryptoNote {
+
+// Remembers ring signatures which passed verification, so transactions checked on pool admission
+// are not verified again when they arrive in a block. An entry is keyed by everything the check depends on
+// (prefix hash, key image, ring member keys and signatures), so a hit stays valid whatever the chain state is.
+// The oldest entries are dropped when the cache is full.
+class VerifiedSignatureCache {
+public:
+  explicit VerifiedSignatureCache(size_t maxEntries);
+
+  static Crypto::Hash makeKey(const Crypto::Hash& prefixHash, const Crypto::KeyImage& keyImage,
+    const std::vector<const Crypto::PublicKey*>& outputKeys, const std::vector<Crypto::Signature>& signatures);
+
+  bool contains(const Crypto::Hash& key);
+  void insert(const Crypto::Hash& key);
+  void clear();
+
+  TipQueryCacheStats getStats() const;
+
+private:
+  const size_t m_maxEntries;
+  mutable std::mutex m_mutex;
+  std::unordered_set<Crypto::Hash> m_entries;
+  std::deque<Crypto::Hash> m_insertionOrder;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+}
@@ -15,6 +15,7 @@
 #include "crypto/crypto.h"
 #include "common/CommandLine.h"
 #include "common/StringTools.h"
+#include "common/ThreadPool.h"
 #include "Serialization/SerializationTools.h"
 
 #include "base/CryptoNoteFormatUtils.h"
@@ -259,37 +260,45 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------------------------
   bool miner::find_nonce_for_given_block(Crypto::cn_context &context, Block& bl, const difficulty_type& diffic) {
 
-    unsigned nthreads = std::thread::hardware_concurrency();
+    Common::ThreadPool& pool = Common::ThreadPool::instance();
+    unsigned nthreads = static_cast<unsigned>(pool.getThreadCount());
 
-    if (nthreads > 0 && diffic > 5) {
-      std::vector<std::future<void>> threads(nthreads);
+    if (nthreads > 1 && diffic > 5) {
+      std::vector<std::future<void>> threads;
       std::atomic<uint32_t> foundNonce;
       std::atomic<bool> found(false);
       uint32_t startNonce = Crypto::rand<uint32_t>();
 
-      for (unsigned i = 0; i < nthreads; ++i) {
-        threads[i] = std::async(std::launch::async, [&, i]() {
-          Crypto::cn_context localctx;
-          Crypto::Hash h;
+      auto search = [&](Crypto::cn_context& localctx, unsigned i) {
+        Crypto::Hash h;
 
-          Block lb(bl); // copy to local block
+        Block lb(bl); // copy to local block
 
-          for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
+        for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
+          lb.nonce = nonce;
 
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
+          if (!get_block_longhash(localctx, lb, h)) {
+            return;
+          }
 
-            if (check_hash(h, diffic)) {
-              foundNonce = nonce;
-              found = true;
-              return;
-            }
+          if (check_hash(h, diffic)) {
+            foundNonce = nonce;
+            found = true;
+            return;
           }
-        });
+        }
+      };
+
+      for (unsigned i = 1; i < nthreads; ++i) {
+        threads.push_back(pool.submit([&search, i]() {
+          Crypto::cn_context localctx;
+          search(localctx, i);
+        }));
       }
 
+      // the calling thread searches the first sequence of nonces, so the search progresses even if the pool is busy
+      search(context, 0);
+
       for (auto& t : threads) {
         t.wait();
       }
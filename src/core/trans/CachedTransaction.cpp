@@ -0,0 +1,53 @@
+#include "CachedTransaction.h"
+
+#include "base/CryptoNoteTools.h"
+
+namespace CryptoNote {
+
+CachedTransaction::CachedTransaction(Transaction&& transaction) : transaction(std::move(transaction)) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+CachedTransaction::CachedTransaction(const Transaction& transaction) : transaction(transaction) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+CachedTransaction::CachedTransaction(Transaction&& transaction, const Crypto::Hash& transactionHash, size_t transactionBinarySize) :
+  transaction(std::move(transaction)), transactionHash(transactionHash), transactionBinarySize(transactionBinarySize) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const Transaction& CachedTransaction::getTransaction() const {
+  return transaction;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const Crypto::Hash& CachedTransaction::getTransactionHash() const {
+  if (!transactionHash.is_initialized()) {
+    transactionHash = getBinaryArrayHash(getTransactionBinaryArray());
+  }
+
+  return transactionHash.get();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const Crypto::Hash& CachedTransaction::getTransactionPrefixHash() const {
+  if (!transactionPrefixHash.is_initialized()) {
+    transactionPrefixHash = getObjectHash(static_cast<const TransactionPrefix&>(transaction));
+  }
+
+  return transactionPrefixHash.get();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+const BinaryArray& CachedTransaction::getTransactionBinaryArray() const {
+  if (!transactionBinaryArray.is_initialized()) {
+    transactionBinaryArray = toBinaryArray(transaction);
+  }
+
+  return transactionBinaryArray.get();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+size_t CachedTransaction::getTransactionBinarySize() const {
+  if (!transactionBinarySize.is_initialized()) {
+    transactionBinarySize = getTransactionBinaryArray().size();
+  }
+
+  return transactionBinarySize.get();
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "base/CryptoNoteBasic.h"
+
+namespace CryptoNote {
+
+// Transaction together with its binary representation, hash and prefix hash.
+// Each of them is computed at most once, on first request, and values already known
+// to the caller (e.g. from the pool or the parsed blob) can be passed to the constructor.
+// The transaction itself can't be changed, so cached values never go stale.
+// Not thread safe: lazy getters modify the cache.
+class CachedTransaction {
+public:
+  explicit CachedTransaction(Transaction&& transaction);
+  explicit CachedTransaction(const Transaction& transaction);
+  CachedTransaction(Transaction&& transaction, const Crypto::Hash& transactionHash, size_t transactionBinarySize);
+
+  const Transaction& getTransaction() const;
+  const Crypto::Hash& getTransactionHash() const;
+  const Crypto::Hash& getTransactionPrefixHash() const;
+  const BinaryArray& getTransactionBinaryArray() const;
+  size_t getTransactionBinarySize() const;
+
+private:
+  Transaction transaction;
+  mutable boost::optional<BinaryArray> transactionBinaryArray;
+  mutable boost::optional<Crypto::Hash> transactionHash;
+  mutable boost::optional<Crypto::Hash> transactionPrefixHash;
+  mutable boost::optional<size_t> transactionBinarySize;
+};
+
+}
@@ -8,6 +8,7 @@
 #include <boost/filesystem.hpp>
 
 #include "int-util.h"
+#include "common/ScopeExit.h"
 #include "common/Util.h"
 #include "crypto/hash.h"
 
@@ -98,10 +99,25 @@ namespace CryptoNote {
     m_fee_index(boost::get<1>(m_transactions)),
     logger(log, "txpool"),
     m_paymentIdIndex(blockchainIndexesEnabled),
-    m_timestampIndex(blockchainIndexesEnabled) {
+    m_timestampIndex(blockchainIndexesEnabled),
+    m_admissionTime(Common::MetricsRegistry::instance().histogram("txpool_admission_seconds", "Time spent checking and adding a transaction to the pool")),
+    m_acceptedTransactions(Common::MetricsRegistry::instance().counter("txpool_transactions_total", "Transactions passed to the pool", "result=\"accepted\"")),
+    m_rejectedTransactions(Common::MetricsRegistry::instance().counter("txpool_transactions_total", "Transactions passed to the pool", "result=\"rejected\"")),
+    m_spentKeyImagesFilterNegatives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"txpool\",result=\"negative\"")),
+    m_spentKeyImagesFilterPositives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"txpool\",result=\"positive\"")),
+    m_spentKeyImagesFilterFalsePositives(Common::MetricsRegistry::instance().counter("key_image_filter_checks_total", "Spent key image checks by filter result", "set=\"txpool\",result=\"false_positive\"")) {
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::add_tx(const Transaction &tx, /*const Crypto::Hash& tx_prefix_hash,*/ const Crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
+    Common::MetricsTimer admissionTimer(m_admissionTime);
+    Tools::ScopeExit countResult([this, &tvc] {
+      if (tvc.m_verification_failed) {
+        m_rejectedTransactions.increment();
+      } else if (tvc.m_added_to_pool) {
+        m_acceptedTransactions.increment();
+      }
+    });
+
     if (!check_inputs_types_supported(tx)) {
       tvc.m_verification_failed = true;
       return false;
@@ -217,8 +233,8 @@ namespace CryptoNote {
         logger(ERROR, BRIGHT_RED) << "transaction already exists at inserting in memory pool";
         return false;
       }
-      m_paymentIdIndex.add(txd.tx);
-      m_timestampIndex.add(txd.receiveTime, txd.id);
+      m_paymentIdIndex.add(txd_p.first->tx, txd_p.first->id);
+      m_timestampIndex.add(txd_p.first->receiveTime, txd_p.first->id);
 
       if (ttl.ttl != 0) {
         m_ttlIndex.emplace(std::make_pair(id, ttl.ttl));
@@ -459,6 +475,7 @@ namespace CryptoNote {
       m_transactions.clear();
       m_spent_key_images.clear();
       m_spentOutputs.clear();
+      rebuildSpentKeyImagesFilter();
 
       m_paymentIdIndex.clear();
       m_timestampIndex.clear();
@@ -585,7 +602,7 @@ namespace CryptoNote {
 
   tx_memory_pool::tx_container_t::iterator tx_memory_pool::removeTransaction(tx_memory_pool::tx_container_t::iterator i) {
     removeTransactionInputs(i->id, i->tx, i->keptByBlock);
-    m_paymentIdIndex.remove(i->tx);
+    m_paymentIdIndex.remove(i->tx, i->id);
     m_timestampIndex.remove(i->receiveTime, i->id);
     m_ttlIndex.erase(i->id);
     return m_transactions.erase(i);
@@ -609,6 +626,7 @@ namespace CryptoNote {
         if (key_image_set.empty()) {
           //it is now empty hash container for this key_image
           m_spent_key_images.erase(it);
+          m_spentKeyImagesFilter.removed();
         }
       } else if (in.type() == typeid(MultisignatureInput)) {
         if (!keptByBlock) {
@@ -642,6 +660,14 @@ namespace CryptoNote {
           logger(ERROR, BRIGHT_RED) << "internal error: try to insert duplicate iterator in key_image set";
           return false;
         }
+
+        if (kei_image_set.size() == 1) {
+          if (m_spentKeyImagesFilter.needsRebuild()) {
+            rebuildSpentKeyImagesFilter();
+          } else {
+            m_spentKeyImagesFilter.add(txin.keyImage);
+          }
+        }
       } else if (in.type() == typeid(MultisignatureInput)) {
         if (!keptByBlock) {
           const auto& msig = boost::get<MultisignatureInput>(in);
@@ -660,8 +686,13 @@ namespace CryptoNote {
     for (const auto& in : tx.inputs) {
       if (in.type() == typeid(KeyInput)) {
         const auto& tokey_in = boost::get<KeyInput>(in);
-        if (m_spent_key_images.count(tokey_in.keyImage)) {
+        if (!m_spentKeyImagesFilter.mayContain(tokey_in.keyImage)) {
+          m_spentKeyImagesFilterNegatives.increment();
+        } else if (m_spent_key_images.count(tokey_in.keyImage)) {
+          m_spentKeyImagesFilterPositives.increment();
           return true;
+        } else {
+          m_spentKeyImagesFilterFalsePositives.increment();
         }
       } else if (in.type() == typeid(MultisignatureInput)) {
         const auto& msig = boost::get<MultisignatureInput>(in);
@@ -684,7 +715,7 @@ namespace CryptoNote {
   void tx_memory_pool::buildIndices() {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
     for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
-      m_paymentIdIndex.add(it->tx);
+      m_paymentIdIndex.add(it->tx, it->id);
       m_timestampIndex.add(it->receiveTime, it->id);
 
       std::vector<TransactionExtraField> txExtraFields;
@@ -696,6 +727,15 @@ namespace CryptoNote {
         }
       }
     }
+
+    rebuildSpentKeyImagesFilter();
+  }
+
+  void tx_memory_pool::rebuildSpentKeyImagesFilter() {
+    m_spentKeyImagesFilter.clear(m_spent_key_images.size() * 2);
+    for (const auto& keyImage : m_spent_key_images) {
+      m_spentKeyImagesFilter.add(keyImage.first);
+    }
   }
 
   bool tx_memory_pool::getTransactionIdsByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionIds) {
@@ -12,6 +12,8 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
 
+#include "common/BlockedBloomFilter.h"
+#include "common/Metrics.h"
 #include "common/Util.h"
 #include "int-util.h"
 #include "ObserverManager.h"
@@ -179,12 +181,15 @@ namespace CryptoNote {
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
 
     void buildIndices();
+    void rebuildSpentKeyImagesFilter();
 
     Tools::ObserverManager<ITxPoolObserver> m_observerManager;
     const CryptoNote::Currency& m_currency;
     OnceInTimeInterval m_txCheckInterval;
     mutable std::recursive_mutex m_transactions_lock;
     key_images_container m_spent_key_images;
+    // answers most haveSpentInputs() checks without a lookup in m_spent_key_images
+    Common::BlockedBloomFilter<Crypto::KeyImage> m_spentKeyImagesFilter;
     GlobalOutputsContainer m_spentOutputs;
 
     std::string m_config_folder;
@@ -200,5 +205,12 @@ namespace CryptoNote {
     PaymentIdIndex m_paymentIdIndex;
     TimestampTransactionsIndex m_timestampIndex;
     std::unordered_map<Crypto::Hash, uint64_t> m_ttlIndex;
+
+    Common::MetricsHistogram& m_admissionTime;
+    Common::MetricsCounter& m_acceptedTransactions;
+    Common::MetricsCounter& m_rejectedTransactions;
+    Common::MetricsCounter& m_spentKeyImagesFilterNegatives;
+    Common::MetricsCounter& m_spentKeyImagesFilterPositives;
+    Common::MetricsCounter& m_spentKeyImagesFilterFalsePositives;
   };
 }
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "crypto-ops.h"
@@ -309,6 +310,115 @@ static int fe_isnonzero(const fe f) {
     s[27] | s[28] | s[29] | s[30] | s[31]) - 1) >> 8) + 1;
 }
 
+#if defined(__SIZEOF_INT128__) && !defined(CRYPTO_OPS_REF10)
+#define FE_MUL_64
+
+/* 64-bit backend: fe_mul51 and fe_sq51 regroup the ten 25.5-bit limbs into five 51-bit ones
+   and multiply them with 128-bit products, 25 multiplications instead of 100.
+   Inputs and outputs keep the ref10 representation and bounds, so the rest of the code is unchanged.
+   It is only used after fe_mul_check_backends() has compared it with ref10, see below. */
+
+typedef unsigned __int128 fe_uint128;
+
+static void fe_to51(uint64_t r[5], const fe f) {
+  /* adds 2p (limbs 2^52 - 38, 2^52 - 2) so that limbs of negative-limbed inputs stay nonnegative */
+  r[0] = (uint64_t) ((int64_t) f[0] + ((int64_t) f[1] << 26) + 0xfffffffffffdaLL);
+  r[1] = (uint64_t) ((int64_t) f[2] + ((int64_t) f[3] << 26) + 0xffffffffffffeLL);
+  r[2] = (uint64_t) ((int64_t) f[4] + ((int64_t) f[5] << 26) + 0xffffffffffffeLL);
+  r[3] = (uint64_t) ((int64_t) f[6] + ((int64_t) f[7] << 26) + 0xffffffffffffeLL);
+  r[4] = (uint64_t) ((int64_t) f[8] + ((int64_t) f[9] << 26) + 0xffffffffffffeLL);
+}
+
+static void fe_from51(fe h, fe_uint128 t0, fe_uint128 t1, fe_uint128 t2, fe_uint128 t3, fe_uint128 t4) {
+  const uint64_t mask51 = (((uint64_t) 1) << 51) - 1;
+  uint64_t r0, r1, r2, r3, r4;
+  int64_t h0, h1, h2, h3, h4, h5, h6, h7, h8, h9;
+  int64_t carry0, carry1, carry2, carry3, carry4, carry5, carry6, carry7, carry8, carry9;
+
+  t1 += t0 >> 51; r0 = (uint64_t) t0 & mask51;
+  t2 += t1 >> 51; r1 = (uint64_t) t1 & mask51;
+  t3 += t2 >> 51; r2 = (uint64_t) t2 & mask51;
+  t4 += t3 >> 51; r3 = (uint64_t) t3 & mask51;
+  t0 = (t4 >> 51) * 19 + r0; r4 = (uint64_t) t4 & mask51;
+  r1 += (uint64_t) (t0 >> 51); r0 = (uint64_t) t0 & mask51;
+
+  h0 = (int64_t) (r0 & 0x3ffffff); h1 = (int64_t) (r0 >> 26);
+  h2 = (int64_t) (r1 & 0x3ffffff); h3 = (int64_t) (r1 >> 26);
+  h4 = (int64_t) (r2 & 0x3ffffff); h5 = (int64_t) (r2 >> 26);
+  h6 = (int64_t) (r3 & 0x3ffffff); h7 = (int64_t) (r3 >> 26);
+  h8 = (int64_t) (r4 & 0x3ffffff); h9 = (int64_t) (r4 >> 26);
+
+  /* same rounding carries as in ref10, to get signed limbs within its output bounds */
+  carry0 = (h0 + (int64_t) (1<<25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+  carry4 = (h4 + (int64_t) (1<<25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry1 = (h1 + (int64_t) (1<<24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+  carry5 = (h5 + (int64_t) (1<<24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+  carry2 = (h2 + (int64_t) (1<<25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+  carry6 = (h6 + (int64_t) (1<<25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+  carry3 = (h3 + (int64_t) (1<<24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+  carry7 = (h7 + (int64_t) (1<<24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+  carry4 = (h4 + (int64_t) (1<<25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+  carry8 = (h8 + (int64_t) (1<<25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+  carry9 = (h9 + (int64_t) (1<<24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+  carry0 = (h0 + (int64_t) (1<<25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+
+  h[0] = (int32_t) h0;
+  h[1] = (int32_t) h1;
+  h[2] = (int32_t) h2;
+  h[3] = (int32_t) h3;
+  h[4] = (int32_t) h4;
+  h[5] = (int32_t) h5;
+  h[6] = (int32_t) h6;
+  h[7] = (int32_t) h7;
+  h[8] = (int32_t) h8;
+  h[9] = (int32_t) h9;
+}
+
+static void fe_mul51(fe h, const fe f, const fe g) {
+  uint64_t a[5];
+  uint64_t b[5];
+  uint64_t b1_19, b2_19, b3_19, b4_19;
+  fe_uint128 t0, t1, t2, t3, t4;
+
+  fe_to51(a, f);
+  fe_to51(b, g);
+  b1_19 = b[1] * 19;
+  b2_19 = b[2] * 19;
+  b3_19 = b[3] * 19;
+  b4_19 = b[4] * 19;
+
+  t0 = (fe_uint128) a[0] * b[0] + (fe_uint128) a[1] * b4_19 + (fe_uint128) a[2] * b3_19 + (fe_uint128) a[3] * b2_19 + (fe_uint128) a[4] * b1_19;
+  t1 = (fe_uint128) a[0] * b[1] + (fe_uint128) a[1] * b[0] + (fe_uint128) a[2] * b4_19 + (fe_uint128) a[3] * b3_19 + (fe_uint128) a[4] * b2_19;
+  t2 = (fe_uint128) a[0] * b[2] + (fe_uint128) a[1] * b[1] + (fe_uint128) a[2] * b[0] + (fe_uint128) a[3] * b4_19 + (fe_uint128) a[4] * b3_19;
+  t3 = (fe_uint128) a[0] * b[3] + (fe_uint128) a[1] * b[2] + (fe_uint128) a[2] * b[1] + (fe_uint128) a[3] * b[0] + (fe_uint128) a[4] * b4_19;
+  t4 = (fe_uint128) a[0] * b[4] + (fe_uint128) a[1] * b[3] + (fe_uint128) a[2] * b[2] + (fe_uint128) a[3] * b[1] + (fe_uint128) a[4] * b[0];
+
+  fe_from51(h, t0, t1, t2, t3, t4);
+}
+
+static void fe_sq51(fe h, const fe f, int shift) {
+  uint64_t a[5];
+  uint64_t d0, d1, d2, a3_19, a4_19;
+  fe_uint128 t0, t1, t2, t3, t4;
+
+  fe_to51(a, f);
+  d0 = a[0] * 2;
+  d1 = a[1] * 2;
+  d2 = a[2] * 2;
+  a3_19 = a[3] * 19;
+  a4_19 = a[4] * 19;
+
+  t0 = (fe_uint128) a[0] * a[0] + (fe_uint128) d1 * a4_19 + (fe_uint128) d2 * a3_19;
+  t1 = (fe_uint128) d0 * a[1] + (fe_uint128) d2 * a4_19 + (fe_uint128) a[3] * a3_19;
+  t2 = (fe_uint128) d0 * a[2] + (fe_uint128) a[1] * a[1] + (fe_uint128) (a[3] * 2) * a4_19;
+  t3 = (fe_uint128) d0 * a[3] + (fe_uint128) d1 * a[2] + (fe_uint128) a[4] * a4_19;
+  t4 = (fe_uint128) d0 * a[4] + (fe_uint128) d1 * a[3] + (fe_uint128) a[2] * a[2];
+
+  fe_from51(h, t0 << shift, t1 << shift, t2 << shift, t3 << shift, t4 << shift);
+}
+
+#endif
+
 /* From fe_mul.c */
 
 /*
@@ -343,7 +453,7 @@ Can get away with 11 carries, but then data flow is much deeper.
 With tighter constraints on inputs can squeeze carries into int32.
 */
 
-static void fe_mul(fe h, const fe f, const fe g) {
+static void fe_mul_ref10(fe h, const fe f, const fe g) {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
   int32_t f2 = f[2];
@@ -623,7 +733,7 @@ Postconditions:
 See fe_mul.c for discussion of implementation strategy.
 */
 
-static void fe_sq(fe h, const fe f) {
+static void fe_sq_ref10(fe h, const fe f) {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
   int32_t f2 = f[2];
@@ -771,7 +881,7 @@ Postconditions:
 See fe_mul.c for discussion of implementation strategy.
 */
 
-static void fe_sq2(fe h, const fe f) {
+static void fe_sq2_ref10(fe h, const fe f) {
   int32_t f0 = f[0];
   int32_t f1 = f[1];
   int32_t f2 = f[2];
@@ -913,6 +1023,139 @@ static void fe_sq2(fe h, const fe f) {
   h[9] = (int32_t) h9;
 }
 
+/* Field multiplication backend selection */
+
+#ifdef FE_MUL_64
+
+/* Set once before main() by fe_mul_select(), ref10 is used until then */
+static int fe_mul_64_enabled = 0;
+
+static void fe_mul(fe h, const fe f, const fe g) {
+  if (fe_mul_64_enabled) {
+    fe_mul51(h, f, g);
+  } else {
+    fe_mul_ref10(h, f, g);
+  }
+}
+
+static void fe_sq(fe h, const fe f) {
+  if (fe_mul_64_enabled) {
+    fe_sq51(h, f, 0);
+  } else {
+    fe_sq_ref10(h, f);
+  }
+}
+
+static void fe_sq2(fe h, const fe f) {
+  if (fe_mul_64_enabled) {
+    fe_sq51(h, f, 1);
+  } else {
+    fe_sq2_ref10(h, f);
+  }
+}
+
+static uint64_t fe_check_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* Limbs within the fe_mul preconditions: random (pattern 0), all at the upper bound (1), all at the lower bound (2)
+   or alternating between them (3) */
+static void fe_check_input(fe f, uint64_t *state, int pattern) {
+  int i;
+  for (i = 0; i < 10; ++i) {
+    int32_t bound = (i & 1) ? 55364812 : 110729625;
+    if (pattern == 0) {
+      f[i] = (int32_t) (fe_check_random(state) % (2 * (uint64_t) bound + 1)) - bound;
+    } else if (pattern == 1 || (pattern == 3 && (i & 1))) {
+      f[i] = bound;
+    } else {
+      f[i] = -bound;
+    }
+  }
+}
+
+/* Same value as ref10 and within its output bounds */
+static int fe_check_result(const fe h, const fe ref) {
+  unsigned char s[32], sref[32];
+  int i;
+  for (i = 0; i < 10; ++i) {
+    int32_t bound = (i & 1) ? 16944988 : 33889976;
+    if (h[i] > bound || h[i] < -bound) {
+      return 0;
+    }
+  }
+  fe_tobytes(s, h);
+  fe_tobytes(sref, ref);
+  for (i = 0; i < 32; ++i) {
+    if (s[i] != sref[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int fe_mul_check_backends(void) {
+  uint64_t state = 0x6a09e667f3bcc908ULL;
+  int i;
+  for (i = 0; i < 1024; ++i) {
+    fe f, g, h, ref;
+    /* the first 16 rounds combine the bound patterns, the rest are random */
+    fe_check_input(f, &state, i < 16 ? (i & 3) : 0);
+    fe_check_input(g, &state, i < 16 ? (i >> 2) : 0);
+    fe_mul51(h, f, g);
+    fe_mul_ref10(ref, f, g);
+    if (!fe_check_result(h, ref)) {
+      return 0;
+    }
+    fe_sq51(h, f, 0);
+    fe_sq_ref10(ref, f);
+    if (!fe_check_result(h, ref)) {
+      return 0;
+    }
+    fe_sq51(h, f, 1);
+    fe_sq2_ref10(ref, f);
+    if (!fe_check_result(h, ref)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+__attribute__((constructor)) static void fe_mul_select(void) {
+  fe_mul_64_enabled = fe_mul_check_backends();
+}
+
+int fe_mul_64_active(void) {
+  return fe_mul_64_enabled;
+}
+
+#else
+
+static void fe_mul(fe h, const fe f, const fe g) {
+  fe_mul_ref10(h, f, g);
+}
+
+static void fe_sq(fe h, const fe f) {
+  fe_sq_ref10(h, f);
+}
+
+static void fe_sq2(fe h, const fe f) {
+  fe_sq2_ref10(h, f);
+}
+
+int fe_mul_check_backends(void) {
+  return 0;
+}
+
+int fe_mul_64_active(void) {
+  return 0;
+}
+
+#endif
+
 /* From fe_sub.c */
 
 /*
@@ -1586,6 +1829,40 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h) {
   s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* Same as ge_tobytes for count points written to s + 32 * i, but with a single field inversion
+   (Montgomery's trick). scratch must have room for count elements. */
+
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, size_t count, fe *scratch) {
+  fe inv;
+  fe recip;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+
+  fe_copy(scratch[0], h[0].Z);
+  for (i = 1; i < count; i++) {
+    fe_mul(scratch[i], scratch[i - 1], h[i].Z);
+  }
+
+  fe_invert(inv, scratch[count - 1]);
+  for (i = count; i-- > 0;) {
+    if (i > 0) {
+      fe_mul(recip, inv, scratch[i - 1]);
+      fe_mul(inv, inv, h[i].Z);
+    } else {
+      fe_copy(recip, inv);
+    }
+    fe_mul(x, h[i].X, recip);
+    fe_mul(y, h[i].Y, recip);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+}
+
 /* From sc_reduce.c */
 
 /*
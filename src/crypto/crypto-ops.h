@@ -93,6 +93,7 @@ void ge_sub(ge_p1p1 *, const ge_p3 *, const ge_cached *);
 /* From ge_tobytes.c */
 
 void ge_tobytes(unsigned char *, const ge_p2 *);
+void ge_tobytes_batch(unsigned char *, const ge_p2 *, size_t, fe *);
 
 /* From sc_reduce.c */
 
@@ -117,3 +118,5 @@ void sc_sub(unsigned char *, const unsigned char *, const unsigned char *);
 void sc_mulsub(unsigned char *, const unsigned char *, const unsigned char *, const unsigned char *);
 int sc_check(const unsigned char *);
 int sc_isnonzero(const unsigned char *); /* Doesn't normalize */
+int fe_mul_check_backends(void); /* 1 if the 64-bit fe_mul/fe_sq backend exists and matches ref10 on the test inputs */
+int fe_mul_64_active(void); /* 1 if that check passed at startup and the 64-bit backend is in use */
@@ -1,4 +1,5 @@
 #include <alloca.h>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -6,6 +7,7 @@
 #include <cstring>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 
 #include "Varint.h"
 #include "crypto.h"
@@ -103,6 +105,43 @@ namespace Crypto {
     ge_tobytes(reinterpret_cast<unsigned char*>(&derivation), &point2);
     return true;
   }
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+  /* Converts points[i] to bytes at out[indexes[i]], using one field inversion for all of them.
+   */
+  template<typename T>
+  static void batch_tobytes(const std::vector<ge_p2> &points, const std::vector<size_t> &indexes, T *out) {
+    std::unique_ptr<fe[]> scratch(new fe[points.size()]);
+    std::vector<EllipticCurvePoint> bytes(points.size());
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(bytes.data()), points.data(), points.size(), scratch.get());
+    for (size_t i = 0; i < points.size(); i++) {
+      static_assert(sizeof(T) == sizeof(EllipticCurvePoint), "unexpected point size");
+      memcpy(&out[indexes[i]], &bytes[i], sizeof(T));
+    }
+  }
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+  void crypto_ops::generate_key_derivations(const PublicKey *keys, size_t count, const SecretKey &key2,
+    KeyDerivation *derivations, bool *results) {
+    std::vector<ge_p2> points;
+    std::vector<size_t> indexes;
+    points.reserve(count);
+    indexes.reserve(count);
+    assert(sc_check(reinterpret_cast<const unsigned char*>(&key2)) == 0);
+    for (size_t i = 0; i < count; i++) {
+      ge_p3 point;
+      ge_p2 point2;
+      ge_p1p1 point3;
+      results[i] = ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&keys[i])) == 0;
+      if (!results[i]) {
+        continue;
+      }
+      ge_scalarmult(&point2, reinterpret_cast<const unsigned char*>(&key2), &point);
+      ge_mul8(&point3, &point2);
+      points.emplace_back();
+      ge_p1p1_to_p2(&points.back(), &point3);
+      indexes.push_back(i);
+    }
+    batch_tobytes(points, indexes, derivations);
+  }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
   static void derivation_to_scalar(const KeyDerivation &derivation, size_t output_index, EllipticCurveScalar &res) {
     struct {
@@ -225,6 +264,33 @@ namespace Crypto {
     ge_tobytes(reinterpret_cast<unsigned char*>(&base), &point5);
     return true;
   }
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+  void crypto_ops::underive_public_keys(const KeyDerivation &derivation, const size_t *output_indexes,
+    const PublicKey *derived_keys, size_t count, PublicKey *bases, bool *results) {
+    std::vector<ge_p2> points;
+    std::vector<size_t> indexes;
+    points.reserve(count);
+    indexes.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      EllipticCurveScalar scalar;
+      ge_p3 point1;
+      ge_p3 point2;
+      ge_cached point3;
+      ge_p1p1 point4;
+      results[i] = ge_frombytes_vartime(&point1, reinterpret_cast<const unsigned char*>(&derived_keys[i])) == 0;
+      if (!results[i]) {
+        continue;
+      }
+      derivation_to_scalar(derivation, output_indexes[i], scalar);
+      ge_scalarmult_base(&point2, reinterpret_cast<unsigned char*>(&scalar));
+      ge_p3_to_cached(&point3, &point2);
+      ge_sub(&point4, &point1, &point3);
+      points.emplace_back();
+      ge_p1p1_to_p2(&points.back(), &point4);
+      indexes.push_back(i);
+    }
+    batch_tobytes(points, indexes, bases);
+  }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
   bool crypto_ops::underive_public_key(const KeyDerivation &derivation, size_t output_index,
     const PublicKey &derived_key, const uint8_t* suffix, size_t suffixLength, PublicKey &base) {
@@ -421,6 +487,78 @@ namespace Crypto {
     sc_sub(reinterpret_cast<unsigned char*>(&sig[sec_index]), reinterpret_cast<unsigned char*>(&h), reinterpret_cast<unsigned char*>(&sum));
     sc_mulsub(reinterpret_cast<unsigned char*>(&sig[sec_index]) + 32, reinterpret_cast<unsigned char*>(&sig[sec_index]), reinterpret_cast<const unsigned char*>(&sec), reinterpret_cast<unsigned char*>(&k));
   }
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+  /* Decompressed ring member keys and their hash_to_ec points. Popular decoys are used
+   * by many rings, so both are computed once per key instead of once per signature.
+   * The cache is split into independently locked shards, a full shard is dropped.
+   */
+  class ring_point_cache {
+  public:
+    struct points {
+      ge_p3 key;
+      ge_p3 key_hash;
+    };
+
+    ring_point_cache() : hits(0), misses(0) {
+    }
+
+    bool get(const PublicKey &key, points &res) {
+      shard &s = shards[std::hash<PublicKey>()(key) % SHARD_COUNT];
+      {
+        lock_guard<mutex> lock(s.lock);
+        auto it = s.entries.find(key);
+        if (it != s.entries.end()) {
+          ++hits;
+          res = it->second;
+          return true;
+        }
+      }
+
+      ++misses;
+      if (ge_frombytes_vartime(&res.key, reinterpret_cast<const unsigned char*>(&key)) != 0) {
+        return false;
+      }
+      hash_to_ec(key, res.key_hash);
+
+      lock_guard<mutex> lock(s.lock);
+      if (s.entries.size() >= SHARD_SIZE) {
+        s.entries.clear();
+      }
+      s.entries.emplace(key, res);
+      return true;
+    }
+
+    PointCacheStats stats() {
+      PointCacheStats res;
+      res.hits = hits.load();
+      res.misses = misses.load();
+      res.entries = 0;
+      for (shard &s : shards) {
+        lock_guard<mutex> lock(s.lock);
+        res.entries += s.entries.size();
+      }
+      return res;
+    }
+
+  private:
+    static const size_t SHARD_COUNT = 16;
+    static const size_t SHARD_SIZE = 1024;
+
+    struct shard {
+      mutex lock;
+      std::unordered_map<PublicKey, points> entries;
+    };
+
+    shard shards[SHARD_COUNT];
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+  };
+
+  static ring_point_cache ring_points;
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+  PointCacheStats crypto_ops::get_point_cache_stats() {
+    return ring_points.stats();
+  }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
   bool crypto_ops::check_ring_signature(const Hash &prefix_hash, const KeyImage &image,
     const PublicKey *const *pubs, size_t pubs_count,
@@ -443,17 +581,16 @@ namespace Crypto {
     buf->h = prefix_hash;
     for (i = 0; i < pubs_count; i++) {
       ge_p2 tmp2;
-      ge_p3 tmp3;
+      ring_point_cache::points tmp3;
       if (sc_check(reinterpret_cast<const unsigned char*>(&sig[i])) != 0 || sc_check(reinterpret_cast<const unsigned char*>(&sig[i]) + 32) != 0) {
         return false;
       }
-      if (ge_frombytes_vartime(&tmp3, reinterpret_cast<const unsigned char*>(&*pubs[i])) != 0) {
+      if (!ring_points.get(*pubs[i], tmp3)) {
         abort();
       }
-      ge_double_scalarmult_base_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]), &tmp3, reinterpret_cast<const unsigned char*>(&sig[i]) + 32);
+      ge_double_scalarmult_base_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]), &tmp3.key, reinterpret_cast<const unsigned char*>(&sig[i]) + 32);
       ge_tobytes(reinterpret_cast<unsigned char*>(&buf->ab[i].a), &tmp2);
-      hash_to_ec(*pubs[i], tmp3);
-      ge_double_scalarmult_precomp_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]) + 32, &tmp3, reinterpret_cast<const unsigned char*>(&sig[i]), image_pre);
+      ge_double_scalarmult_precomp_vartime(&tmp2, reinterpret_cast<const unsigned char*>(&sig[i]) + 32, &tmp3.key_hash, reinterpret_cast<const unsigned char*>(&sig[i]), image_pre);
       ge_tobytes(reinterpret_cast<unsigned char*>(&buf->ab[i].b), &tmp2);
       sc_add(reinterpret_cast<unsigned char*>(&sum), reinterpret_cast<unsigned char*>(&sum), reinterpret_cast<const unsigned char*>(&sig[i]));
     }
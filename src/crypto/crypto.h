@@ -27,6 +27,12 @@ struct EllipticCurveScalar {
   uint8_t data[32];
 };
 
+struct PointCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  std::size_t entries;
+};
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -45,6 +51,8 @@ struct EllipticCurveScalar {
     friend bool secret_key_to_public_key(const SecretKey &, PublicKey &);
     static bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
     friend bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
+    static void generate_key_derivations(const PublicKey *, size_t, const SecretKey &, KeyDerivation *, bool *);
+    friend void generate_key_derivations(const PublicKey *, size_t, const SecretKey &, KeyDerivation *, bool *);
     static bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
@@ -61,6 +69,8 @@ struct EllipticCurveScalar {
     friend void derive_secret_key(const KeyDerivation &, size_t, const SecretKey &, const uint8_t*, size_t, SecretKey &);
     static bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
+    static void underive_public_keys(const KeyDerivation &, const size_t *, const PublicKey *, size_t, PublicKey *, bool *);
+    friend void underive_public_keys(const KeyDerivation &, const size_t *, const PublicKey *, size_t, PublicKey *, bool *);
     static bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
     static void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
@@ -81,6 +91,8 @@ struct EllipticCurveScalar {
       const PublicKey *const *, size_t, const Signature *);
     friend bool check_ring_signature(const Hash &, const KeyImage &,
       const PublicKey *const *, size_t, const Signature *);
+    static PointCacheStats get_point_cache_stats();
+    friend PointCacheStats get_point_cache_stats();
   };
 
   /* Generate a value filled with random bytes.
@@ -158,6 +170,14 @@ struct EllipticCurveScalar {
     return crypto_ops::generate_key_derivation(key1, key2, derivation);
   }
 
+  /* Same as generate_key_derivation for count keys, the resulting points share one field inversion.
+   * results[i] is false if keys[i] isn't a valid point.
+   */
+  inline void generate_key_derivations(const PublicKey *keys, size_t count, const SecretKey &key2,
+    KeyDerivation *derivations, bool *results) {
+    crypto_ops::generate_key_derivations(keys, count, key2, derivations, results);
+  }
+
   inline bool derive_public_key(const KeyDerivation &derivation, size_t output_index,
     const PublicKey &base, const uint8_t* prefix, size_t prefixLength, PublicKey &derived_key) {
     return crypto_ops::derive_public_key(derivation, output_index, base, prefix, prefixLength, derived_key);
@@ -197,6 +217,13 @@ struct EllipticCurveScalar {
     return crypto_ops::underive_public_key(derivation, output_index, derived_key, base);
   }
 
+  /* Same as underive_public_key for count keys of one transaction, the resulting points share one field inversion.
+   */
+  inline void underive_public_keys(const KeyDerivation &derivation, const size_t *output_indexes,
+    const PublicKey *derived_keys, size_t count, PublicKey *bases, bool *results) {
+    crypto_ops::underive_public_keys(derivation, output_indexes, derived_keys, count, bases, results);
+  }
+
   /* Generation and checking of a standard signature.
    */
   inline void generate_signature(const Hash &prefix_hash, const PublicKey &pub, const SecretKey &sec, Signature &sig) {
@@ -250,6 +277,12 @@ struct EllipticCurveScalar {
     return check_ring_signature(prefix_hash, image, pubs.data(), pubs.size(), sig);
   }
 
+  /* Usage of the cache of ring member points used by check_ring_signature.
+   */
+  inline PointCacheStats get_point_cache_stats() {
+    return crypto_ops::get_point_cache_stats();
+  }
+
 }
 
 CRYPTO_MAKE_HASHABLE(PublicKey)
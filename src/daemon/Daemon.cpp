@@ -107,6 +107,7 @@ void print_genesis_tx_hex(const po::variables_map& vm, LoggerManager& logManager
 JsonValue buildLoggerConfiguration(Level level, const std::string& logfile) {
   JsonValue loggerConfiguration(JsonValue::OBJECT);
   loggerConfiguration.insert("globalLevel", static_cast<int64_t>(level));
+  loggerConfiguration.insert("async", JsonValue(true));
 
   JsonValue& cfgLoggers = loggerConfiguration.insert("loggers", JsonValue::ARRAY);
 
@@ -353,6 +354,7 @@ int main(int argc, char* argv[])
     }
 
     logger(INFO) << "Core initialized OK";
+    cprotocol.setPrunedHeight(ccore.getPrunedHeight());
 
     // start components
     if (!command_line::has_arg(vm, arg_console)) {
@@ -37,6 +37,7 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::core& core, CryptoNote:
   m_consoleHandler.setHandler("stop_mining", boost::bind(&DaemonCommandsHandler::stop_mining, this, _1), "Stop mining");
   m_consoleHandler.setHandler("print_pool", boost::bind(&DaemonCommandsHandler::print_pool, this, _1), "Print transaction pool (long format)");
   m_consoleHandler.setHandler("print_pool_sh", boost::bind(&DaemonCommandsHandler::print_pool_sh, this, _1), "Print transaction pool (short format)");
+  m_consoleHandler.setHandler("print_cache_stats", boost::bind(&DaemonCommandsHandler::print_cache_stats, this, _1), "Print hit rate of RPC response caches");
   m_consoleHandler.setHandler("show_hr", boost::bind(&DaemonCommandsHandler::show_hr, this, _1), "Start showing hash rate");
   m_consoleHandler.setHandler("hide_hr", boost::bind(&DaemonCommandsHandler::hide_hr, this, _1), "Stop showing hash rate");
   m_consoleHandler.setHandler("set_log", boost::bind(&DaemonCommandsHandler::set_log, this, _1), "set_log <level> - Change current log level, <level> is a number 0-4");
@@ -321,6 +322,30 @@ bool DaemonCommandsHandler::print_pool_sh(const std::vector<std::string>& args)
   return true;
 }
 //--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_cache_stats(const std::vector<std::string>& args)
+{
+  auto printStats = [](const char* name, const CryptoNote::TipQueryCacheStats& stats) {
+    uint64_t total = stats.hits + stats.misses;
+    std::cout << name << ": hits " << stats.hits << ", misses " << stats.misses << ", entries " << stats.entries;
+    if (total != 0) {
+      std::cout << ", hit rate " << (stats.hits * 100 / total) << "%";
+    }
+    std::cout << ENDL;
+  };
+
+  printStats("queryblockslite", m_core.getQueryBlocksLiteCacheStats());
+  printStats("get_pool_changes_lite", m_core.getPoolChangesLiteCacheStats());
+  printStats("ring signatures", m_core.getVerifiedSignaturesCacheStats());
+  printStats("blocks storage", m_core.getBlocksCacheStats());
+  Crypto::PointCacheStats pointStats = Crypto::get_point_cache_stats();
+  printStats("ring member points", { pointStats.hits, pointStats.misses, pointStats.entries });
+  if (m_prpc_server != nullptr) {
+    printStats("getinfo", m_prpc_server->getInfoCacheStats());
+  }
+
+  return true;
+}
+//--------------------------------------------------------------------------------
 bool DaemonCommandsHandler::start_mining(const std::vector<std::string> &args) {
   if (!args.size()) {
     std::cout << "Please, specify wallet address to mine for: start_mining <addr> [threads=1]" << std::endl;
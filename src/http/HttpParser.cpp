@@ -6,6 +6,9 @@
 
 namespace {
 
+// bodies are read in chunks, each long enough to be received past the stream buffer
+const size_t BODY_CHUNK_SIZE = 64 * 1024;
+
 void throwIfNotGood(std::istream& stream) {
   if (!stream.good()) {
     if (stream.eof()) {
@@ -195,11 +198,12 @@ size_t HttpParser::getBodyLen(const HttpRequest::Headers& headers) {
 }
 
 void HttpParser::readBody(std::istream& stream, std::string& body, const size_t bodyLen) {
-  size_t read = 0;
-
-  while (stream.good() && read < bodyLen) {
-    body += stream.get();
-    ++read;
+  // the body grows with the data received, not with the length a peer claims
+  while (stream.good() && body.size() < bodyLen) {
+    size_t offset = body.size();
+    body.resize(offset + std::min(bodyLen - offset, BODY_CHUNK_SIZE));
+    stream.read(&body[offset], static_cast<std::streamsize>(body.size() - offset));
+    body.resize(offset + static_cast<size_t>(stream.gcount()));
   }
 
   throwIfNotGood(stream);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include "common/MpmcQueue.h"
+#include "seria/ILogger.h"
+
+namespace Logging {
+
+struct LogRecord {
+  std::string category;
+  Level level;
+  boost::posix_time::ptime time;
+  std::string body;
+};
+
+typedef Common::MpmcQueue<LogRecord> AsyncLogQueue;
+
+}
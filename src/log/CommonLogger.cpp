@@ -73,6 +73,10 @@ void CommonLogger::setMaxLevel(Level level) {
   logLevel = level;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Level CommonLogger::getMaxLevel() const {
+  return logLevel;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 CommonLogger::CommonLogger(Level level) : logLevel(level), pattern("%D %T %L [%C] ") {
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <set>
 #include "seria/ILogger.h"
 
@@ -12,12 +13,13 @@ public:
   virtual void enableCategory(const std::string& category);
   virtual void disableCategory(const std::string& category);
   virtual void setMaxLevel(Level level);
+  virtual Level getMaxLevel() const override;
 
   void setPattern(const std::string& pattern);
 
 protected:
   std::set<std::string> disabledCategories;
-  Level logLevel;
+  std::atomic<Level> logLevel;
   std::string pattern;
 
   CommonLogger(Level level);
@@ -37,23 +37,32 @@ void ConsoleLogger::doLogString(const std::string& message) {
     { DEFAULT, Color::Default }
   };
 
+  // text between color changes is written at once
+  size_t textStart = 0;
   for (size_t charPos = 0; charPos < message.size(); ++charPos) {
     if (message[charPos] == ILogger::COLOR_DELIMETER) {
+      if (readingText) {
+        std::cout.write(message.data() + textStart, charPos - textStart);
+      }
+
       readingText = !readingText;
       color += message[charPos];
       if (readingText) {
+        textStart = charPos + 1;
         auto it = colorMapping.find(color);
         Common::Console::setTextColor(it == colorMapping.end() ? Color::Default : it->second);
         changedColor = true;
         color.clear();
       }
-    } else if (readingText) {
-      std::cout << message[charPos];
-    } else {
+    } else if (!readingText) {
       color += message[charPos];
     }
   }
 
+  if (readingText) {
+    std::cout.write(message.data() + textStart, message.size() - textStart);
+  }
+
   if (changedColor) {
     Common::Console::setTextColor(Color::Default);
   }
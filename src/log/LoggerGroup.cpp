@@ -22,4 +22,13 @@ void LoggerGroup::operator()(const std::string& category, Level level, boost::po
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Level LoggerGroup::getMaxLevel() const {
+  Level loggersLevel = FATAL;
+  for (auto& logger : loggers) {
+    loggersLevel = std::max(loggersLevel, logger->getMaxLevel());
+  }
+
+  return std::min(CommonLogger::getMaxLevel(), loggersLevel);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 }
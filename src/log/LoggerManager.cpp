@@ -7,15 +7,72 @@ namespace Logging {
 
 using Common::JsonValue;
 
-LoggerManager::LoggerManager() {
+namespace {
+
+const size_t ASYNC_QUEUE_SIZE = 8192;
+const std::chrono::milliseconds WRITER_IDLE_TIMEOUT(50);
+
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+LoggerManager::LoggerManager() :
+  maxLevel(FATAL), queue(ASYNC_QUEUE_SIZE), async(false), asyncProducers(0), stopWriting(false), writerWaiting(false), droppedMessages(0) {
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+LoggerManager::~LoggerManager() {
+  stopWriter();
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void LoggerManager::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+  if (level > maxLevel) {
+    return;
+  }
+
+  if (async) {
+    ++asyncProducers;
+    // checked again once registered, stopWriter waits for registered producers before its final drain
+    if (async) {
+      enqueue(category, level, time, body);
+      --asyncProducers;
+      return;
+    }
+
+    --asyncProducers;
+  }
+
+  write(category, level, time, body);
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::enqueue(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+  LogRecord record{ category, level, time, body };
+  while (!queue.tryPush(std::move(record))) {
+    // only less important messages are dropped when the writer can't keep up
+    if (level > WARNING) {
+      ++droppedMessages;
+      return;
+    }
+
+    std::this_thread::yield();
+  }
+
+  if (writerWaiting) {
+    writerCondition.notify_one();
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::setMaxLevel(Level level) {
   std::unique_lock<std::mutex> lock(reconfigureLock);
-  LoggerGroup::operator()(category, level, time, body);
+  LoggerGroup::setMaxLevel(level);
+  maxLevel = LoggerGroup::getMaxLevel();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+Level LoggerManager::getMaxLevel() const {
+  return maxLevel;
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void LoggerManager::configure(const JsonValue& val) {
+  // writer takes reconfigureLock for every message, so it is stopped first
+  stopWriter();
+
   std::unique_lock<std::mutex> lock(reconfigureLock);
   loggers.clear();
   LoggerGroup::loggers.clear();
@@ -101,10 +158,83 @@ void LoggerManager::configure(const JsonValue& val) {
   } else {
     throw std::runtime_error("loggers parameter missing");
   }
-  setMaxLevel(globalLevel);
+  LoggerGroup::setMaxLevel(globalLevel);
   for (const auto& category : globalDisabledCategories) {
     disableCategory(category);
   }
+
+  maxLevel = LoggerGroup::getMaxLevel();
+  lock.unlock();
+
+  if (val.contains("async")) {
+    auto asyncVal = val("async");
+    if (!asyncVal.isBool()) {
+      throw std::runtime_error("parameter async has wrong type");
+    }
+
+    if (asyncVal.getBool()) {
+      startWriter();
+    }
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::startWriter() {
+  stopWriting = false;
+  writer = std::thread(&LoggerManager::writerLoop, this);
+  async = true;
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::stopWriter() {
+  if (!writer.joinable()) {
+    return;
+  }
+
+  async = false;
+  // producers which saw async mode finish their pushes while the writer still drains the queue
+  while (asyncProducers != 0) {
+    std::this_thread::yield();
+  }
+
+  stopWriting = true;
+  writerCondition.notify_one();
+  writer.join();
+
+  // messages pushed after the writer's last look at the queue
+  LogRecord record;
+  while (queue.tryPop(record)) {
+    write(record.category, record.level, record.time, record.body);
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::writerLoop() {
+  LogRecord record;
+  for (;;) {
+    if (queue.tryPop(record)) {
+      write(record.category, record.level, record.time, record.body);
+      continue;
+    }
+
+    uint64_t dropped = droppedMessages.exchange(0);
+    if (dropped != 0) {
+      write("LoggerManager", WARNING, boost::posix_time::microsec_clock::local_time(),
+        std::to_string(dropped) + " log messages were dropped, logging queue is full\n");
+    }
+
+    if (stopWriting) {
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    writerWaiting = true;
+    // producers notify without the mutex, so a wakeup can be missed, the timeout bounds the delay
+    writerCondition.wait_for(lock, WRITER_IDLE_TIMEOUT, [this] { return stopWriting || !queue.empty(); });
+    writerWaiting = false;
+  }
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+void LoggerManager::write(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  LoggerGroup::operator()(category, level, time, body);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 }
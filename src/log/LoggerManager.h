@@ -1,9 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include "common/JsonValue.h"
+#include "AsyncLogQueue.h"
 #include "LoggerGroup.h"
 
 namespace Logging {
@@ -11,12 +15,34 @@ namespace Logging {
 class LoggerManager : public LoggerGroup {
 public:
   LoggerManager();
+  ~LoggerManager();
+  // "async": true moves writing to a background thread, callers only push messages to a queue
   void configure(const Common::JsonValue& val);
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  virtual void setMaxLevel(Level level) override;
+  virtual Level getMaxLevel() const override;
 
 private:
+  void startWriter();
+  void stopWriter();
+  void writerLoop();
+  void enqueue(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body);
+  void write(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body);
+
   std::vector<std::unique_ptr<CommonLogger>> loggers;
   std::mutex reconfigureLock;
+  std::atomic<Level> maxLevel;
+
+  AsyncLogQueue queue;
+  std::atomic<bool> async;
+  // callers between their check of async mode and the end of their push
+  std::atomic<size_t> asyncProducers;
+  std::atomic<bool> stopWriting;
+  std::atomic<bool> writerWaiting;
+  std::atomic<uint64_t> droppedMessages;
+  std::mutex writerMutex;
+  std::condition_variable writerCondition;
+  std::thread writer;
 };
 
 }
@@ -9,9 +9,15 @@ LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level
 	, m_sCategory(category)
 	, m_nLogLevel(level)
 	, m_sMessage(color)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
 	, m_bGotText(false)
-{}
+	, m_bEnabled(level <= logger.getMaxLevel())
+{
+	if (m_bEnabled) {
+		m_tmTimeStamp = boost::posix_time::microsec_clock::local_time();
+	} else {
+		setstate(std::ios::badbit);
+	}
+}
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 #if defined __linux__ && !defined __ANDROID__
 LoggerMessage::LoggerMessage(LoggerMessage&& other)
@@ -21,8 +27,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , m_nLogLevel(other.m_nLogLevel)
   , m_logger(other.m_logger)
   , m_sMessage(other.m_sMessage)
-  , m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
-  , m_bGotText(false) {
+  , m_tmTimeStamp(other.m_tmTimeStamp)
+  , m_bGotText(false)
+  , m_bEnabled(other.m_bEnabled) {
   if (this != &other) {
     _M_tie = nullptr;
     _M_streambuf = nullptr;
@@ -69,8 +76,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
 	, m_sCategory(other.m_sCategory)
 	, m_nLogLevel(other.m_nLogLevel)
 	, m_sMessage(other.m_sMessage)
-	, m_tmTimeStamp(boost::posix_time::microsec_clock::local_time())
+	, m_tmTimeStamp(other.m_tmTimeStamp)
 	, m_bGotText(false)
+	, m_bEnabled(other.m_bEnabled)
 {
 	std::ostream::rdbuf(this);
 }
@@ -84,6 +92,10 @@ LoggerMessage::~LoggerMessage()
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 int LoggerMessage::sync()
 {
+	if (!m_bEnabled) {
+		return 0;
+	}
+
 	m_logger(m_sCategory, m_nLogLevel, m_tmTimeStamp, m_sMessage);
 	m_bGotText = false;
 	m_sMessage = Logging::DEFAULT;
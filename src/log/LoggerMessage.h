@@ -5,6 +5,8 @@
 
 namespace Logging {
 
+// Messages above the logger's max level are disabled: the stream is created in bad state,
+// so insertions skip formatting, and nothing is passed to the logger.
 class LoggerMessage : public std::ostream, std::streambuf
 {
 public:
@@ -26,6 +28,7 @@ private:
 	std::string m_sMessage;
 	boost::posix_time::ptime m_tmTimeStamp;
 	bool m_bGotText;
+	bool m_bEnabled;
 };
 
 } //Logging
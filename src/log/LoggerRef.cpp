@@ -12,6 +12,11 @@ LoggerMessage LoggerRef::operator()(Level level, const std::string& color) const
 	return LoggerMessage(*m_logger, m_sCategory, level, color);
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
+bool LoggerRef::isEnabled(Level level) const
+{
+	return level <= m_logger->getMaxLevel();
+}
+//------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 ILogger& LoggerRef::getLogger() const
 {
 	return *m_logger;
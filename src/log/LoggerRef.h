@@ -10,6 +10,8 @@ class LoggerRef
 public:
 	LoggerRef(ILogger& logger, const std::string& category);
 	LoggerMessage operator()(Level level = INFO, const std::string& color = DEFAULT) const;
+	// lets callers skip computing values used only in a message of this level
+	bool isEnabled(Level level) const;
 	ILogger& getLogger() const;
 
 private:
@@ -16,17 +16,20 @@ void StreamLogger::attachToStream(std::ostream& stream) {
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
 void StreamLogger::doLogString(const std::string& message) {
   if (stream != nullptr && stream->good()) {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::string text;
+    text.reserve(message.size());
     bool readingText = true;
     for (size_t charPos = 0; charPos < message.size(); ++charPos) {
       if (message[charPos] == ILogger::COLOR_DELIMETER) {
         readingText = !readingText;
       } else if (readingText) {
-        *stream << message[charPos];
+        text += message[charPos];
       }
     }
 
-    *stream << std::flush;
+    std::lock_guard<std::mutex> lock(mutex);
+    stream->write(text.data(), text.size());
+    stream->flush();
   }
 }
 //------------------------------------------------------------- Seperator Code -------------------------------------------------------------//
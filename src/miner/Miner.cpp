@@ -5,6 +5,7 @@
 #include "crypto/crypto.h"
 #include "base/CryptoNoteFormatUtils.h"
 
+#include <System/Event.h>
 #include <System/InterruptedException.h>
 
 namespace CryptoNote {
@@ -59,17 +60,59 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
   m_logger(Logging::INFO) << "Starting mining for difficulty " << blockMiningParameters.difficulty;
 
   try {
+    if (!m_scheduler || m_scheduler->getThreadCount() != threadCount) {
+      m_scheduler.reset();
+      m_scheduler.reset(new System::Scheduler(threadCount));
+    }
+
     blockMiningParameters.blockTemplate.nonce = Crypto::rand<uint32_t>();
 
+    // one worker per scheduler thread, the last one to finish wakes this context
+    std::atomic<size_t> runningWorkers(threadCount);
+    System::Event workersFinished(m_dispatcher);
+    std::exception_ptr spawnError;
     for (size_t i = 0; i < threadCount; ++i) {
-      m_workers.emplace_back(std::unique_ptr<System::RemoteContext<void>> (
-        new System::RemoteContext<void>(m_dispatcher, std::bind(&Miner::workerFunc, this, blockMiningParameters.blockTemplate, blockMiningParameters.difficulty, threadCount)))
-      );
+      Block blockTemplate = blockMiningParameters.blockTemplate;
+      difficulty_type difficulty = blockMiningParameters.difficulty;
+      try {
+        m_scheduler->spawn([this, blockTemplate, difficulty, threadCount, &runningWorkers, &workersFinished] {
+          workerFunc(blockTemplate, difficulty, static_cast<uint32_t>(threadCount));
+          if (--runningWorkers == 0) {
+            System::Event* finished = &workersFinished;
+            m_dispatcher.remoteSpawn([finished] { finished->set(); });
+          }
+        });
+      } catch (...) {
+        // workers already spawned refer to this frame, they are stopped and waited for
+        spawnError = std::current_exception();
+        m_state = MiningState::MINING_STOPPED;
+        if (runningWorkers.fetch_sub(threadCount - i) == threadCount - i) {
+          workersFinished.set();
+        }
+
+        break;
+      }
 
       blockMiningParameters.blockTemplate.nonce++;
     }
 
-    m_workers.clear();
+    // like RemoteContext, an interrupt doesn't abandon the workers, stop() ends them
+    bool interrupted = false;
+    while (!workersFinished.get()) {
+      try {
+        workersFinished.wait();
+      } catch (System::InterruptedException&) {
+        interrupted = true;
+      }
+    }
+
+    if (interrupted) {
+      m_dispatcher.interrupt();
+    }
+
+    if (spawnError) {
+      std::rethrow_exception(spawnError);
+    }
 
   } catch (std::exception& e) {
     m_logger(Logging::ERROR) << "Error occured during mining: " << e.what();
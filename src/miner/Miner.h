@@ -1,11 +1,12 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <thread>
 
 #include <System/Dispatcher.h>
 #include <System/Event.h>
-#include <System/RemoteContext.h>
+#include <System/Scheduler.h>
 
 #include "CryptoNote.h"
 #include "core/Difficulty.h"
@@ -36,7 +37,8 @@ private:
   enum class MiningState : uint8_t { MINING_STOPPED, BLOCK_FOUND, MINING_IN_PROGRESS};
   std::atomic<MiningState> m_state;
 
-  std::vector<std::unique_ptr<System::RemoteContext<void>>>  m_workers;
+  // mining threads, kept between blocks instead of being started for every block template
+  std::unique_ptr<System::Scheduler> m_scheduler;
 
   Block m_block;
 
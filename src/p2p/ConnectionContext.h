@@ -32,6 +32,7 @@ struct CryptoNoteConnectionContext {
   std::list<Crypto::Hash> m_needed_objects;
   std::unordered_set<Crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
+  uint32_t m_remote_pruned_height = 0;
   uint32_t m_last_response_height = 0;
 };
 
@@ -21,6 +21,7 @@
 #include <System/TcpConnector.h>
 
 #include "version.h"
+#include "common/Metrics.h"
 #include "common/StdInputStream.h"
 #include "common/StdOutputStream.h"
 #include "common/Util.h"
@@ -118,22 +119,58 @@ namespace CryptoNote
       }
       return ss.str();
     }
+
+    // NOTIFY_NEW_TRANSACTIONS sent to a single peer is a transaction pool sync reply, not a relay
+    P2pConnectionContext::WritePriority writePriority(const P2pMessage& msg, bool relay) {
+      if (msg.type == P2pMessage::NOTIFY) {
+        switch (msg.command) {
+        case NOTIFY_NEW_TRANSACTIONS::ID:
+          return relay ? P2pConnectionContext::WRITE_PRIORITY_RELAY : P2pConnectionContext::WRITE_PRIORITY_BULK;
+        case NOTIFY_RESPONSE_GET_OBJECTS::ID:
+        case NOTIFY_RESPONSE_CHAIN_ENTRY::ID:
+          return P2pConnectionContext::WRITE_PRIORITY_BULK;
+        }
+      }
+
+      return P2pConnectionContext::WRITE_PRIORITY_URGENT;
+    }
+
+    Common::MetricsCounter& droppedRelayBytes() {
+      static Common::MetricsCounter& counter = Common::MetricsRegistry::instance().counter("p2p_write_dropped_bytes_total",
+        "Bytes of transaction relays dropped because the relay queue of a connection was full");
+      return counter;
+    }
   }
 
   //-----------------------------------------------------------------------------------
   // P2pConnectionContext implementation
   //-----------------------------------------------------------------------------------
 
-  bool P2pConnectionContext::pushMessage(P2pMessage&& msg) {
-    writeQueueSize += msg.size();
+  bool P2pConnectionContext::pushMessage(P2pMessage&& msg, bool relay) {
+    WritePriority priority = writePriority(msg, relay);
+
+    // relays are best effort, a peer which doesn't keep up misses some instead of being disconnected,
+    // but one is always taken while none is queued so a single large relay still gets through
+    if (priority == WRITE_PRIORITY_RELAY && !writeQueues[priority].empty() &&
+        writeQueueBytes[priority] + msg.size() > P2P_CONNECTION_MAX_RELAY_BUFFER_SIZE) {
+      ++droppedMessages;
+      droppedBytes += msg.size();
+      droppedRelayBytes().increment(msg.size());
+      logger(DEBUGGING) << *this << "Relay queue is full, message " << msg.command << " dropped";
+      return false;
+    }
 
-    if (writeQueueSize > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
+    if (writeQueueSize + msg.size() > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
+      ++droppedMessages;
+      droppedBytes += msg.size();
       logger(DEBUGGING) << *this << "Write queue overflows. Interrupt connection";
       interrupt();
       return false;
     }
 
-    writeQueue.push_back(std::move(msg));
+    writeQueueSize += msg.size();
+    writeQueueBytes[priority] += msg.size();
+    writeQueues[priority].push_back(std::move(msg));
     queueEvent.set();
     return true;
   }
@@ -141,22 +178,51 @@ namespace CryptoNote
   std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
     writeOperationStartTime = TimePoint();
 
-    while (writeQueue.empty() && !stopped) {
+    // empty messages, e.g. replies to unknown commands, are queued without adding bytes
+    while (writeQueuesEmpty() && !stopped) {
       queueEvent.wait();
     }
 
-    std::vector<P2pMessage> msgs(std::move(writeQueue));
-    writeQueue.clear();
-    writeQueueSize = 0;
+    // sync responses are taken one at a time, so messages queued meanwhile wait for one large response at most
+    std::vector<P2pMessage> msgs;
+    for (size_t priority = 0; priority < WRITE_PRIORITY_COUNT; ++priority) {
+      auto& queue = writeQueues[priority];
+      size_t count = priority == WRITE_PRIORITY_BULK ? std::min<size_t>(queue.size(), 1) : queue.size();
+      for (size_t i = 0; i < count; ++i) {
+        writeQueueBytes[priority] -= queue.front().size();
+        writeQueueSize -= queue.front().size();
+        msgs.push_back(std::move(queue.front()));
+        queue.pop_front();
+      }
+    }
+
     writeOperationStartTime = Clock::now();
     queueEvent.clear();
     return msgs;
   }
 
+  bool P2pConnectionContext::writeQueuesEmpty() const {
+    for (const auto& queue : writeQueues) {
+      if (!queue.empty()) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   uint64_t P2pConnectionContext::writeDuration(TimePoint now) const { // in milliseconds
     return writeOperationStartTime == TimePoint() ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(now - writeOperationStartTime).count();
   }
 
+  P2pConnectionContext::WriteStats P2pConnectionContext::writeStats() const {
+    WriteStats stats;
+    stats.queuedBytes = writeQueueSize;
+    stats.droppedMessages = droppedMessages;
+    stats.droppedBytes = droppedBytes;
+    return stats;
+  }
+
   void P2pConnectionContext::interrupt() {
     logger(DEBUGGING) << *this << "Interrupt connection";
     assert(context != nullptr);
@@ -199,7 +265,8 @@ namespace CryptoNote
     // intervals
     // m_peer_handshake_idle_maker_interval(CryptoNote::P2P_DEFAULT_HANDSHAKE_INTERVAL),
     m_connections_maker_interval(1),
-    m_peerlist_store_interval(60 * 30, false) {
+    m_peerlist_store_interval(60 * 30, false),
+    m_unhandledCommands(Common::MetricsRegistry::instance().counter("p2p_unhandled_commands_total", "P2P commands without a handler")) {
   }
 
   void NodeServer::serialize(ISerializer& s) {
@@ -228,6 +295,8 @@ namespace CryptoNote
       return 0;
     }
 
+    auto handlingStart = std::chrono::steady_clock::now();
+
     switch (cmd.command) {
       INVOKE_HANDLER(COMMAND_HANDSHAKE, &NodeServer::handle_handshake)
       INVOKE_HANDLER(COMMAND_TIMED_SYNC, &NodeServer::handle_timed_sync)
@@ -243,11 +312,34 @@ namespace CryptoNote
       }
     }
 
+    // only known commands get their own series, ids of unhandled ones come from peers
+    if (handled) {
+      const CommandMetrics& metrics = commandMetrics(cmd.command);
+      metrics.handlingTime->observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - handlingStart).count());
+      metrics.payloadBytes->increment(cmd.buf.size());
+    } else {
+      m_unhandledCommands.increment();
+    }
+
     return ret;
   }
 
 #undef INVOKE_HANDLER
 
+  const NodeServer::CommandMetrics& NodeServer::commandMetrics(uint32_t command) {
+    auto it = m_commandMetrics.find(command);
+    if (it == m_commandMetrics.end()) {
+      Common::MetricsRegistry& registry = Common::MetricsRegistry::instance();
+      std::string labels = "command=\"" + std::to_string(command) + "\"";
+      CommandMetrics metrics;
+      metrics.handlingTime = &registry.histogram("p2p_command_seconds", "Time spent handling P2P commands", labels);
+      metrics.payloadBytes = &registry.counter("p2p_command_bytes_total", "Payload bytes of handled P2P commands", labels);
+      it = m_commandMetrics.emplace(command, metrics).first;
+    }
+
+    return it->second;
+  }
+
   //-----------------------------------------------------------------------------------
 
   void NodeServer::init_options(boost::program_options::options_description& desc)
@@ -1068,7 +1160,7 @@ namespace CryptoNote
       if (conn.peerId && conn.m_connection_id != excludeId &&
           (conn.m_state == CryptoNoteConnectionContext::state_normal ||
            conn.m_state == CryptoNoteConnectionContext::state_synchronizing)) {
-        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff), true);
       }
     });
   }
@@ -1080,9 +1172,7 @@ namespace CryptoNote
       return false;
     }
 
-    it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
-
-    return true;
+    return it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
   }
 
   //-----------------------------------------------------------------------------------
@@ -1235,9 +1325,12 @@ namespace CryptoNote
     std::stringstream ss;
 
     for (const auto& cntxt : m_connections) {
+      auto writeStats = cntxt.second.writeStats();
       ss << Common::ipAddressToString(cntxt.second.m_remote_ip) << ":" << cntxt.second.m_remote_port
         << " \t\tpeer_id " << cntxt.second.peerId
         << " \t\tconn_id " << cntxt.second.m_connection_id << (cntxt.second.m_is_income ? " INC" : " OUT")
+        << " \t\tqueued " << writeStats.queuedBytes << " bytes, dropped " << writeStats.droppedMessages << " messages ("
+        << writeStats.droppedBytes << " bytes)"
         << std::endl;
     }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <unordered_map>
 
@@ -17,6 +18,7 @@
 #include "deluxe/loco.h"
 #include "protocol/CryptoNoteProtocolHandler.h"
 #include "common/CommandLine.h"
+#include "common/Metrics.h"
 #include "log/LoggerRef.h"
 
 #include "ConnectionContext.h"
@@ -50,7 +52,7 @@ namespace CryptoNote
       type(msg.type), command(msg.command), buffer(std::move(msg.buffer)), returnCode(msg.returnCode) {
     }
 
-    size_t size() {
+    size_t size() const {
       return buffer.size();
     }
 
@@ -65,6 +67,21 @@ namespace CryptoNote
     using Clock = std::chrono::steady_clock;
     using TimePoint = Clock::time_point;
 
+    // messages are written by priority: P2P commands and new blocks, then transaction relays, then sync responses
+    // (including transaction pool sync replies)
+    enum WritePriority {
+      WRITE_PRIORITY_URGENT,
+      WRITE_PRIORITY_RELAY,
+      WRITE_PRIORITY_BULK,
+      WRITE_PRIORITY_COUNT
+    };
+
+    struct WriteStats {
+      size_t queuedBytes;
+      uint64_t droppedMessages;
+      uint64_t droppedBytes;
+    };
+
     System::Context<void>* context;
     PeerIdType peerId;
     System::TcpConnection connection;
@@ -88,19 +105,26 @@ namespace CryptoNote
       stopped(std::move(ctx.stopped)) {
     }
 
-    bool pushMessage(P2pMessage&& msg);
+    // returns false if the message was dropped, relay marks a transaction broadcast which a full relay queue drops
+    bool pushMessage(P2pMessage&& msg, bool relay = false);
     std::vector<P2pMessage> popBuffer();
     void interrupt();
 
     uint64_t writeDuration(TimePoint now) const;
+    WriteStats writeStats() const;
 
   private:
     Logging::LoggerRef logger;
     TimePoint writeOperationStartTime;
     System::Event queueEvent;
-    std::vector<P2pMessage> writeQueue;
+    std::deque<P2pMessage> writeQueues[WRITE_PRIORITY_COUNT];
+    size_t writeQueueBytes[WRITE_PRIORITY_COUNT] = {};
     size_t writeQueueSize = 0;
+    uint64_t droppedMessages = 0;
+    uint64_t droppedBytes = 0;
     bool stopped;
+
+    bool writeQueuesEmpty() const;
   };
 
   class NodeServer :  public IP2pEndpoint
@@ -132,6 +156,13 @@ namespace CryptoNote
 
     int handleCommand(const LevinProtocol::Command& cmd, BinaryArray& buff_out, P2pConnectionContext& context, bool& handled);
 
+    struct CommandMetrics {
+      Common::MetricsHistogram* handlingTime;
+      Common::MetricsCounter* payloadBytes;
+    };
+
+    const CommandMetrics& commandMetrics(uint32_t command);
+
     //----------------- commands handlers ----------------------------------------------
     int handle_handshake(int command, COMMAND_HANDSHAKE::request& arg, COMMAND_HANDSHAKE::response& rsp, P2pConnectionContext& context);
     int handle_timed_sync(int command, COMMAND_TIMED_SYNC::request& arg, COMMAND_TIMED_SYNC::response& rsp, P2pConnectionContext& context);
@@ -256,5 +287,9 @@ namespace CryptoNote
     std::list<PeerlistEntry> m_command_line_peers;
     uint64_t m_peer_livetime;
     boost::uuids::uuid m_network_id;
+
+    // metrics of handled commands, filled on first use, handleCommand() only runs in the dispatcher thread
+    std::unordered_map<uint32_t, CommandMetrics> m_commandMetrics;
+    Common::MetricsCounter& m_unhandledCommands;
   };
 }
@@ -65,10 +65,15 @@ namespace CryptoNote
   {
     uint32_t current_height;
     Crypto::Hash top_id;
+    uint32_t pruned_height; // blocks below it are served without transactions, 0 if the node isn't pruned
 
     void serialize(ISerializer& s) {
       KV_MEMBER(current_height)
       KV_MEMBER(top_id)
+      if (s.type() == ISerializer::INPUT) {
+        pruned_height = 0;
+      }
+      KV_MEMBER(pruned_height)
     }
   };
 
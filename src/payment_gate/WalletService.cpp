@@ -84,7 +84,8 @@ std::string getPaymentIdStringFromExtra(const std::string& binaryString) {
 }
 
 struct TransactionsInBlockInfoFilter {
-  TransactionsInBlockInfoFilter(const std::vector<std::string>& addressesVec, const std::string& paymentIdStr) {
+  TransactionsInBlockInfoFilter(const std::vector<std::string>& addressesVec, const std::string& paymentIdStr) :
+    addressList(addressesVec) {
     addresses.insert(addressesVec.begin(), addressesVec.end());
 
     if (!paymentIdStr.empty()) {
@@ -122,6 +123,7 @@ struct TransactionsInBlockInfoFilter {
     return haveAddress;
   }
 
+  std::vector<std::string> addressList;
   std::unordered_set<std::string> addresses;
   bool havePaymentId = false;
   Crypto::Hash paymentId;
@@ -156,30 +158,6 @@ Crypto::Hash parseHash(const std::string& hashString, Logging::LoggerRef logger)
   return hash;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> filterTransactions(
-  const std::vector<CryptoNote::TransactionsInBlockInfo>& blocks,
-  const TransactionsInBlockInfoFilter& filter) {
-
-  std::vector<CryptoNote::TransactionsInBlockInfo> result;
-
-  for (const auto& block: blocks) {
-    CryptoNote::TransactionsInBlockInfo item;
-    item.blockHash = block.blockHash;
-
-    for (const auto& transaction: block.transactions) {
-      if (transaction.transaction.state != CryptoNote::WalletTransactionState::DELETED && filter.checkTransaction(transaction)) {
-        item.transactions.push_back(transaction);
-      }
-    }
-
-    if (!block.transactions.empty()) {
-      result.push_back(std::move(item));
-    }
-  }
-
-  return result;
-}
-
 PaymentService::TransactionRpcInfo convertTransactionWithTransfersToTransactionRpcInfo(
   const CryptoNote::WalletTransactionWithTransfers& transactionWithTransfers) {
 
@@ -310,10 +288,12 @@ void generateNewWallet(const CryptoNote::Currency &currency, const WalletConfigu
 }
 
 WalletService::WalletService(const CryptoNote::Currency& currency, System::Dispatcher& sys, CryptoNote::INode& node,
-  CryptoNote::IWallet& wallet, CryptoNote::IFusionManager& fusionManager, const WalletConfiguration& conf, Logging::ILogger& logger) :
+  CryptoNote::IWallet& wallet, CryptoNote::IFusionManager& fusionManager, CryptoNote::IWalletTransactionsQuery& transactionsQuery,
+  const WalletConfiguration& conf, Logging::ILogger& logger) :
     currency(currency),
     wallet(wallet),
     fusionManager(fusionManager),
+    transactionsQuery(transactionsQuery),
     node(node),
     config(conf),
     inited(false),
@@ -1028,45 +1008,44 @@ void WalletService::replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey)
   inited = true;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount);
-  if (result.empty()) {
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount,
+  const TransactionsInBlockInfoFilter& filter) const {
+
+  uint32_t firstBlockIndex;
+  if (!transactionsQuery.getBlockIndex(blockHash, firstBlockIndex)) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
 
-  return result;
+  return getTransactions(firstBlockIndex, blockCount, filter);
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount);
-  if (result.empty()) {
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount,
+  const TransactionsInBlockInfoFilter& filter) const {
+
+  if (firstBlockIndex >= wallet.getBlockCount()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
   }
 
-  return result;
+  return transactionsQuery.findTransactions(firstBlockIndex, blockCount, filter.addressList, filter.havePaymentId ? &filter.paymentId : nullptr);
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
+  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = getTransactions(blockHash, blockCount, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
+  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
+  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = getTransactions(blockHash, blockCount, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
-  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
+  std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
 
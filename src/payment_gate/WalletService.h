@@ -4,6 +4,7 @@
 #include <System/Dispatcher.h>
 #include <System/Event.h>
 #include "IWallet.h"
+#include "wallet/IWalletTransactionsQuery.h"
 #include "INode.h"
 #include "core/Currency.h"
 #include "PaymentServiceJsonRpcMessages.h"
@@ -35,7 +36,8 @@ struct TransactionsInBlockInfoFilter;
 class WalletService {
 public:
   WalletService(const CryptoNote::Currency& currency, System::Dispatcher& sys, CryptoNote::INode& node, CryptoNote::IWallet& wallet,
-    CryptoNote::IFusionManager& fusionManager, const WalletConfiguration& conf, Logging::ILogger& logger);
+    CryptoNote::IFusionManager& fusionManager, CryptoNote::IWalletTransactionsQuery& transactionsQuery, const WalletConfiguration& conf,
+    Logging::ILogger& logger);
   virtual ~WalletService();
 
   void init();
@@ -82,8 +84,8 @@ private:
 
   void replaceWithNewWallet(const Crypto::SecretKey& viewSecretKey);
 
-  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const;
-  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(uint32_t firstBlockIndex, size_t blockCount) const;
+  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
+  std::vector<CryptoNote::TransactionsInBlockInfo> getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
 
   std::vector<TransactionHashesInBlockRpcInfo> getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
   std::vector<TransactionHashesInBlockRpcInfo> getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const;
@@ -94,6 +96,7 @@ private:
   const CryptoNote::Currency& currency;
   CryptoNote::IWallet& wallet;
   CryptoNote::IFusionManager& fusionManager;
+  CryptoNote::IWalletTransactionsQuery& transactionsQuery;
   CryptoNote::INode& node;
   const WalletConfiguration& config;
   bool inited;
@@ -40,6 +40,7 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_stop(false),
   m_observedHeight(0),
   m_peersCount(0),
+  m_prunedHeight(0),
   logger(log, "protocol") {
 
   if (!m_p2p) {
@@ -114,6 +115,7 @@ void CryptoNoteProtocolHandler::log_connections() {
     << std::setw(20) << "Peer id"
     << std::setw(25) << "Recv/Sent (inactive,sec)"
     << std::setw(25) << "State"
+    << std::setw(15) << "Pruned height"
     << std::setw(20) << "Lifetime(seconds)" << ENDL;
 
   m_p2p->for_each_connection([&](const CryptoNoteConnectionContext& cntxt, PeerIdType peer_id) {
@@ -122,6 +124,7 @@ void CryptoNoteProtocolHandler::log_connections() {
       << std::setw(20) << std::hex << peer_id
       // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
       << std::setw(25) << get_protocol_state_string(cntxt.m_state)
+      << std::setw(15) << std::to_string(cntxt.m_remote_pruned_height)
       << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
   });
   logger(INFO) << "Connections: " << ENDL << ss.str();
@@ -146,6 +149,14 @@ bool CryptoNoteProtocolHandler::process_payload_sync_data(const CORE_SYNC_DATA&
     } else {
       context.m_state = CryptoNoteConnectionContext::state_normal;
     }
+  } else if (hshd.pruned_height > get_current_blockchain_height()) {
+    // the peer can't send the blocks we need next
+    logger(Logging::DEBUGGING) << context << "Peer is pruned below height " << hshd.pruned_height << ", not synchronizing from it";
+    if (is_inital) {
+      context.m_state = CryptoNoteConnectionContext::state_pool_sync_required;
+    } else {
+      context.m_state = CryptoNoteConnectionContext::state_normal;
+    }
   } else {
     int64_t diff = static_cast<int64_t>(hshd.current_height) - static_cast<int64_t>(get_current_blockchain_height());
 
@@ -162,6 +173,7 @@ bool CryptoNoteProtocolHandler::process_payload_sync_data(const CORE_SYNC_DATA&
 
   updateObservedHeight(hshd.current_height, context);
   context.m_remote_blockchain_height = hshd.current_height;
+  context.m_remote_pruned_height = hshd.pruned_height;
 
   if (is_inital) {
     m_peersCount++;
@@ -176,6 +188,7 @@ bool CryptoNoteProtocolHandler::get_payload_sync_data(CORE_SYNC_DATA& hshd) {
   m_core.get_blockchain_top(current_height, hshd.top_id);
   hshd.current_height = current_height;
   hshd.current_height += 1;
+  hshd.pruned_height = m_prunedHeight;
   return true;
 }
 
@@ -232,8 +245,10 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
   for (auto tx_blob_it = arg.b.txs.begin(); tx_blob_it != arg.b.txs.end(); tx_blob_it++) {
     CryptoNote::tx_verification_context tvc = boost::value_initialized<decltype(tvc)>();
     auto transactionBinary = asBinaryArray(*tx_blob_it);
-    Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
-    logger(DEBUGGING) << "transaction " << transactionHash << " came in NOTIFY_NEW_BLOCK";
+    if (logger.isEnabled(DEBUGGING)) {
+      Crypto::Hash transactionHash = Crypto::cn_fast_hash(transactionBinary.data(), transactionBinary.size());
+      logger(DEBUGGING) << "transaction " << transactionHash << " came in NOTIFY_NEW_BLOCK";
+    }
 
     m_core.handle_incoming_tx(transactionBinary, tvc, true);
     if (tvc.m_verification_failed) {
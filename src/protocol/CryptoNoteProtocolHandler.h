@@ -37,6 +37,8 @@ namespace CryptoNote
     virtual bool removeObserver(ICryptoNoteProtocolObserver* observer) override;
 
     void set_p2p_endpoint(IP2pEndpoint* p2p);
+    // advertised to peers, so they don't request pruned blocks
+    void setPrunedHeight(uint32_t height) { m_prunedHeight = height; }
     // ICore& get_core() { return m_core; }
     virtual bool isSynchronized() const override { return m_synchronized; }
     void log_connections();
@@ -92,6 +94,7 @@ namespace CryptoNote
     uint32_t m_observedHeight;
 
     std::atomic<size_t> m_peersCount;
+    std::atomic<uint32_t> m_prunedHeight;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
   };
 }
@@ -4,12 +4,14 @@
 #include <unordered_map>
 
 // CryptoNote
+#include "common/Metrics.h"
 #include "common/StringTools.h"
 #include "base/CryptoNoteTools.h"
 #include "core/Core.h"
 #include "seria/IBlock.h"
 #include "core/mine//Miner.h"
 #include "core/trans/TransactionExtra.h"
+#include "crypto/crypto.h"
 
 #include "ICryptoNoteProtocolQuery.h"
 
@@ -87,11 +89,40 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
 
   // json rpc
-  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+  { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } },
+
+  // metrics in prometheus text format
+  { "/metrics", { std::bind(&RpcServer::processMetricsRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
+};
+
+std::unordered_map<std::string, RpcServer::RpcHandler<JsonRpc::JsonMemberMethod>> RpcServer::s_jsonRpcHandlers = {
+ // { "f_get_blockchain_settings", { JsonRpc::makeMemberMethod(&RpcServer::f_on_get_blockchain_settings), true } },
+  { "getblockcount", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockcount), true } },
+  { "on_getblockhash", { JsonRpc::makeMemberMethod(&RpcServer::on_getblockhash), false } },
+  { "getblocktemplate", { JsonRpc::makeMemberMethod(&RpcServer::on_getblocktemplate), false } },
+  { "getcurrencyid", { JsonRpc::makeMemberMethod(&RpcServer::on_get_currency_id), true } },
+  { "submitblock", { JsonRpc::makeMemberMethod(&RpcServer::on_submitblock), false } },
+  { "getlastblockheader", { JsonRpc::makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
+  { "getblockheaderbyhash", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
+  { "getblockheaderbyheight", { JsonRpc::makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } },
+  { "f_blocks_list_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_blocks_list_json), false } },
+  { "f_block_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_block_json), false } },
+  { "f_transaction_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_transaction_json), false } },
+  { "f_on_transactions_pool_json", { JsonRpc::makeMemberMethod(&RpcServer::f_on_transactions_pool_json), false } }
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, core& c, NodeServer& p2p, const ICryptoNoteProtocolQuery& protocolQuery) :
-  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocolQuery(protocolQuery) {
+  HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocolQuery(protocolQuery), m_infoCache(1) {
+  MetricsRegistry& registry = MetricsRegistry::instance();
+  for (const auto& handler : s_handlers) {
+    m_urlMetrics[handler.first] = &registry.histogram("rpc_request_seconds", "Time spent handling RPC requests",
+      "url=\"" + handler.first + "\"");
+  }
+
+  for (const auto& handler : s_jsonRpcHandlers) {
+    m_jsonRpcMetrics[handler.first] = &registry.histogram("rpc_json_request_seconds", "Time spent handling JSON-RPC methods",
+      "method=\"" + handler.first + "\"");
+  }
 }
 
 void RpcServer::processRequest(const HttpRequest& request, HttpResponse& response) {
@@ -110,6 +141,7 @@ void RpcServer::processRequest(const HttpRequest& request, HttpResponse& respons
     return;
   }
 
+  MetricsTimer timer(*m_urlMetrics.at(url));
   it->second.handler(this, request, response);
 }
 
@@ -130,24 +162,8 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     jsonRequest.parseRequest(request.getBody());
     jsonResponse.setId(jsonRequest.getId()); // copy id
 
-    static std::unordered_map<std::string, RpcServer::RpcHandler<JsonMemberMethod>> jsonRpcHandlers = {
-     // { "f_get_blockchain_settings", { makeMemberMethod(&RpcServer::f_on_get_blockchain_settings), true } },
-      { "getblockcount", { makeMemberMethod(&RpcServer::on_getblockcount), true } },
-      { "on_getblockhash", { makeMemberMethod(&RpcServer::on_getblockhash), false } },
-      { "getblocktemplate", { makeMemberMethod(&RpcServer::on_getblocktemplate), false } },
-      { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
-      { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
-      { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
-      { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
-      { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } },
-      { "f_blocks_list_json", { makeMemberMethod(&RpcServer::f_on_blocks_list_json), false } },
-      { "f_block_json", { makeMemberMethod(&RpcServer::f_on_block_json), false } },
-      { "f_transaction_json", { makeMemberMethod(&RpcServer::f_on_transaction_json), false } },
-      { "f_on_transactions_pool_json", { makeMemberMethod(&RpcServer::f_on_transactions_pool_json), false } }
-    };
-
-    auto it = jsonRpcHandlers.find(jsonRequest.getMethod());
-    if (it == jsonRpcHandlers.end()) {
+    auto it = s_jsonRpcHandlers.find(jsonRequest.getMethod());
+    if (it == s_jsonRpcHandlers.end()) {
       throw JsonRpcError(JsonRpc::errMethodNotFound);
     }
 
@@ -155,6 +171,7 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
       throw JsonRpcError(CORE_RPC_ERROR_CODE_CORE_BUSY, "Core is busy");
     }
 
+    MetricsTimer timer(*m_jsonRpcMetrics.at(it->first));
     it->second.handler(this, jsonRequest, jsonResponse);
 
   } catch (const JsonRpcError& err) {
@@ -168,6 +185,34 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
   return true;
 }
 
+bool RpcServer::processMetricsRequest(const HttpRequest& request, HttpResponse& response) {
+  MetricsRegistry& registry = MetricsRegistry::instance();
+
+  // state of the node is sampled on scrape, everything else is updated where it happens
+  registry.gauge("blockchain_height", "Current blockchain height").set(m_core.get_current_blockchain_height());
+  registry.gauge("txpool_size", "Transactions in the pool").set(m_core.get_pool_transactions_count());
+  registry.gauge("p2p_connections", "Connected peers").set(m_p2p.get_connections_count());
+
+  auto setCacheStats = [&registry](const std::string& cache, const TipQueryCacheStats& stats) {
+    std::string labels = "cache=\"" + cache + "\"";
+    registry.counter("cache_hits_total", "Cache hits", labels).advanceTo(stats.hits);
+    registry.counter("cache_misses_total", "Cache misses", labels).advanceTo(stats.misses);
+    registry.gauge("cache_entries", "Entries currently in cache", labels).set(stats.entries);
+  };
+
+  setCacheStats("queryblockslite", m_core.getQueryBlocksLiteCacheStats());
+  setCacheStats("get_pool_changes_lite", m_core.getPoolChangesLiteCacheStats());
+  setCacheStats("ring_signatures", m_core.getVerifiedSignaturesCacheStats());
+  setCacheStats("blocks_storage", m_core.getBlocksCacheStats());
+  setCacheStats("getinfo", getInfoCacheStats());
+  Crypto::PointCacheStats pointStats = Crypto::get_point_cache_stats();
+  setCacheStats("ring_member_points", { pointStats.hits, pointStats.misses, pointStats.entries });
+
+  response.addHeader("Content-Type", "text/plain; version=0.0.4");
+  response.setBody(registry.format());
+  return true;
+}
+
 bool RpcServer::restrictRPC(const bool is_restricted) {
   m_restricted_rpc = is_restricted;
   return true;
@@ -183,6 +228,10 @@ bool RpcServer::setFeeAddress(const std::string fee_address) {
   return true;
 }
 
+TipQueryCacheStats RpcServer::getInfoCacheStats() const {
+  return m_infoCache.getStats();
+}
+
 bool RpcServer::isCoreReady() {
   return m_core.currency().isTestnet() || m_p2p.get_payload_object().isSynchronized();
 }
@@ -332,10 +381,23 @@ bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::re
 //
 
 bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res) {
-  res.height = m_core.get_current_blockchain_height();
-  res.difficulty = m_core.getNextBlockDifficulty();
-  res.tx_count = m_core.get_blockchain_total_transactions() - res.height; //without coinbase
-  res.tx_pool_size = m_core.get_pool_transactions_count();
+  // blockchain and pool derived fields only change on blockchainUpdated/poolUpdated,
+  // adding an alternative block changes neither version, so its count is read on every call
+  uint64_t blockchainVersion = m_core.getBlockchainVersion();
+  uint64_t poolVersion = m_core.getPoolVersion();
+  std::shared_ptr<const COMMAND_RPC_GET_INFO::response> cached = m_infoCache.find(blockchainVersion, poolVersion);
+  if (cached) {
+    res = *cached;
+  } else {
+    res.height = m_core.get_current_blockchain_height();
+    res.difficulty = m_core.getNextBlockDifficulty();
+    res.tx_count = m_core.get_blockchain_total_transactions() - res.height; //without coinbase
+    res.tx_pool_size = m_core.get_pool_transactions_count();
+    res.full_deposit_amount = m_core.fullDepositAmount();
+    res.full_deposit_interest = m_core.fullDepositInterest();
+    m_infoCache.insert(blockchainVersion, poolVersion, std::make_shared<const COMMAND_RPC_GET_INFO::response>(res));
+  }
+
   res.alt_blocks_count = m_core.get_alternative_blocks_count();
   uint64_t total_conn = m_p2p.get_connections_count();
   res.outgoing_connections_count = m_p2p.get_outgoing_connections_count();
@@ -343,8 +405,6 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
   res.white_peerlist_size = m_p2p.getPeerlistManager().get_white_peers_count();
   res.grey_peerlist_size = m_p2p.getPeerlistManager().get_gray_peers_count();
   res.last_known_block_index = std::max(static_cast<uint32_t>(1), m_protocolQuery.getObservedHeight()) - 1;
-  res.full_deposit_amount = m_core.fullDepositAmount();
-  res.full_deposit_interest = m_core.fullDepositInterest();
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -513,34 +573,23 @@ bool RpcServer::f_on_blocks_list_json(const F_COMMAND_RPC_GET_BLOCKS_LIST::reque
     last_height = 0;
   }
 
-  for (uint32_t i = req.height; i >= last_height; i--) {
-    Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(i));
-    Block blk;
-    if (!m_core.getBlockByHash(block_hash, blk)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't get block by height. Height = " + std::to_string(i) + '.' };
-    }
-
-    size_t tx_cumulative_block_size;
-    m_core.getBlockSize(block_hash, tx_cumulative_block_size);
-    size_t blokBlobSize = getObjectBinarySize(blk);
-    size_t minerTxBlobSize = getObjectBinarySize(blk.baseTransaction);
-    difficulty_type blockDiff;
-    m_core.getBlockDifficulty(static_cast<uint32_t>(i), blockDiff);
+  std::vector<BlockSummary> summaries;
+  if (!m_core.getBlockSummaries(last_height, static_cast<uint32_t>(req.height - last_height + 1), summaries)) {
+    throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+      "Internal error: can't get blocks by height. Height = " + std::to_string(req.height) + '.' };
+  }
 
+  res.blocks.reserve(summaries.size());
+  for (auto it = summaries.rbegin(); it != summaries.rend(); ++it) {
     f_block_short_response block_short;
-    block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-    block_short.timestamp = blk.timestamp;
-    block_short.height = i;
-    m_core.getBlockDifficulty(static_cast<uint32_t>(block_short.height), block_short.difficulty);
-    block_short.hash = Common::podToHex(block_hash);
-    block_short.tx_count = blk.transactionHashes.size() + 1;
-    block_short.difficulty = blockDiff;
+    block_short.cumul_size = it->blockSize;
+    block_short.timestamp = it->timestamp;
+    block_short.height = it->height;
+    block_short.hash = Common::podToHex(it->hash);
+    block_short.tx_count = it->transactionCount;
+    block_short.difficulty = it->difficulty;
 
     res.blocks.push_back(block_short);
-
-    if (i == 0)
-      break;
   }
 
   res.status = CORE_RPC_STATUS_OK;
@@ -584,12 +633,6 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
 
   res.block.reward = block_header.reward;
 
-  std::vector<size_t> blocksSizes;
-  if (!m_core.getBackwardBlocksSizes(res.block.height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
-    return false;
-  }
-  res.block.sizeMedian = Common::medianValue(blocksSizes);
-
   size_t blockSize = 0;
   if (!m_core.getBlockSize(hash, blockSize)) {
     return false;
@@ -610,40 +653,40 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
     return false;
   }
 
-  uint64_t prevBlockGeneratedCoins = 0;
-  if (res.block.height > 0) {
-    if (!m_core.getAlreadyGeneratedCoins(blk.previousBlockHash, prevBlockGeneratedCoins)) {
+  BlockRewardInfo rewardInfo;
+  if (m_core.getBlockIdByHeight(static_cast<uint32_t>(res.block.height)) == hash) {
+    if (!m_core.getBlockRewardInfo(static_cast<uint32_t>(res.block.height), rewardInfo)) {
+      return false;
+    }
+  } else {
+    // alternative blocks are not cached, calculate against the main chain as before
+    std::vector<size_t> blocksSizes;
+    if (!m_core.getBackwardBlocksSizes(res.block.height, blocksSizes, parameters::CRYPTONOTE_REWARD_BLOCKS_WINDOW)) {
+      return false;
+    }
+
+    uint64_t prevBlockGeneratedCoins = 0;
+    if (res.block.height > 0) {
+      if (!m_core.getAlreadyGeneratedCoins(blk.previousBlockHash, prevBlockGeneratedCoins)) {
+        return false;
+      }
+    }
+
+    if (!m_core.currency().getBlockRewardInfo(blk.majorVersion, Common::medianValue(blocksSizes), res.block.transactionsCumulativeSize, prevBlockGeneratedCoins,
+      static_cast<uint32_t>(res.block.height), rewardInfo)) {
       return false;
     }
   }
-  uint64_t maxReward = 0;
-  uint64_t currentReward = 0;
-  int64_t emissionChange = 0;
+  res.block.sizeMedian = rewardInfo.sizeMedian;
+
   bool penalizeFee = blk.majorVersion >= 2;
   size_t blockGrantedFullRewardZone = penalizeFee ?
   m_core.currency().blockGrantedFullRewardZone() :
   //m_core.currency().blockGrantedFullRewardZoneV1();
   res.block.effectiveSizeMedian = std::max(res.block.sizeMedian, blockGrantedFullRewardZone);
 
-  // virtual bool getBlockReward(size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint32_t height,
-                              // uint64_t& reward, int64_t& emissionChange) = 0;
-
-  if (!m_core.getBlockReward(res.block.major_version, res.block.sizeMedian, 0, prevBlockGeneratedCoins, 0, res.block.height, maxReward, emissionChange)) {
-    return false;
-  }
-  if (!m_core.getBlockReward(res.block.major_version, res.block.sizeMedian, res.block.transactionsCumulativeSize, prevBlockGeneratedCoins, 0, res.block.height, currentReward, emissionChange)) {
-    return false;
-  }
-
-  res.block.baseReward = maxReward;
-  if (maxReward == 0 && currentReward == 0) {
-    res.block.penalty = static_cast<double>(0);
-  } else {
-    if (maxReward < currentReward) {
-      return false;
-    }
-    res.block.penalty = static_cast<double>(maxReward - currentReward) / static_cast<double>(maxReward);
-  }
+  res.block.baseReward = rewardInfo.baseReward;
+  res.block.penalty = rewardInfo.penalty;
 
   // Base transaction adding
   f_transaction_short_response transaction_short;
@@ -709,20 +752,16 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
   Crypto::Hash blockHash;
   uint32_t blockHeight;
   if (m_core.getBlockContainingTx(hash, blockHash, blockHeight)) {
-    Block blk;
-    if (m_core.getBlockByHash(blockHash, blk)) {
-      size_t tx_cumulative_block_size;
-      m_core.getBlockSize(blockHash, tx_cumulative_block_size);
-      size_t blokBlobSize = getObjectBinarySize(blk);
-      size_t minerTxBlobSize = getObjectBinarySize(blk.baseTransaction);
+    std::vector<BlockSummary> summaries;
+    if (m_core.getBlockSummaries(blockHeight, 1, summaries) && !summaries.empty()) {
+      const BlockSummary& summary = summaries.front();
       f_block_short_response block_short;
 
-      block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-      block_short.timestamp = blk.timestamp;
+      block_short.cumul_size = summary.blockSize;
+      block_short.timestamp = summary.timestamp;
       block_short.height = blockHeight;
       block_short.hash = Common::podToHex(blockHash);
-      block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-      block_short.tx_count = blk.transactionHashes.size() + 1;
+      block_short.tx_count = summary.transactionCount;
       res.block = block_short;
     }
   }
@@ -936,18 +975,40 @@ void RpcServer::fill_block_header_response(const Block& blk, bool orphan_status,
   responce.reward = get_block_reward(blk);
 }
 
+void RpcServer::fill_block_header_response(const BlockSummary& summary, block_header_response& responce) {
+  responce.major_version = summary.majorVersion;
+  responce.minor_version = summary.minorVersion;
+  responce.timestamp = summary.timestamp;
+  responce.prev_hash = Common::podToHex(summary.previousBlockHash);
+  responce.nonce = summary.nonce;
+  responce.orphan_status = false;
+  responce.height = summary.height;
+  responce.depth = summary.depth;
+  responce.hash = Common::podToHex(summary.hash);
+  responce.difficulty = summary.difficulty;
+  responce.reward = summary.reward;
+}
+
+bool RpcServer::fill_block_header_by_height(uint32_t height, block_header_response& responce) {
+  std::vector<BlockSummary> summaries;
+  if (!m_core.getBlockSummaries(height, 1, summaries) || summaries.empty()) {
+    return false;
+  }
+
+  fill_block_header_response(summaries.front(), responce);
+  return true;
+}
+
 bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res) {
   uint32_t last_block_height;
   Hash last_block_hash;
 
   m_core.get_blockchain_top(last_block_height, last_block_hash);
 
-  Block last_block;
-  if (!m_core.getBlockByHash(last_block_hash, last_block)) {
+  if (!fill_block_header_by_height(last_block_height, res.block_header)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't get last block hash." };
   }
 
-  fill_block_header_response(last_block, false, last_block_height, last_block_hash, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -961,6 +1022,13 @@ bool RpcServer::on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_B
       "Failed to parse hex representation of block hash. Hex = " + req.hash + '.' };
   }
 
+  BlockSummary summary;
+  if (m_core.getBlockSummary(block_hash, summary)) {
+    fill_block_header_response(summary, res.block_header);
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+
   Block blk;
   if (!m_core.getBlockByHash(block_hash, blk)) {
     throw JsonRpc::JsonRpcError{
@@ -986,14 +1054,11 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
       std::string("To big height: ") + std::to_string(req.height) + ", current blockchain height = " + std::to_string(m_core.get_current_blockchain_height()) };
   }
 
-  Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(req.height));
-  Block blk;
-  if (!m_core.getBlockByHash(block_hash, blk)) {
+  if (!fill_block_header_by_height(static_cast<uint32_t>(req.height), res.block_header)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
       "Internal error: can't get block by height. Height = " + std::to_string(req.height) + '.' };
   }
 
-  fill_block_header_response(blk, false, req.height, block_hash, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
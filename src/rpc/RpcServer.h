@@ -7,13 +7,17 @@
 
 #include <log/LoggerRef.h>
 #include "common/Math.h"
+#include "common/Metrics.h"
+#include "core/TipQueryCache.h"
 #include "CoreRpcServerCommandsDefinitions.h"
+#include "JsonRpc.h"
 
 namespace CryptoNote {
 
 class core;
 class NodeServer;
 class ICryptoNoteProtocolQuery;
+struct BlockSummary;
 
 class RpcServer : public HttpServer {
 public:
@@ -23,6 +27,7 @@ public:
   bool restrictRPC(const bool is_resctricted);
   bool enableCors(const std::string domain);
   bool setFeeAddress(const std::string fee_address);
+  TipQueryCacheStats getInfoCacheStats() const;
 
 private:
 
@@ -34,9 +39,11 @@ private:
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
   static std::unordered_map<std::string, RpcHandler<HandlerFunction>> s_handlers;
+  static std::unordered_map<std::string, RpcHandler<JsonRpc::JsonMemberMethod>> s_jsonRpcHandlers;
 
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
+  bool processMetricsRequest(const HttpRequest& request, HttpResponse& response);
   bool isCoreReady();
 
   // binary handlers
@@ -70,6 +77,8 @@ private:
   bool on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::response& res);
 
   void fill_block_header_response(const Block& blk, bool orphan_status, uint64_t height, const Crypto::Hash& hash, block_header_response& responce);
+  void fill_block_header_response(const BlockSummary& summary, block_header_response& responce);
+  bool fill_block_header_by_height(uint32_t height, block_header_response& responce);
 
   //block_explorer
   bool f_on_blocks_list_json(const F_COMMAND_RPC_GET_BLOCKS_LIST::request& req, F_COMMAND_RPC_GET_BLOCKS_LIST::response& res);
@@ -86,6 +95,10 @@ private:
   bool m_restricted_rpc;
   std::string m_cors_domain;
   std::string m_fee_address;
+  TipQueryCache<uint64_t, COMMAND_RPC_GET_INFO::response> m_infoCache;
+  // request time histograms of every url and JSON-RPC method, filled in the constructor and read only afterwards
+  std::unordered_map<std::string, Common::MetricsHistogram*> m_urlMetrics;
+  std::unordered_map<std::string, Common::MetricsHistogram*> m_jsonRpcMetrics;
 };
 
 }
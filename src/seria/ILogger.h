@@ -40,6 +40,9 @@ public:
   const static std::array<std::string, 6> LEVEL_NAMES;
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) = 0;
+
+  // most verbose level the logger may write, messages above it can be skipped without formatting
+  virtual Level getMaxLevel() const { return TRACE; }
 };
 
 #ifndef ENDL
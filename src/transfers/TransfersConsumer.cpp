@@ -1,9 +1,11 @@
 #include "TransfersConsumer.h"
 
+#include <iterator>
 #include <numeric>
 
 #include "CommonTypes.h"
-#include "common/BlockingQueue.h"
+#include "common/MpmcQueue.h"
+#include "common/ThreadPool.h"
 #include "base/CryptoNoteFormatUtils.h"
 #include "core/trans/TransactionApi.h"
 #include "core/trans/TransactionExtra.h"
@@ -18,35 +20,18 @@ namespace {
 
 using namespace CryptoNote;
 
-void checkOutputKey(
-  const KeyDerivation& derivation,
-  const PublicKey& key,
-  size_t keyIndex,
-  size_t outputIndex,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
-
-  PublicKey spendKey;
-  underive_public_key(derivation, keyIndex, key, spendKey);
-
-  if (spendKeys.find(spendKey) != spendKeys.end()) {
-    outputs[spendKey].push_back(static_cast<uint32_t>(outputIndex));
-  }
-
-}
+// number of transactions whose key derivations are computed together
+const size_t DERIVATION_BATCH_SIZE = 32;
 
 void findMyOutputs(
   const ITransactionReader& tx,
-  const SecretKey& viewSecretKey,
+  const KeyDerivation& derivation,
   const std::unordered_set<PublicKey>& spendKeys,
   std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
 
-  auto txPublicKey = tx.getTransactionPublicKey();
-  KeyDerivation derivation;
-
-  if (!generate_key_derivation( txPublicKey, viewSecretKey, derivation)) {
-    return;
-  }
+  std::vector<PublicKey> keys;
+  std::vector<size_t> keyIndexes;
+  std::vector<uint32_t> outputIndexes;
 
   size_t keyIndex = 0;
   size_t outputCount = tx.getOutputCount();
@@ -60,7 +45,9 @@ void findMyOutputs(
       uint64_t amount;
       KeyOutput out;
       tx.getOutput(idx, out, amount);
-      checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
+      keys.push_back(out.key);
+      keyIndexes.push_back(keyIndex);
+      outputIndexes.push_back(static_cast<uint32_t>(idx));
       ++keyIndex;
 
     } else if (outType == TransactionTypes::OutputType::Multisignature) {
@@ -69,11 +56,23 @@ void findMyOutputs(
       MultisignatureOutput out;
       tx.getOutput(idx, out, amount);
       for (const auto& key : out.keys) {
-        checkOutputKey(derivation, key, idx, idx, spendKeys, outputs);
+        keys.push_back(key);
+        keyIndexes.push_back(idx);
+        outputIndexes.push_back(static_cast<uint32_t>(idx));
         ++keyIndex;
       }
     }
   }
+
+  std::vector<PublicKey> spendKeyCandidates(keys.size());
+  std::unique_ptr<bool[]> valid(new bool[keys.size()]);
+  underive_public_keys(derivation, keyIndexes.data(), keys.data(), keys.size(), spendKeyCandidates.data(), valid.get());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (valid[i] && spendKeys.find(spendKeyCandidates[i]) != spendKeys.end()) {
+      outputs[spendKeyCandidates[i]].push_back(outputIndexes[i]);
+    }
+  }
 }
 
 std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks, size_t count) {
@@ -181,20 +180,87 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startH
 
   struct PreprocessedTx : Tx, PreprocessInfo {};
 
-  std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
+  Common::ThreadPool& pool = Common::ThreadPool::instance();
+  size_t workers = pool.getThreadCount();
 
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
+  // transactions are queued in batches, so their key derivations share a field inversion
+  Common::MpmcQueue<std::vector<Tx>> inputQueue(workers * 2);
+  // each worker and the calling thread collect their results separately, they are merged once all have finished
+  std::vector<std::vector<PreprocessedTx>> workerResults(workers + 1);
+
+  std::atomic<bool> stopProcessing(false);
+
+  auto processBatch = [&](const std::vector<Tx>& batch, std::vector<PreprocessedTx>& preprocessedTransactions,
+    std::vector<PublicKey>& txPublicKeys, std::vector<KeyDerivation>& derivations) {
+    std::error_code ec;
+    txPublicKeys.clear();
+    for (const auto& item : batch) {
+      txPublicKeys.push_back(item.tx->getTransactionPublicKey());
+    }
+
+    derivations.resize(batch.size());
+    std::unique_ptr<bool[]> valid(new bool[batch.size()]);
+    generate_key_derivations(txPublicKeys.data(), txPublicKeys.size(), m_viewSecret, derivations.data(), valid.get());
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      PreprocessedTx output;
+      static_cast<Tx&>(output) = batch[i];
+
+      // a transaction without valid public key can't have our outputs, but may spend them
+      if (valid[i]) {
+        ec = preprocessOutputs(batch[i].blockInfo, *batch[i].tx, derivations[i], output);
+        if (ec) {
+          stopProcessing = true;
+          break;
+        }
+      }
+
+      preprocessedTransactions.push_back(std::move(output));
+    }
+
+    return ec;
+  };
+
+  auto processingFunction = [&](std::vector<PreprocessedTx>& preprocessedTransactions) {
+    std::vector<Tx> batch;
+    std::vector<PublicKey> txPublicKeys;
+    std::vector<KeyDerivation> derivations;
+    std::error_code ec;
+    while (!ec && !stopProcessing && inputQueue.pop(batch)) {
+      ec = processBatch(batch, preprocessedTransactions, txPublicKeys, derivations);
+    }
+
+    return ec;
+  };
+
+  std::vector<std::future<std::error_code>> processingTasks;
+  for (size_t i = 0; i < workers; ++i) {
+    std::vector<PreprocessedTx>& results = workerResults[i];
+    processingTasks.push_back(pool.submit([&processingFunction, &results] { return processingFunction(results); }));
   }
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
+  // the calling thread queues the transactions and processes a batch itself whenever the queue is full,
+  // so blocks are processed even if the pool workers are busy with other tasks
+  std::error_code processingError;
+  try {
+    std::vector<PreprocessedTx>& ownResults = workerResults[workers];
+    std::vector<Tx> batch;
+    std::vector<Tx> ownBatch;
+    std::vector<PublicKey> txPublicKeys;
+    std::vector<KeyDerivation> derivations;
+    batch.reserve(DERIVATION_BATCH_SIZE);
+
+    auto pushBatch = [&] {
+      while (!processingError && !stopProcessing && !inputQueue.tryPush(std::move(batch))) {
+        if (inputQueue.tryPop(ownBatch)) {
+          processingError = processBatch(ownBatch, ownResults, txPublicKeys, derivations);
+        }
+      }
 
-  std::atomic<bool> stopProcessing(false);
+      batch.clear();
+    };
 
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
+    for (uint32_t i = 0; i < count && !stopProcessing; ++i) {
       const auto& block = blocks[i].block;
 
       if (!block.is_initialized()) {
@@ -219,40 +285,36 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startH
         }
 
         Tx item = { blockInfo, tx.get() };
-        inputQueue.push(item);
+        batch.push_back(item);
+        if (batch.size() == DERIVATION_BATCH_SIZE) {
+          pushBatch();
+        }
         ++blockInfo.transactionIndex;
       }
     }
 
-    inputQueue.close();
-  });
-
-  auto processingFunction = [&] {
-    Tx item;
-    std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
-
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
-      if (ec) {
-        stopProcessing = true;
-        break;
-      }
+    if (!batch.empty()) {
+      pushBatch();
+    }
 
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
+    inputQueue.close();
+    if (!processingError) {
+      processingError = processingFunction(ownResults);
     }
-    return ec;
-  };
+  } catch (const std::system_error& e) {
+    processingError = e.code();
+  } catch (const std::exception&) {
+    processingError = std::make_error_code(std::errc::operation_canceled);
+  }
 
-  std::vector<std::future<std::error_code>> processingThreads;
-  for (size_t i = 0; i < workers; ++i) {
-    processingThreads.push_back(std::async(std::launch::async, processingFunction));
+  // workers still waiting for batches return once the queue is closed
+  if (processingError) {
+    stopProcessing = true;
   }
 
-  std::error_code processingError;
-  for (auto& f : processingThreads) {
+  inputQueue.close();
+
+  for (auto& f : processingTasks) {
     try {
       std::error_code ec = f.get();
       if (!processingError && ec) {
@@ -269,6 +331,11 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startH
   if (!processingError) {
     m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
+    std::vector<PreprocessedTx> preprocessedTransactions;
+    for (auto& results : workerResults) {
+      std::move(results.begin(), results.end(), std::back_inserter(preprocessedTransactions));
+    }
+
     // sort by block height and transaction index in block
     std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
       return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
@@ -413,8 +480,18 @@ std::error_code createTransfers(
 }
 
 std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
+  KeyDerivation derivation;
+  if (!generate_key_derivation(tx.getTransactionPublicKey(), m_viewSecret, derivation)) {
+    return std::error_code();
+  }
+
+  return preprocessOutputs(blockInfo, tx, derivation, info);
+}
+
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const KeyDerivation& derivation, PreprocessInfo& info) {
   std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
-  findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
+  findMyOutputs(tx, derivation, m_spendKeys, outputs);
 
   if (outputs.empty()) {
     return std::error_code();
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "IWallet.h"
+
+namespace CryptoNote {
+
+// Indexed transaction lookups, unlike IWallet::getTransactions() they don't scan every transaction in the block range
+class IWalletTransactionsQuery {
+public:
+  virtual ~IWalletTransactionsQuery() {}
+
+  virtual bool getBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const = 0;
+
+  // Returns succeeded transactions from blocks [blockIndex, blockIndex + count) which have a transfer with one of
+  // the addresses (any address if empty) and the payment id (any if nullptr). Blocks with succeeded transactions but no
+  // matching ones are returned with an empty list, blocks without succeeded transactions are skipped.
+  virtual std::vector<TransactionsInBlockInfo> findTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const = 0;
+};
+
+}
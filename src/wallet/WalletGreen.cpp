@@ -29,6 +29,7 @@
 #include "base/CryptoNoteSerialization.h"
 #include "base/CryptoNoteTools.h"
 #include "core/trans/TransactionApi.h"
+#include "core/trans/TransactionExtra.h"
 #include "crypto/crypto.h"
 #include "transfers/TransfersContainer.h"
 #include "WalletSerializationV1.h"
@@ -125,6 +126,9 @@ WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currenc
   m_eventOccurred(m_dispatcher),
   m_readyEvent(m_dispatcher),
   m_state(WalletState::NOT_INITIALIZED),
+  m_fullSaveRequired(true),
+  m_synchronizerStateChanged(true),
+  m_containerSnapshotSize(0),
   m_actualBalance(0),
   m_pendingBalance(0),
   m_transactionSoftLockTime(transactionSoftLockTime)
@@ -190,6 +194,8 @@ void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
   if (clearTransactions) {
     m_transactions.clear();
     m_transfers.clear();
+    m_paymentIdTransactions.clear();
+    m_addressTransactions.clear();
   }
 
   if (clearCachedData) {
@@ -222,6 +228,8 @@ void WalletGreen::clearCaches(bool clearTransactions, bool clearCachedData) {
     m_fusionTxsCache.clear();
     m_blockchain.clear();
   }
+
+  resetContainerChanges(true);
 }
 
 void WalletGreen::convertAndLoadWalletFile(const std::string& path, std::ifstream&& walletFileStream) {
@@ -270,6 +278,7 @@ void WalletGreen::convertAndLoadWalletFile(const std::string& path, std::ifstrea
   }
 
   saveWalletCache(m_containerStorage, m_key, WalletSaveLevel::SAVE_ALL, "");
+  resetContainerChanges(false);
 
   boost::filesystem::rename(path, bakPath);
   std::error_code ec;
@@ -443,6 +452,7 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
 
         if (!addedSpendKeys.empty() || !deletedSpendKeys.empty()) {
           saveWalletCache(m_containerStorage, m_key, WalletSaveLevel::SAVE_ALL, extra);
+          resetContainerChanges(false);
         }
       } catch (const std::exception& e) {
         m_logger(ERROR, BRIGHT_RED) << "Failed to load cache: " << e.what() << ", reset wallet data";
@@ -452,6 +462,8 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
     }
   }
 
+  rebuildTransactionIndices();
+
   m_blockchainSynchronizer.addObserver(this);
 
   initTransactionPool();
@@ -505,9 +517,15 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
     copyContainerStorageKeys(m_containerStorage, m_key, newStorage, newKey);
 
     if (m_containerStorage.suffixSize() > 0) {
-      BinaryArray containerData;
-      loadAndDecryptContainerData(m_containerStorage, m_key, containerData);
-      encryptAndSaveContainerData(newStorage, newKey, containerData.data(), containerData.size());
+      // records are copied as they are, so the container keeps the version of their format
+      uint8_t version = reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version;
+      ContainerRecords records;
+      loadContainerRecords(m_containerStorage, m_key, records);
+      if (version < WalletSerializerV2::RECORDS_MIN_VERSION) {
+        version = WalletSerializerV2::RECORDS_MIN_VERSION;
+      }
+
+      saveContainerRecords(newStorage, newKey, records, version);
     }
   });
 
@@ -523,16 +541,34 @@ void WalletGreen::save(WalletSaveLevel saveLevel, const std::string& extra) {
   throwIfNotInitialized();
   throwIfStopped();
 
+  if (saveLevel == WalletSaveLevel::SAVE_ALL && !m_fullSaveRequired) {
+    try {
+      if (saveWalletCacheChanges(extra)) {
+        m_logger(INFO, BRIGHT_WHITE) << "Container saved";
+        return;
+      }
+    } catch (const std::exception& e) {
+      m_logger(ERROR, BRIGHT_RED) << "Failed to save container changes: " << e.what();
+      // records could be partially appended, the next save must rewrite the container
+      m_fullSaveRequired = true;
+      throw;
+    }
+  }
+
   stopBlockchainSynchronizer();
 
   try {
     saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to save container: " << e.what();
+    m_fullSaveRequired = true;
     startBlockchainSynchronizer();
     throw;
   }
 
+  // records appended later have to be applied to a full cache snapshot
+  resetContainerChanges(saveLevel != WalletSaveLevel::SAVE_ALL);
+
   startBlockchainSynchronizer();
   m_logger(INFO, BRIGHT_WHITE) << "Container saved";
 }
@@ -738,6 +774,7 @@ std::string WalletGreen::addWallet(const Crypto::PublicKey& spendPublicKey, cons
     trSubscription.addObserver(this);
 
     index.insert(insertIt, std::move(wallet));
+    m_fullSaveRequired = true;
     m_logger(DEBUGGING) << "Wallet count " << m_walletsContainer.size();
 
     if (index.size() == 1) {
@@ -796,6 +833,7 @@ void WalletGreen::deleteAddress(const std::string& address) {
 #endif
 
   m_containerStorage.erase(std::next(m_containerStorage.begin(), addressIndex));
+  m_fullSaveRequired = true;
 
   m_synchronizer.removeSubscription(pubAddr);
 
@@ -1330,6 +1368,8 @@ void WalletGreen::pushBackOutgoingTransfers(size_t txId, const std::vector<Walle
 
     m_transfers.emplace_back(txId, std::move(d));
   }
+
+  markTransactionChanged(txId);
 }
 
 size_t WalletGreen::insertOutgoingTransactionAndPushEvent(const Hash& transactionHash, uint64_t fee, const BinaryArray& extra, uint64_t unlockTimestamp) {
@@ -1347,6 +1387,7 @@ size_t WalletGreen::insertOutgoingTransactionAndPushEvent(const Hash& transactio
 
   size_t txId = m_transactions.get<RandomAccessIndex>().size();
   m_transactions.get<RandomAccessIndex>().push_back(std::move(insertTx));
+  markTransactionChanged(txId);
 
   pushEvent(makeTransactionCreatedEvent(txId));
 
@@ -1361,6 +1402,7 @@ void WalletGreen::updateTransactionStateAndPushEvent(size_t transactionId, Walle
       tx.state = state;
     });
 
+    markTransactionChanged(transactionId);
     pushEvent(makeTransactionUpdatedEvent(transactionId));
     m_logger(DEBUGGING) << "Transaction state changed, ID " << transactionId << ", hash " << it->hash << ", new state " << it->state;
   }
@@ -1414,6 +1456,7 @@ bool WalletGreen::updateWalletTransactionInfo(size_t transactionId, const Crypto
   assert(r);
 
   if (updated) {
+    markTransactionChanged(transactionId);
     m_logger(DEBUGGING) << "Transaction updated, ID " << transactionId <<
       ", hash " << it->hash <<
       ", block " << it->blockHeight <<
@@ -1445,6 +1488,7 @@ size_t WalletGreen::insertBlockchainTransaction(const TransactionInformation& in
 
   size_t txId = index.size();
   index.push_back(std::move(tx));
+  markTransactionChanged(txId);
 
   m_logger(DEBUGGING) << "Transaction added, ID " << txId <<
     ", hash " << tx.hash <<
@@ -1581,6 +1625,7 @@ void WalletGreen::appendTransfer(size_t transactionId, size_t firstTransferIdx,
 
   WalletTransfer transfer{ WalletTransferType::USUAL, address, amount };
   m_transfers.emplace(insertIt, std::piecewise_construct, std::forward_as_tuple(transactionId), std::forward_as_tuple(transfer));
+  markTransactionChanged(transactionId);
 }
 
 bool WalletGreen::adjustTransfer(size_t transactionId, size_t firstTransferIdx, const std::string& address, int64_t amount) {
@@ -1617,6 +1662,10 @@ bool WalletGreen::adjustTransfer(size_t transactionId, size_t firstTransferIdx,
     updated = true;
   }
 
+  if (updated) {
+    markTransactionChanged(transactionId);
+  }
+
   return updated;
 }
 
@@ -1633,6 +1682,10 @@ bool WalletGreen::eraseTransfers(size_t transactionId, size_t firstTransferIdx,
     }
   }
 
+  if (erased) {
+    markTransactionChanged(transactionId);
+  }
+
   return erased;
 }
 
@@ -2032,6 +2085,125 @@ std::vector<Crypto::Hash> WalletGreen::getBlockHashes(uint32_t blockIndex, size_
   return std::vector<Crypto::Hash>(start, end);
 }
 
+bool WalletGreen::getBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
+  auto it = hashIndex.find(blockHash);
+  if (it == hashIndex.end()) {
+    return false;
+  }
+
+  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
+  blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
+  return true;
+}
+
+std::vector<TransactionsInBlockInfo> WalletGreen::findTransactions(uint32_t blockIndex, size_t count,
+  const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const {
+
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  if (count == 0) {
+    throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blocks count must be greater than zero");
+  }
+
+  std::vector<TransactionsInBlockInfo> result;
+  if (blockIndex >= m_blockchain.size()) {
+    return result;
+  }
+
+  uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
+  auto& transactionIdIndex = m_transactions.get<RandomAccessIndex>();
+
+  std::vector<size_t> candidates;
+  if (paymentId != nullptr) {
+    auto it = m_paymentIdTransactions.find(*paymentId);
+    if (it != m_paymentIdTransactions.end()) {
+      candidates.assign(it->second.begin(), it->second.end());
+    }
+  } else if (!addresses.empty()) {
+    std::set<size_t> addressTransactions;
+    for (const auto& address : addresses) {
+      auto it = m_addressTransactions.find(address);
+      if (it != m_addressTransactions.end()) {
+        addressTransactions.insert(it->second.begin(), it->second.end());
+      }
+    }
+
+    candidates.assign(addressTransactions.begin(), addressTransactions.end());
+  } else {
+    auto& blockHeightIndex = m_transactions.get<BlockHeightIndex>();
+    auto end = blockHeightIndex.lower_bound(stopIndex);
+    for (auto it = blockHeightIndex.lower_bound(blockIndex); it != end; ++it) {
+      candidates.push_back(std::distance(transactionIdIndex.begin(), m_transactions.project<RandomAccessIndex>(it)));
+    }
+  }
+
+  std::unordered_set<std::string> addressSet(addresses.begin(), addresses.end());
+  std::vector<std::pair<uint32_t, size_t>> matched;
+  for (size_t transactionId : candidates) {
+    const WalletTransaction& transaction = transactionIdIndex[transactionId];
+    if (transaction.state != WalletTransactionState::SUCCEEDED || transaction.blockHeight < blockIndex || transaction.blockHeight >= stopIndex) {
+      continue;
+    }
+
+    if (paymentId != nullptr) {
+      Crypto::Hash transactionPaymentId;
+      if (!getPaymentIdFromTxExtra(Common::asBinaryArray(transaction.extra), transactionPaymentId) || transactionPaymentId != *paymentId) {
+        continue;
+      }
+    }
+
+    if (!addressSet.empty()) {
+      auto bounds = getTransactionTransfersRange(transactionId);
+      bool haveAddress = std::any_of(bounds.first, bounds.second, [&addressSet](const TransactionTransferPair& pair) {
+        return addressSet.count(pair.second.address) != 0;
+      });
+
+      if (!haveAddress) {
+        continue;
+      }
+    }
+
+    matched.emplace_back(transaction.blockHeight, transactionId);
+  }
+
+  std::sort(matched.begin(), matched.end());
+
+  // Every block with a succeeded transaction gets an entry, empty if nothing matched, as filtering getTransactions() did
+  auto& blockHeightIndex = m_transactions.get<BlockHeightIndex>();
+  auto end = blockHeightIndex.lower_bound(stopIndex);
+  uint32_t lastHeight = 0;
+  for (auto it = blockHeightIndex.lower_bound(blockIndex); it != end; ++it) {
+    if (it->state == WalletTransactionState::SUCCEEDED && (result.empty() || lastHeight != it->blockHeight)) {
+      TransactionsInBlockInfo info;
+      info.blockHash = m_blockchain[it->blockHeight];
+      result.emplace_back(std::move(info));
+      lastHeight = it->blockHeight;
+    }
+  }
+
+  auto blockIt = result.begin();
+  for (const auto& heightAndId : matched) {
+    const Crypto::Hash& blockHash = m_blockchain[heightAndId.first];
+    while (blockIt->blockHash != blockHash) {
+      ++blockIt;
+    }
+
+    const WalletTransaction& walletTransaction = transactionIdIndex[heightAndId.second];
+
+    WalletTransactionWithTransfers transaction;
+    transaction.transaction = walletTransaction;
+    transaction.transfers = getTransactionTransfers(walletTransaction);
+    blockIt->transactions.emplace_back(std::move(transaction));
+  }
+
+  return result;
+}
+
 uint32_t WalletGreen::getBlockCount() const {
   throwIfNotInitialized();
   throwIfStopped();
@@ -2135,6 +2307,7 @@ void WalletGreen::onSynchronizationProgressUpdated(uint32_t processedBlockCount,
     return;
   }
 
+  m_synchronizerStateChanged = true;
   pushEvent(makeSyncProgressUpdatedEvent(processedBlockCount, totalBlockCount));
 
   uint32_t currentHeight = processedBlockCount - 1;
@@ -2165,6 +2338,7 @@ void WalletGreen::blocksAdded(const std::vector<Crypto::Hash>& blockHashes) {
   }
 
   m_blockchain.insert(m_blockchain.end(), blockHashes.begin(), blockHashes.end());
+  m_synchronizerStateChanged = true;
 }
 
 void WalletGreen::onBlockchainDetach(const Crypto::PublicKey& viewPublicKey, uint32_t blockIndex) {
@@ -2182,6 +2356,7 @@ void WalletGreen::blocksRollback(uint32_t blockIndex) {
 
   auto& blockHeightIndex = m_blockchain.get<BlockHeightIndex>();
   blockHeightIndex.erase(std::next(blockHeightIndex.begin(), blockIndex), blockHeightIndex.end());
+  m_synchronizerStateChanged = true;
 }
 
 void WalletGreen::onTransactionDeleteBegin(const Crypto::PublicKey& viewPublicKey, Crypto::Hash transactionHash) {
@@ -2258,6 +2433,8 @@ void WalletGreen::transactionUpdated(const TransactionInformation& transactionIn
     return;
   }
 
+  m_synchronizerStateChanged = true;
+
   bool updated = false;
   bool isNew = false;
 
@@ -2347,6 +2524,8 @@ void WalletGreen::transactionDeleted(ITransfersSubscription* object, const Hash&
     return;
   }
 
+  m_synchronizerStateChanged = true;
+
   auto it = m_transactions.get<TransactionIndex>().find(transactionHash);
   if (it == m_transactions.get<TransactionIndex>().end()) {
     return;
@@ -2371,6 +2550,7 @@ void WalletGreen::transactionDeleted(ITransfersSubscription* object, const Hash&
 
   if (updated) {
     auto transactionId = getTransactionId(transactionHash);
+    markTransactionChanged(transactionId);
     auto tx = m_transactions[transactionId];
     m_logger(INFO, BRIGHT_WHITE) << "Transaction deleted, ID " << transactionId <<
       ", hash " << transactionHash <<
@@ -2415,6 +2595,8 @@ void WalletGreen::addUnconfirmedTransaction(const ITransactionReader& transactio
   if (ec) {
     throw std::system_error(ec, "Failed to add unconfirmed transaction");
   }
+
+  m_synchronizerStateChanged = true;
 }
 
 void WalletGreen::removeUnconfirmedTransaction(const Crypto::Hash& transactionHash) {
@@ -2423,6 +2605,7 @@ void WalletGreen::removeUnconfirmedTransaction(const Crypto::Hash& transactionHa
   });
 
   context.get();
+  m_synchronizerStateChanged = true;
 }
 
 void WalletGreen::copyContainerStorageKeys(ContainerStorage& src, const chacha8_key& srcKey, ContainerStorage& dst, const chacha8_key& dstKey) {
@@ -2470,36 +2653,108 @@ void WalletGreen::deleteOrphanTransactions(const std::unordered_set<Crypto::Publ
   }
 }
 
-void WalletGreen::encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize) {
+void WalletGreen::loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData) {
+  Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
+  BinaryInputStreamSerializer suffixSerializer(suffixStream);
+  Crypto::chacha8_iv suffixIv;
+  BinaryArray encryptedContainer;
+  suffixSerializer(suffixIv, "suffixIv");
+  suffixSerializer(encryptedContainer, "encryptedContainer");
+
+  containerData.resize(encryptedContainer.size());
+  chacha8(encryptedContainer.data(), encryptedContainer.size(), key, suffixIv, reinterpret_cast<char*>(containerData.data()));
+}
+
+std::string WalletGreen::encryptContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records) {
   ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
 
-  Crypto::chacha8_iv suffixIv = prefix->nextIv;
-  incIv(prefix->nextIv);
+  std::string data;
+  Common::StringOutputStream stream(data);
+  BinaryOutputStreamSerializer serializer(stream);
 
-  BinaryArray encryptedContainer;
-  encryptedContainer.resize(containerDataSize);
-  chacha8(containerData, containerDataSize, key, suffixIv, reinterpret_cast<char*>(encryptedContainer.data()));
+  for (const auto& record : records) {
+    Crypto::chacha8_iv recordIv = prefix->nextIv;
+    incIv(prefix->nextIv);
 
-  std::string suffix;
-  Common::StringOutputStream suffixStream(suffix);
-  BinaryOutputStreamSerializer suffixSerializer(suffixStream);
-  suffixSerializer(suffixIv, "suffixIv");
-  suffixSerializer(encryptedContainer, "encryptedContainer");
+    BinaryArray encryptedRecord;
+    encryptedRecord.resize(record.second.size());
+    chacha8(record.second.data(), record.second.size(), key, recordIv, reinterpret_cast<char*>(encryptedRecord.data()));
+
+    // the checksum detects a record torn by an interrupted append
+    Crypto::Hash checksum = Crypto::cn_fast_hash(encryptedRecord.data(), encryptedRecord.size());
+    uint8_t recordType = static_cast<uint8_t>(record.first);
+
+    serializer(recordType, "recordType");
+    serializer(recordIv, "recordIv");
+    serializer(encryptedRecord, "encryptedRecord");
+    serializer(checksum, "checksum");
+  }
+
+  return data;
+}
+
+void WalletGreen::saveContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records, uint8_t version) {
+  ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
+  prefix->version = version;
 
+  std::string suffix = encryptContainerRecords(storage, key, records);
   storage.resizeSuffix(suffix.size());
   std::copy(suffix.begin(), suffix.end(), storage.suffix());
 }
 
-void WalletGreen::loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData) {
+void WalletGreen::appendContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records) {
+  assert(reinterpret_cast<const ContainerStoragePrefix*>(storage.prefix())->version >= WalletSerializerV2::RECORDS_MIN_VERSION);
+
+  // only the appended range is flushed, the IVs it uses are recovered by loadContainerRecords()
+  std::string data = encryptContainerRecords(storage, key, records);
+  storage.appendToSuffix(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+bool WalletGreen::loadContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, ContainerRecords& records) {
+  ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
+  if (prefix->version < WalletSerializerV2::RECORDS_MIN_VERSION) {
+    BinaryArray containerData;
+    loadAndDecryptContainerData(storage, key, containerData);
+    records.emplace_back(ContainerRecordType::SNAPSHOT, std::string(containerData.begin(), containerData.end()));
+    return true;
+  }
+
   Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
-  BinaryInputStreamSerializer suffixSerializer(suffixStream);
-  Crypto::chacha8_iv suffixIv;
-  BinaryArray encryptedContainer;
-  suffixSerializer(suffixIv, "suffixIv");
-  suffixSerializer(encryptedContainer, "encryptedContainer");
+  BinaryInputStreamSerializer serializer(suffixStream);
+  while (!suffixStream.endOfStream()) {
+    uint8_t recordType;
+    Crypto::chacha8_iv recordIv;
+    BinaryArray encryptedRecord;
+    Crypto::Hash checksum;
 
-  containerData.resize(encryptedContainer.size());
-  chacha8(encryptedContainer.data(), encryptedContainer.size(), key, suffixIv, reinterpret_cast<char*>(containerData.data()));
+    try {
+      serializer(recordType, "recordType");
+      serializer(recordIv, "recordIv");
+      serializer(encryptedRecord, "encryptedRecord");
+      serializer(checksum, "checksum");
+    } catch (const std::exception&) {
+      return false;
+    }
+
+    if (recordType > static_cast<uint8_t>(ContainerRecordType::SYNCHRONIZER_STATE_DELTA) ||
+        checksum != Crypto::cn_fast_hash(encryptedRecord.data(), encryptedRecord.size())) {
+      return false;
+    }
+
+    // the prefix isn't flushed with appended records, so the next IV may lag behind the ones already used
+    Crypto::chacha8_iv nextIv = recordIv;
+    incIv(nextIv);
+    if (*reinterpret_cast<const uint64_t*>(&nextIv) > *reinterpret_cast<const uint64_t*>(&prefix->nextIv)) {
+      prefix->nextIv = nextIv;
+    }
+
+    std::string record;
+    record.resize(encryptedRecord.size());
+    chacha8(encryptedRecord.data(), encryptedRecord.size(), key, recordIv, &record[0]);
+    records.emplace_back(static_cast<ContainerRecordType>(recordType), std::move(record));
+  }
+
+  return true;
 }
 
 void WalletGreen::initTransactionPool() {
@@ -2569,8 +2824,11 @@ void WalletGreen::loadContainerStorage(const std::string& path) {
 void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra) {
   assert(m_containerStorage.isOpened());
 
-  BinaryArray contanerData;
-  loadAndDecryptContainerData(m_containerStorage, m_key, contanerData);
+  ContainerRecords records;
+  bool recordsComplete = loadContainerRecords(m_containerStorage, m_key, records);
+  if (records.empty() || records.front().first != ContainerRecordType::SNAPSHOT) {
+    throw std::runtime_error("Container cache snapshot not found");
+  }
 
   WalletSerializerV2 s(
     *this,
@@ -2588,12 +2846,71 @@ void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKe
     m_transactionSoftLockTime
   );
 
-  Common::MemoryInputStream containerStream(contanerData.data(), contanerData.size());
-  s.load(containerStream, reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version);
+  uint8_t version = reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version;
+  Common::MemoryInputStream containerStream(records.front().second.data(), records.front().second.size());
+  s.load(containerStream, version);
+
+  // only the latest wallet and synchronizer state records matter, transaction records and synchronizer state deltas
+  // are applied in order
+  const std::string* walletState = nullptr;
+  const std::string* synchronizerState = nullptr;
+  std::string patchedSynchronizerState;
+  for (size_t i = 1; i < records.size(); ++i) {
+    if (records[i].first == ContainerRecordType::TRANSACTIONS) {
+      Common::MemoryInputStream recordStream(records[i].second.data(), records[i].second.size());
+      s.loadTransactionRecords(recordStream);
+    } else if (records[i].first == ContainerRecordType::WALLET_STATE) {
+      walletState = &records[i].second;
+    } else if (records[i].first == ContainerRecordType::SYNCHRONIZER_STATE) {
+      synchronizerState = &records[i].second;
+    } else if (records[i].first == ContainerRecordType::SYNCHRONIZER_STATE_DELTA) {
+      if (synchronizerState == nullptr) {
+        throw std::runtime_error("Container cache synchronizer state delta has no base");
+      }
+
+      std::string state;
+      WalletStateDelta::apply(*synchronizerState, records[i].second, state);
+      patchedSynchronizerState.swap(state);
+      synchronizerState = &patchedSynchronizerState;
+    } else {
+      throw std::runtime_error("Unknown container cache record");
+    }
+  }
+
+  s.applyLoadedTransfers();
+
+  if (synchronizerState != nullptr) {
+    Common::MemoryInputStream recordStream(synchronizerState->data(), synchronizerState->size());
+    s.loadSynchronizerState(recordStream);
+  }
+
+  if (walletState != nullptr) {
+    Common::MemoryInputStream recordStream(walletState->data(), walletState->size());
+    s.loadWalletState(recordStream);
+  }
+
   addedKeys = std::move(s.addedKeys());
   deletedKeys = std::move(s.deletedKeys());
 
-  m_logger(DEBUGGING) << "Container cache loaded";
+  if (!recordsComplete) {
+    m_logger(WARNING, BRIGHT_YELLOW) << "Container cache has a damaged tail, last changes are lost";
+  }
+
+  // old containers and damaged tails are rewritten by the next save
+  bool fullSaveRequired = !recordsComplete || version < WalletSerializerV2::SYNCHRONIZER_RECORD_MIN_VERSION;
+  resetContainerChanges(fullSaveRequired);
+  if (synchronizerState != nullptr) {
+    m_synchronizerStateDelta.setBase(*synchronizerState);
+  } else {
+    m_synchronizerStateDelta.reset();
+  }
+
+  m_containerSnapshotSize = records.front().second.size();
+  if (!fullSaveRequired && synchronizerState != nullptr) {
+    m_containerSnapshotSize += synchronizerState->size();
+  }
+
+  m_logger(DEBUGGING) << "Container cache loaded, " << records.size() - 1 << " incremental records applied";
 }
 
 void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra) {
@@ -2638,14 +2955,167 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
 
   s.save(containerStream, saveLevel);
 
-  encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
+  ContainerRecords records;
+  records.emplace_back(ContainerRecordType::SNAPSHOT, std::move(containerData));
+
+  // a separate record is the base of synchronizer state deltas appended by later saves
+  std::string synchronizerState;
+  if (saveLevel == WalletSaveLevel::SAVE_ALL) {
+    Common::StringOutputStream synchronizerStateStream(synchronizerState);
+    s.saveSynchronizerState(synchronizerStateStream);
+    records.emplace_back(ContainerRecordType::SYNCHRONIZER_STATE, synchronizerState);
+  }
+
+  saveContainerRecords(storage, key, records, WalletSerializerV2::SERIALIZATION_VERSION);
   storage.flush();
 
+  if (&storage == &m_containerStorage) {
+    m_containerSnapshotSize = 0;
+    for (const auto& record : records) {
+      m_containerSnapshotSize += record.second.size();
+    }
+
+    if (saveLevel == WalletSaveLevel::SAVE_ALL) {
+      m_synchronizerStateDelta.setBase(synchronizerState);
+    } else {
+      m_synchronizerStateDelta.reset();
+    }
+  }
+
   m_extra = extra;
 
   m_logger(DEBUGGING) << "Container saving finished";
 }
 
+bool WalletGreen::saveWalletCacheChanges(const std::string& extra) {
+  WalletSerializerV2 s(
+    *this,
+    m_viewPublicKey,
+    m_viewSecretKey,
+    m_actualBalance,
+    m_pendingBalance,
+    m_walletsContainer,
+    m_synchronizer,
+    m_unlockTransactionsJob,
+    m_transactions,
+    m_transfers,
+    m_uncommitedTransactions,
+    const_cast<std::string&>(extra),
+    m_transactionSoftLockTime
+  );
+
+  ContainerRecords records;
+  std::string synchronizerState;
+
+  // All records are captured while blockchain synchronizer is stopped, so they describe the same state.
+  // They are captured in memory, so synchronization is paused only for serialization
+  stopBlockchainSynchronizer();
+
+  try {
+    if (!m_changedTransactions.empty()) {
+      std::vector<size_t> transactionIds(m_changedTransactions.begin(), m_changedTransactions.end());
+      std::sort(transactionIds.begin(), transactionIds.end());
+
+      records.emplace_back(ContainerRecordType::TRANSACTIONS, std::string());
+      Common::StringOutputStream stream(records.back().second);
+      s.saveTransactionRecords(stream, transactionIds);
+    }
+
+    records.emplace_back(ContainerRecordType::WALLET_STATE, std::string());
+    Common::StringOutputStream walletStateStream(records.back().second);
+    s.saveWalletState(walletStateStream);
+
+    if (m_synchronizerStateChanged) {
+      Common::StringOutputStream synchronizerStateStream(synchronizerState);
+      s.saveSynchronizerState(synchronizerStateStream);
+    }
+  } catch (const std::exception&) {
+    startBlockchainSynchronizer();
+    throw;
+  }
+
+  startBlockchainSynchronizer();
+
+  if (m_synchronizerStateChanged) {
+    // Most of the synchronizer state (block hashes, transfers) stays the same between saves, so only its changes
+    // are appended. A full record is written when there is nothing to refer to or the changes are too big
+    std::string delta;
+    if (!m_synchronizerStateDelta.hasBase()) {
+      m_synchronizerStateDelta.setBase(synchronizerState);
+      records.emplace_back(ContainerRecordType::SYNCHRONIZER_STATE, std::move(synchronizerState));
+    } else if (m_synchronizerStateDelta.encode(synchronizerState, delta)) {
+      if (delta.size() < synchronizerState.size() / 2) {
+        records.emplace_back(ContainerRecordType::SYNCHRONIZER_STATE_DELTA, std::move(delta));
+      } else {
+        records.emplace_back(ContainerRecordType::SYNCHRONIZER_STATE, std::move(synchronizerState));
+      }
+    }
+  }
+
+  uint64_t recordsSize = 0;
+  for (const auto& record : records) {
+    recordsSize += record.second.size();
+  }
+
+  // Compact the container when incremental records outgrow the snapshot
+  if (m_containerStorage.suffixSize() + recordsSize > 2 * m_containerSnapshotSize) {
+    m_logger(DEBUGGING) << "Container incremental records exceed snapshot size, rewrite container";
+    return false;
+  }
+
+  appendContainerRecords(m_containerStorage, m_key, records);
+
+  m_logger(DEBUGGING) << "Container changes saved, transactions " << m_changedTransactions.size() << ", size " << recordsSize;
+
+  m_extra = extra;
+  m_changedTransactions.clear();
+  m_synchronizerStateChanged = false;
+
+  return true;
+}
+
+void WalletGreen::markTransactionChanged(size_t transactionId) {
+  indexTransaction(transactionId);
+
+  if (!m_fullSaveRequired) {
+    m_changedTransactions.insert(transactionId);
+  }
+}
+
+void WalletGreen::indexTransaction(size_t transactionId) {
+  const WalletTransaction& transaction = m_transactions.get<RandomAccessIndex>()[transactionId];
+
+  Crypto::Hash paymentId;
+  if (getPaymentIdFromTxExtra(Common::asBinaryArray(transaction.extra), paymentId)) {
+    m_paymentIdTransactions[paymentId].insert(transactionId);
+  }
+
+  auto bounds = getTransactionTransfersRange(transactionId);
+  for (auto it = bounds.first; it != bounds.second; ++it) {
+    if (!it->second.address.empty()) {
+      m_addressTransactions[it->second.address].insert(transactionId);
+    }
+  }
+}
+
+void WalletGreen::rebuildTransactionIndices() {
+  m_paymentIdTransactions.clear();
+  m_addressTransactions.clear();
+
+  for (size_t transactionId = 0; transactionId < m_transactions.size(); ++transactionId) {
+    indexTransaction(transactionId);
+  }
+
+  m_logger(DEBUGGING) << "Transaction indices built, payment ids " << m_paymentIdTransactions.size() <<
+    ", addresses " << m_addressTransactions.size();
+}
+
+void WalletGreen::resetContainerChanges(bool fullSaveRequired) {
+  m_changedTransactions.clear();
+  m_fullSaveRequired = fullSaveRequired;
+  m_synchronizerStateChanged = false;
+}
+
 void WalletGreen::subscribeWallets() {
   try {
     auto& index = m_walletsContainer.get<RandomAccessIndex>();
@@ -3236,6 +3706,8 @@ std::vector<size_t> WalletGreen::deleteTransfersForAddress(const std::string& ad
         updatedTransactions.push_back(transactionId);
       }
 
+      markTransactionChanged(transactionId);
+
       //reset values for next transaction
       deletedInputs = 0;
       deletedOutputs = 0;
@@ -3,10 +3,13 @@
 #include "IWallet.h"
 
 #include <queue>
+#include <set>
 #include <unordered_map>
 
 #include "IFusionManager.h"
+#include "IWalletTransactionsQuery.h"
 #include "WalletIndices.h"
+#include "WalletStateDelta.h"
 
 #include <System/Dispatcher.h>
 #include <System/Event.h>
@@ -21,7 +24,8 @@ class WalletGreen : public IWallet,
                     ITransfersObserver,
                     IBlockchainSynchronizerObserver,
                     ITransfersSynchronizerObserver,
-                    public IFusionManager {
+                    public IFusionManager,
+                    public IWalletTransactionsQuery {
 public:
   WalletGreen(System::Dispatcher& dispatcher, const Currency& currency, INode& node, Logging::ILogger& logger, uint32_t transactionSoftLockTime = 1);
   virtual ~WalletGreen();
@@ -79,6 +83,10 @@ public:
   virtual bool isFusionTransaction(size_t transactionId) const override;
   virtual IFusionManager::EstimateResult estimate(uint64_t threshold, const std::vector<std::string>& sourceAddresses = {}) const override;
 
+  virtual bool getBlockIndex(const Crypto::Hash& blockHash, uint32_t& blockIndex) const override;
+  virtual std::vector<TransactionsInBlockInfo> findTransactions(uint32_t blockIndex, size_t count,
+    const std::vector<std::string>& addresses, const Crypto::Hash* paymentId) const override;
+
 protected:
   void throwIfNotInitialized() const;
   void throwIfStopped() const;
@@ -139,6 +147,19 @@ uint64_t& creationTimestamp, const Crypto::chacha8_key& key);
   };
   #pragma pack(pop)
 
+  // Container cache is stored in the storage suffix as a sequence of separately encrypted records.
+  // A full save writes a single snapshot, later saves append records changed since then.
+  enum class ContainerRecordType : uint8_t {
+    SNAPSHOT = 0,
+    TRANSACTIONS = 1,
+    WALLET_STATE = 2,
+    SYNCHRONIZER_STATE = 3,
+    // changes of the synchronizer state since the previous full or delta synchronizer state record
+    SYNCHRONIZER_STATE_DELTA = 4
+  };
+
+  typedef std::vector<std::pair<ContainerRecordType, std::string>> ContainerRecords;
+
   typedef std::unordered_map<std::string, AddressAmounts> TransfersMap;
 
   virtual void onError(ITransfersSubscription* object, uint32_t height, std::error_code ec) override;
@@ -268,13 +289,21 @@ uint64_t& creationTimestamp, const Crypto::chacha8_key& key);
   static void copyContainerStorageKeys(ContainerStorage& src, const Crypto::chacha8_key& srcKey, ContainerStorage& dst, const Crypto::chacha8_key& dstKey);
   static void copyContainerStoragePrefix(ContainerStorage& src, const Crypto::chacha8_key& srcKey, ContainerStorage& dst, const Crypto::chacha8_key& dstKey);
   void deleteOrphanTransactions(const std::unordered_set<Crypto::PublicKey>& deletedKeys);
-  static void encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize);
   static void loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData);
+  static std::string encryptContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records);
+  static void saveContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records, uint8_t version);
+  static void appendContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, const ContainerRecords& records);
+  static bool loadContainerRecords(ContainerStorage& storage, const Crypto::chacha8_key& key, ContainerRecords& records);
   void initTransactionPool();
   void loadSpendKeys();
   void loadContainerStorage(const std::string& path);
   void loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra);
   void saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra);
+  bool saveWalletCacheChanges(const std::string& extra);
+  void markTransactionChanged(size_t transactionId);
+  void indexTransaction(size_t transactionId);
+  void rebuildTransactionIndices();
+  void resetContainerChanges(bool fullSaveRequired);
   void subscribeWallets();
 
   std::vector<OutputToTransfer> pickRandomFusionInputs(const std::vector<std::string>& addresses,
@@ -320,6 +349,9 @@ uint64_t& creationTimestamp, const Crypto::chacha8_key& key);
   WalletTransactions m_transactions;
   WalletTransfers m_transfers; //sorted
   mutable std::unordered_map<size_t, bool> m_fusionTxsCache; // txIndex -> isFusion
+  // Transactions are never removed from these indices until caches are cleared, query results are checked against transaction data
+  std::unordered_map<Crypto::Hash, std::set<size_t>> m_paymentIdTransactions;
+  std::unordered_map<std::string, std::set<size_t>> m_addressTransactions;
   UncommitedTransactions m_uncommitedTransactions;
 
   bool m_blockchainSynchronizerStarted;
@@ -337,6 +369,12 @@ uint64_t& creationTimestamp, const Crypto::chacha8_key& key);
   std::string m_path;
   std::string m_extra; // workaround for wallet reset
 
+  std::unordered_set<size_t> m_changedTransactions; // saved by the next incremental save
+  bool m_fullSaveRequired;
+  bool m_synchronizerStateChanged;
+  WalletStateDelta m_synchronizerStateDelta; // base is the synchronizer state stored by the last record
+  uint64_t m_containerSnapshotSize;
+
   Crypto::PublicKey m_viewPublicKey;
   Crypto::SecretKey m_viewSecretKey;
 
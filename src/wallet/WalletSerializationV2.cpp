@@ -1,5 +1,7 @@
 #include "WalletSerializationV2.h"
 
+#include <algorithm>
+
 #include "base/CryptoNoteSerialization.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
@@ -140,7 +142,10 @@ void WalletSerializerV2::load(Common::IInputStream& source, uint8_t version) {
   }
 
   if (saveLevel == WalletSaveLevel::SAVE_ALL) {
-    loadTransfersSynchronizer(s);
+    if (version < SYNCHRONIZER_RECORD_MIN_VERSION) {
+      loadTransfersSynchronizer(s);
+    }
+
     loadUnlockTransactionsJobs(s);
     s(m_uncommitedTransactions, "uncommitedTransactions");
   }
@@ -161,8 +166,8 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
     saveTransfers(s);
   }
 
+  // transfers synchronizer state is saved by saveSynchronizerState()
   if (saveLevel == WalletSaveLevel::SAVE_ALL) {
-    saveTransfersSynchronizer(s);
     saveUnlockTransactionsJobs(s);
     s(m_uncommitedTransactions, "uncommitedTransactions");
   }
@@ -170,6 +175,167 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
   s(m_extra, "extra");
 }
 
+void WalletSerializerV2::saveTransactionRecords(Common::IOutputStream& destination, const std::vector<size_t>& transactionIds) {
+  CryptoNote::BinaryOutputStreamSerializer s(destination);
+
+  auto& index = m_transactions.get<RandomAccessIndex>();
+  uint64_t count = transactionIds.size();
+  s(count, "transactionCount");
+
+  for (size_t transactionId : transactionIds) {
+    assert(transactionId < index.size());
+    WalletTransactionDtoV2 dto(index[transactionId]);
+    s(dto, "transaction");
+
+    auto bounds = std::equal_range(m_transfers.begin(), m_transfers.end(), TransactionTransferPair{ transactionId, WalletTransfer() },
+      [](const TransactionTransferPair& a, const TransactionTransferPair& b) {
+        return a.first < b.first;
+      });
+
+    uint64_t transferCount = std::distance(bounds.first, bounds.second);
+    s(transferCount, "transferCount");
+    for (auto it = bounds.first; it != bounds.second; ++it) {
+      WalletTransferDtoV2 tr(it->second);
+      s(tr, "transfer");
+    }
+  }
+}
+
+void WalletSerializerV2::loadTransactionRecords(Common::IInputStream& source) {
+  CryptoNote::BinaryInputStreamSerializer s(source);
+
+  auto& index = m_transactions.get<RandomAccessIndex>();
+  auto& hashIndex = m_transactions.get<TransactionIndex>();
+
+  uint64_t count = 0;
+  s(count, "transactionCount");
+
+  for (uint64_t i = 0; i < count; ++i) {
+    WalletTransactionDtoV2 dto;
+    s(dto, "transaction");
+
+    WalletTransaction tx;
+    tx.state = dto.state;
+    tx.timestamp = dto.timestamp;
+    tx.blockHeight = dto.blockHeight;
+    tx.hash = dto.hash;
+    tx.totalAmount = dto.totalAmount;
+    tx.fee = dto.fee;
+    tx.creationTime = dto.creationTime;
+    tx.unlockTime = dto.unlockTime;
+    tx.extra = dto.extra;
+    tx.isBase = dto.isBase;
+
+    size_t transactionId;
+    auto it = hashIndex.find(tx.hash);
+    if (it == hashIndex.end()) {
+      transactionId = index.size();
+      index.push_back(std::move(tx));
+    } else {
+      transactionId = std::distance(index.begin(), m_transactions.project<RandomAccessIndex>(it));
+      hashIndex.replace(it, std::move(tx));
+    }
+
+    uint64_t transferCount = 0;
+    s(transferCount, "transferCount");
+
+    std::vector<WalletTransfer>& transfers = m_loadedTransfers[transactionId];
+    transfers.clear();
+    for (uint64_t j = 0; j < transferCount; ++j) {
+      WalletTransferDtoV2 dto;
+      s(dto, "transfer");
+
+      WalletTransfer tr;
+      tr.address = dto.address;
+      tr.amount = dto.amount;
+      tr.type = static_cast<WalletTransferType>(dto.type);
+      transfers.emplace_back(std::move(tr));
+    }
+  }
+}
+
+void WalletSerializerV2::applyLoadedTransfers() {
+  if (m_loadedTransfers.empty()) {
+    return;
+  }
+
+  m_transfers.erase(std::remove_if(m_transfers.begin(), m_transfers.end(), [this](const TransactionTransferPair& pair) {
+    return m_loadedTransfers.count(pair.first) != 0;
+  }), m_transfers.end());
+
+  for (auto& kv : m_loadedTransfers) {
+    for (auto& transfer : kv.second) {
+      m_transfers.emplace_back(kv.first, std::move(transfer));
+    }
+  }
+
+  std::stable_sort(m_transfers.begin(), m_transfers.end(), [](const TransactionTransferPair& a, const TransactionTransferPair& b) {
+    return a.first < b.first;
+  });
+
+  m_loadedTransfers.clear();
+}
+
+void WalletSerializerV2::saveWalletState(Common::IOutputStream& destination) {
+  CryptoNote::BinaryOutputStreamSerializer s(destination);
+
+  saveKeyListAndBanalces(s, true);
+  saveUnlockTransactionsJobs(s);
+
+  // uncommited transactions are stored by hash, their indexes can change after a full save
+  auto& index = m_transactions.get<RandomAccessIndex>();
+  uint64_t uncommitedCount = m_uncommitedTransactions.size();
+  s(uncommitedCount, "uncommitedTransactionCount");
+  for (auto& kv : m_uncommitedTransactions) {
+    assert(kv.first < index.size());
+    Crypto::Hash hash = index[kv.first].hash;
+    s(hash, "hash");
+    s(kv.second, "transaction");
+  }
+
+  s(m_extra, "extra");
+}
+
+void WalletSerializerV2::loadWalletState(Common::IInputStream& source) {
+  CryptoNote::BinaryInputStreamSerializer s(source);
+
+  loadKeyListAndBanalces(s, true);
+
+  m_unlockTransactions.clear();
+  loadUnlockTransactionsJobs(s);
+
+  auto& index = m_transactions.get<RandomAccessIndex>();
+  auto& hashIndex = m_transactions.get<TransactionIndex>();
+  m_uncommitedTransactions.clear();
+
+  uint64_t uncommitedCount = 0;
+  s(uncommitedCount, "uncommitedTransactionCount");
+  for (uint64_t i = 0; i < uncommitedCount; ++i) {
+    Crypto::Hash hash;
+    Transaction transaction;
+    s(hash, "hash");
+    s(transaction, "transaction");
+
+    auto it = hashIndex.find(hash);
+    if (it != hashIndex.end()) {
+      size_t transactionId = std::distance(index.begin(), m_transactions.project<RandomAccessIndex>(it));
+      m_uncommitedTransactions.emplace(transactionId, std::move(transaction));
+    }
+  }
+
+  s(m_extra, "extra");
+}
+
+void WalletSerializerV2::saveSynchronizerState(Common::IOutputStream& destination) {
+  CryptoNote::BinaryOutputStreamSerializer s(destination);
+  saveTransfersSynchronizer(s);
+}
+
+void WalletSerializerV2::loadSynchronizerState(Common::IInputStream& source) {
+  CryptoNote::BinaryInputStreamSerializer s(source);
+  loadTransfersSynchronizer(s);
+}
+
 std::unordered_set<Crypto::PublicKey>& WalletSerializerV2::addedKeys() {
   return m_addedKeys;
 }
@@ -29,11 +29,28 @@ public:
   void load(Common::IInputStream& source, uint8_t version);
   void save(Common::IOutputStream& destination, WalletSaveLevel saveLevel);
 
+  // Incremental records appended to a container after a full save.
+  // Transactions are matched by hash, so records stay valid when a full save drops deleted transactions.
+  void saveTransactionRecords(Common::IOutputStream& destination, const std::vector<size_t>& transactionIds);
+  void loadTransactionRecords(Common::IInputStream& source);
+  // Must be called once after the last loadTransactionRecords()
+  void applyLoadedTransfers();
+
+  void saveWalletState(Common::IOutputStream& destination);
+  void loadWalletState(Common::IInputStream& source);
+
+  void saveSynchronizerState(Common::IOutputStream& destination);
+  void loadSynchronizerState(Common::IInputStream& source);
+
   std::unordered_set<Crypto::PublicKey>& addedKeys();
   std::unordered_set<Crypto::PublicKey>& deletedKeys();
 
   static const uint8_t MIN_VERSION = 6;
-  static const uint8_t SERIALIZATION_VERSION = 6;
+  // Version 7 stores the container cache as a sequence of encrypted records instead of a single blob,
+  // version 8 stores the transfers synchronizer state in its own record after the snapshot
+  static const uint8_t SERIALIZATION_VERSION = 8;
+  static const uint8_t RECORDS_MIN_VERSION = 7;
+  static const uint8_t SYNCHRONIZER_RECORD_MIN_VERSION = 8;
 
 private:
   void loadKeyListAndBanalces(CryptoNote::ISerializer& serializer, bool saveCache);
@@ -65,6 +82,7 @@ private:
 
   std::unordered_set<Crypto::PublicKey> m_addedKeys;
   std::unordered_set<Crypto::PublicKey> m_deletedKeys;
+  std::unordered_map<size_t, std::vector<WalletTransfer>> m_loadedTransfers;
 };
 
 } //namespace CryptoNote
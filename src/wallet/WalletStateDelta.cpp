@@ -0,0 +1,213 @@
+#include "WalletStateDelta.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "common/StringOutputStream.h"
+#include "common/MemoryInputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// boundaries are where the low bits of a rolling hash are zero, average chunk is 8 KiB
+const size_t MIN_CHUNK_SIZE = 2 * 1024;
+const size_t MAX_CHUNK_SIZE = 64 * 1024;
+const uint64_t BOUNDARY_MASK = 8 * 1024 - 1;
+
+enum DeltaOperation : uint8_t {
+  COPY = 0,
+  LITERAL = 1
+};
+
+struct GearTable {
+  GearTable() {
+    // any fixed random values will do, they only have to be the same for the whole process
+    uint64_t seed = 0x9E3779B97F4A7C15;
+    for (size_t i = 0; i < 256; ++i) {
+      seed += 0x9E3779B97F4A7C15;
+      uint64_t value = seed;
+      value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+      value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+      values[i] = value ^ (value >> 31);
+    }
+  }
+
+  uint64_t values[256];
+};
+
+const GearTable& gearTable() {
+  static GearTable table;
+  return table;
+}
+
+}
+
+WalletStateDelta::WalletStateDelta() : m_baseSize(0), m_hasBase(false) {
+}
+
+template<typename F>
+void WalletStateDelta::forEachChunk(const std::string& state, F&& f) {
+  const uint64_t* gear = gearTable().values;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(state.data());
+  size_t chunkStart = 0;
+  uint64_t rollingHash = 0;
+  for (size_t i = 0; i < state.size(); ++i) {
+    rollingHash = (rollingHash << 1) + gear[data[i]];
+    size_t chunkSize = i + 1 - chunkStart;
+    if ((chunkSize >= MIN_CHUNK_SIZE && (rollingHash & BOUNDARY_MASK) == 0) || chunkSize == MAX_CHUNK_SIZE) {
+      f(chunkStart, chunkSize);
+      chunkStart = i + 1;
+      rollingHash = 0;
+    }
+  }
+
+  if (chunkStart < state.size()) {
+    f(chunkStart, state.size() - chunkStart);
+  }
+}
+
+void WalletStateDelta::reset() {
+  m_chunks.clear();
+  m_baseSize = 0;
+  m_hasBase = false;
+}
+
+void WalletStateDelta::setBase(const std::string& state) {
+  m_chunks.clear();
+  forEachChunk(state, [&](size_t offset, size_t size) {
+    ChunkLocation location = { offset, size };
+    m_chunks.emplace(Crypto::cn_fast_hash(state.data() + offset, size), location);
+  });
+
+  m_baseSize = state.size();
+  m_hasBase = true;
+}
+
+bool WalletStateDelta::hasBase() const {
+  return m_hasBase;
+}
+
+bool WalletStateDelta::encode(const std::string& state, std::string& delta) {
+  // adjacent chunks copied from adjacent places of the base are merged into one operation
+  std::string operations;
+  Common::StringOutputStream operationStream(operations);
+  BinaryOutputStreamSerializer operationSerializer(operationStream);
+  uint64_t operationCount = 0;
+  uint64_t copyOffset = 0;
+  uint64_t copySize = 0;
+  uint64_t literalOffset = 0;
+  uint64_t literalSize = 0;
+
+  auto flushCopy = [&] {
+    if (copySize != 0) {
+      uint8_t operation = COPY;
+      operationSerializer(operation, "operation");
+      operationSerializer(copyOffset, "offset");
+      operationSerializer(copySize, "size");
+      ++operationCount;
+      copySize = 0;
+    }
+  };
+
+  auto flushLiteral = [&] {
+    if (literalSize != 0) {
+      uint8_t operation = LITERAL;
+      std::string literal = state.substr(static_cast<size_t>(literalOffset), static_cast<size_t>(literalSize));
+      operationSerializer(operation, "operation");
+      operationSerializer(literal, "data");
+      ++operationCount;
+      literalSize = 0;
+    }
+  };
+
+  // chunks of the state become the base of the next delta, each chunk is hashed once
+  std::unordered_map<Crypto::Hash, ChunkLocation> chunks;
+  forEachChunk(state, [&](size_t offset, size_t size) {
+    Crypto::Hash chunkHash = Crypto::cn_fast_hash(state.data() + offset, size);
+    ChunkLocation location = { offset, size };
+    chunks.emplace(chunkHash, location);
+
+    auto it = m_chunks.find(chunkHash);
+    if (it == m_chunks.end()) {
+      flushCopy();
+      if (literalSize == 0) {
+        literalOffset = offset;
+      }
+
+      literalSize += size;
+    } else {
+      flushLiteral();
+      if (copySize != 0 && copyOffset + copySize == it->second.offset) {
+        copySize += it->second.size;
+      } else {
+        flushCopy();
+        copyOffset = it->second.offset;
+        copySize = it->second.size;
+      }
+    }
+  });
+
+  // an unchanged state is a single copy of the whole base
+  bool unchanged = m_hasBase && operationCount == 0 && literalSize == 0 && copyOffset == 0 && copySize == m_baseSize &&
+    state.size() == m_baseSize;
+  flushCopy();
+  flushLiteral();
+
+  m_chunks.swap(chunks);
+  m_baseSize = state.size();
+  m_hasBase = true;
+  if (unchanged) {
+    return false;
+  }
+
+  delta.clear();
+  Common::StringOutputStream deltaStream(delta);
+  BinaryOutputStreamSerializer deltaSerializer(deltaStream);
+  uint64_t stateSize = state.size();
+  deltaSerializer(stateSize, "stateSize");
+  deltaSerializer(operationCount, "operationCount");
+  delta.append(operations);
+  return true;
+}
+
+void WalletStateDelta::apply(const std::string& base, const std::string& delta, std::string& state) {
+  Common::MemoryInputStream stream(delta.data(), delta.size());
+  BinaryInputStreamSerializer serializer(stream);
+  uint64_t stateSize;
+  uint64_t operationCount;
+  serializer(stateSize, "stateSize");
+  serializer(operationCount, "operationCount");
+
+  state.clear();
+  state.reserve(static_cast<size_t>(std::min<uint64_t>(stateSize, base.size() + delta.size())));
+  for (uint64_t i = 0; i < operationCount; ++i) {
+    uint8_t operation;
+    serializer(operation, "operation");
+    if (operation == COPY) {
+      uint64_t offset;
+      uint64_t size;
+      serializer(offset, "offset");
+      serializer(size, "size");
+      if (offset > base.size() || size > base.size() - offset) {
+        throw std::runtime_error("State delta refers outside of its base");
+      }
+
+      state.append(base, static_cast<size_t>(offset), static_cast<size_t>(size));
+    } else if (operation == LITERAL) {
+      std::string literal;
+      serializer(literal, "data");
+      state.append(literal);
+    } else {
+      throw std::runtime_error("Unknown state delta operation");
+    }
+  }
+
+  if (state.size() != stateSize) {
+    throw std::runtime_error("State delta size mismatch");
+  }
+}
+
+}
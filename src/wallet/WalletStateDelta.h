@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Encodes a serialized state as a delta against the previously encoded one.
+// A state is cut into chunks at content defined boundaries, so bytes inserted or removed in the middle change only
+// the chunks around them; chunks found in the previous state are stored as references to their offset in it.
+class WalletStateDelta {
+public:
+  WalletStateDelta();
+
+  // forgets the previous state, encode() needs a base again
+  void reset();
+  // makes a state stored elsewhere, e.g. a loaded one, the base of the next delta
+  void setBase(const std::string& state);
+  bool hasBase() const;
+  // returns false if the state equals the base, otherwise writes the delta and makes the state the new base
+  bool encode(const std::string& state, std::string& delta);
+
+  // throws std::runtime_error if the delta doesn't belong to the base
+  static void apply(const std::string& base, const std::string& delta, std::string& state);
+
+private:
+  struct ChunkLocation {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  template<typename F>
+  static void forEachChunk(const std::string& state, F&& f);
+
+  std::unordered_map<Crypto::Hash, ChunkLocation> m_chunks;
+  uint64_t m_baseSize;
+  bool m_hasBase;
+};
+
+}